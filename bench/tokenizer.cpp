@@ -0,0 +1,91 @@
+/**
+ * cu::string::tokenize() against split() and a byte-at-a-time loop writing the same
+ * Token output, on OBJ-like text (face and vertex lines, 4M lines, about 120 MB).
+ * Also times find_first_of() over text with no delimiter. Best of 5, in ms
+ *
+ *   tokenizer_bench [lines]
+ */
+#include "string/split.hpp"
+#include "string/tokenizer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace cu::string;
+
+namespace {
+
+constexpr int repeats = 5;
+
+template <typename Fn>
+double best_ms(Fn fn)
+{
+	double best = 1e300;
+	for (int i = 0; i < repeats; ++i)
+	{
+		auto start = std::chrono::steady_clock::now();
+		fn();
+		auto end = std::chrono::steady_clock::now();
+		best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+	}
+	return best;
+}
+
+/** The scalar reference: one contains() per byte */
+std::size_t byte_loop(std::string_view str, const Delimiters& delimiters, std::vector<Token>& out)
+{
+	out.clear();
+	std::size_t i = 0, n = str.size();
+	while (i < n)
+	{
+		while (i < n && delimiters.contains(str[i]))
+			++i;
+		std::size_t begin = i;
+		while (i < n && !delimiters.contains(str[i]))
+			++i;
+		if (i > begin)
+			out.push_back({begin, i});
+	}
+	return out.size();
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	const long lines = argc > 1 ? std::atol(argv[1]) : 4000000;
+
+	std::string text;
+	for (long i = 0; i < lines / 2; ++i)
+		text += "f 1/2/3 4/5/6 7/8/9 10/11/12\nv 0.125000 -1.500000 42.000000\n";
+	std::printf("%.1f MB, %ld lines\n", text.size() / 1e6, lines);
+
+	std::vector<Token> tokens;
+	std::vector<std::string_view> views;
+	std::size_t count = 0;
+
+	const Delimiters space(" ");
+	double split_strings = best_ms([&] { count = split(text, ' ').size(); });
+	double split_views = best_ms([&] { split(std::string_view(text), ' ', views); });
+	double loop_space = best_ms([&] { byte_loop(text, space, tokens); });
+	double simd_space = best_ms([&] { tokenize(text, space, tokens); });
+	std::printf("split on ' ':  split() %.1f, split() to views %.1f, byte loop %.1f, tokenize %.1f (%zu tokens, %.1fx byte loop, %.1fx split())\n",
+		split_strings, split_views, loop_space, simd_space, count, loop_space / simd_space, split_strings / simd_space);
+
+	const Delimiters six(" \t\r\n/,");
+	double loop_six = best_ms([&] { byte_loop(text, six, tokens); });
+	double simd_six = best_ms([&] { count = tokenize(text, six, tokens); });
+	std::printf("6 delimiters:  byte loop %.1f, tokenize %.1f (%zu tokens, %.1fx)\n", loop_six, simd_six, count, loop_six / simd_six);
+
+	const std::string plain(text.size(), 'x');
+	std::size_t found = 0;
+	double scan = best_ms([&] { found = find_first_of(plain, six); });
+	std::printf("no match scan: find_first_of %.1f, %.1f GB/s%s\n", scan, plain.size() / scan / 1e6, found == std::string_view::npos ? "" : " (found?)");
+
+	return 0;
+}
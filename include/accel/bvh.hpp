@@ -0,0 +1,255 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "math.hpp"
+#include "return.hpp"
+
+namespace cu::accel {
+
+/**
+ * Binned SAH builder settings
+ * https://www.sci.utah.edu/~wald/Publications/2007/ParallelBVHBuild/fastbuild.pdf
+ */
+struct BuildOptions
+{
+	int		bins = 16;
+	int		max_leaf_size = 8;		// nodes above this size are always split
+	float	traversal_cost = 1.0f;	// SAH cost of one node visit, relative to one primitive test
+	bool	parallel = true;		// build subtrees on separate threads
+	bool	bvh4 = false;			// also collapse the tree to 4-wide nodes for traversal
+};
+
+/**
+ * 32 bytes, two nodes per cache line
+ * interior: count == 0, children are left_first and left_first + 1
+ * leaf:     count > 0, primitives are [left_first, left_first + count) in leaf order
+ */
+struct BVHNode
+{
+	math::vec3		min;
+	std::uint32_t	left_first;
+	math::vec3		max;
+	std::uint32_t	count;
+
+	inline bool is_leaf() const { return count > 0; }
+};
+
+/**
+ * 4 children with their boxes in SoA form, tested with one aabb4 ray test
+ * child[i]: node index (count[i] == 0) or first leaf-order primitive (count[i] > 0)
+ * unused slots have an empty box and never hit
+ */
+struct alignas(64) BVH4Node
+{
+	float			min[3][4];
+	float			max[3][4];
+	std::uint32_t	child[4];
+	std::uint32_t	count[4];
+};
+
+struct Hit
+{
+	float			t = std::numeric_limits<float>::infinity();
+	float			u = 0.0f, v = 0.0f;
+	std::uint32_t	prim = invalid;
+
+	static constexpr std::uint32_t invalid = ~0u;
+
+	inline bool valid() const { return prim != invalid; }
+};
+
+/**
+ * Bounding volume hierarchy over triangles or boxes
+ *
+ * Triangle scenes keep their own copy of the vertices in leaf order, so intersect()
+ * and occluded() work out of the box. Box scenes go through traverse() with a
+ * caller-provided primitive test.
+ *
+ * refit() updates the boxes after the vertices moved (skinning, rigid animation under
+ * a mat4) without changing the topology, tree quality degrades with large motion
+ */
+class BVH
+{
+public:
+	/** Build depth is bounded so traversal can use a fixed stack */
+	static constexpr int max_depth = 64;
+	static constexpr int max_stack_depth = 3 * max_depth + 4;
+
+	BVH() = default;
+
+	Result	build(std::span<const math::aabb> boxes, const BuildOptions& options = {});
+	Result	build(std::span<const math::vec3> vertices, std::span<const std::uint32_t> indices, const BuildOptions& options = {});
+
+	Result	refit(std::span<const math::vec3> vertices);
+	Result	refit(const math::mat4& transform, std::span<const math::vec3> vertices);
+	Result	refit(std::span<const math::aabb> boxes);
+
+	/** Closest triangle hit in [r.tmin, r.tmax] */
+	bool	intersect(const math::ray& r, Hit& hit) const;
+
+	/** Any triangle hit in [r.tmin, r.tmax], stops at the first one (shadow rays) */
+	bool	occluded(const math::ray& r) const;
+
+	/**
+	 * Visit the primitives whose boxes the ray hits, nearest boxes first
+	 * fn(std::uint32_t prim, math::ray& r) -> bool, prim is the index given to build()
+	 * shrink r.tmax to cull farther boxes, return true to stop the traversal
+	 */
+	template <typename Fn>
+	void	traverse(math::ray r, Fn&& fn) const;
+
+	inline std::span<const BVHNode>		nodes() const { return _nodes; }
+	inline std::span<const BVH4Node>	nodes4() const { return _nodes4; }
+	inline std::span<const std::uint32_t>	primitives() const { return _prims; }
+	inline math::aabb	bounds() const { return _nodes.empty() ? math::aabb() : math::aabb(_nodes[0].min, _nodes[0].max); }
+	inline bool	empty() const { return _nodes.empty(); }
+
+private:
+	void	build_nodes(std::span<const math::aabb> boxes, const BuildOptions& options);
+	void	collapse();
+	template <typename BoxOf>
+	void	refit_nodes(BoxOf&& box_of);
+	void	gather_triangles(std::span<const math::vec3> vertices);
+
+	/** fn(std::uint32_t first, std::uint32_t count, math::ray& r) -> bool, leaf-order ranges */
+	template <typename Fn>
+	void	traverse_leaves(math::ray r, Fn&& fn) const;
+
+	template <bool AnyHit>
+	bool	intersect_triangles(const math::ray& r, Hit& hit) const;
+
+	std::vector<BVHNode>		_nodes;
+	std::vector<BVH4Node>		_nodes4;
+	std::vector<std::uint32_t>	_nodes4_source;	// BVH2 node of each BVH4 child slot, 4 per BVH4 node, for refit
+	std::vector<std::uint32_t>	_prims;		// leaf order -> build() index
+
+	// triangle scenes only, in leaf order
+	std::vector<std::uint32_t>	_indices;
+	std::vector<math::vec3>		_v0, _v1, _v2;
+};
+
+template <typename Fn>
+void BVH::traverse(math::ray r, Fn&& fn) const
+{
+	traverse_leaves(r, [&](std::uint32_t first, std::uint32_t count, math::ray& ray) {
+		for (std::uint32_t p = first; p < first + count; ++p)
+			if (fn(_prims[p], ray))
+				return true;
+		return false;
+	});
+}
+
+template <typename Fn>
+void BVH::traverse_leaves(math::ray r, Fn&& fn) const
+{
+	if (_nodes.empty())
+		return;
+
+	float tnear, tfar;
+	if (!math::ray_aabb(r, bounds(), tnear, tfar))
+		return;
+
+	// entries are skipped when r.tmax shrank below their entry distance
+	std::uint32_t stack[max_stack_depth];
+	float dist[max_stack_depth];
+	int sp = 0;
+
+	stack[sp] = 0;
+	dist[sp++] = tnear;
+
+	if (!_nodes4.empty())
+	{
+		// leaf children go on the stack too (count > 0), so they are visited in entry order with their siblings
+		std::uint32_t count[max_stack_depth];
+		count[0] = 0;
+
+		while (sp > 0)
+		{
+			--sp;
+			if (dist[sp] > r.tmax)
+				continue;
+			if (count[sp] > 0)
+			{
+				if (fn(stack[sp], count[sp], r))
+					return;
+				continue;
+			}
+			const BVH4Node& n = _nodes4[stack[sp]];
+
+			math::aabb4 box = {
+				{math::floatx4::load(n.min[0]), math::floatx4::load(n.min[1]), math::floatx4::load(n.min[2])},
+				{math::floatx4::load(n.max[0]), math::floatx4::load(n.max[1]), math::floatx4::load(n.max[2])}
+			};
+			math::floatx4 t4;
+			int mask = math::ray_aabb(r, box, t4).bits();
+			if (!mask)
+				continue;
+
+			alignas(16) float t[4];
+			t4.store(t);
+
+			// hit children are pushed farthest first, leaves and interior alike
+			int order[4];
+			int pushed = 0;
+			for (int i = 0; i < 4; ++i)
+			{
+				if (!(mask & (1 << i)))
+					continue;
+
+				int j = pushed++;
+				for (; j > 0 && t[order[j - 1]] < t[i]; --j)
+					order[j] = order[j - 1];
+				order[j] = i;
+			}
+
+			for (int k = 0; k < pushed; ++k)
+			{
+				stack[sp] = n.child[order[k]];
+				count[sp] = n.count[order[k]];
+				dist[sp++] = t[order[k]];
+			}
+		}
+		return;
+	}
+
+	while (sp > 0)
+	{
+		--sp;
+		if (dist[sp] > r.tmax)
+			continue;
+		const BVHNode& n = _nodes[stack[sp]];
+
+		if (n.is_leaf())
+		{
+			if (fn(n.left_first, n.count, r))
+				return;
+			continue;
+		}
+
+		const BVHNode& a = _nodes[n.left_first];
+		const BVHNode& b = _nodes[n.left_first + 1];
+		float ta, tb;
+		bool ha = math::ray_aabb(r, math::aabb(a.min, a.max), ta, tfar);
+		bool hb = math::ray_aabb(r, math::aabb(b.min, b.max), tb, tfar);
+
+		if (ha && hb)
+		{
+			bool a_near = ta <= tb;
+			stack[sp] = n.left_first + (a_near ? 1 : 0);
+			dist[sp++] = a_near ? tb : ta;
+			stack[sp] = n.left_first + (a_near ? 0 : 1);
+			dist[sp++] = a_near ? ta : tb;
+		}
+		else if (ha || hb)
+		{
+			stack[sp] = n.left_first + (ha ? 0 : 1);
+			dist[sp++] = ha ? ta : tb;
+		}
+	}
+}
+
+}
@@ -1,15 +1,8 @@
 #pragma once
 
-#include <vector>
-
 #include "math.hpp"
 #include "logger.hpp"
-
-namespace cu::string
-{
-
-std::vector<std::string> split(const std::string& str, char sep);
-
-}
+#include "memory.hpp"
+#include "string.hpp"
 
 
@@ -0,0 +1,101 @@
+#pragma once
+
+/**
+ * Runtime CPU features and the attributes that build ISA-specific kernels into a
+ * baseline binary
+ *
+ * Headers choose SSE / AVX code at compile time (#if defined(__AVX2__)), which for a
+ * distro x86-64 build means SSE2 only. Hot batch kernels in src/ are additionally
+ * compiled for AVX2 + FMA with function multiversioning: two definitions share one
+ * name, one marked CU_TARGET_DEFAULT and one CU_TARGET_AVX2, and the dynamic loader
+ * binds the call through an ifunc resolver that runs CPUID once at load time
+ * https://gcc.gnu.org/onlinedocs/gcc/Function-Multiversioning.html
+ *
+ * CU_MULTIVERSION is 0 when the build already targets AVX2 (the default version is the
+ * fast one) or the toolchain has no ifunc support (MSVC, non-ELF targets): only the
+ * default definitions are compiled then and the attributes expand to nothing
+ */
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)) \
+	&& defined(__ELF__) && !defined(__AVX2__)
+	#define CU_MULTIVERSION 1
+	#define CU_TARGET_DEFAULT __attribute__((target("default")))
+	#define CU_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+	#define CU_MULTIVERSION 0
+	#define CU_TARGET_DEFAULT
+	#define CU_TARGET_AVX2
+#endif
+
+/**
+ * Single kernels picked with a runtime check instead of an ifunc, when the feature
+ * flag alone is not enough to decide (pdep is microcoded on some BMI2 CPUs)
+ */
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	#define CU_HAS_TARGET_BMI2 1
+	#define CU_TARGET_BMI2 __attribute__((target("bmi2")))
+#else
+	#define CU_HAS_TARGET_BMI2 0
+	#define CU_TARGET_BMI2
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	#include <cpuid.h>
+#endif
+
+namespace cu::cpu {
+
+struct features
+{
+	bool sse41 = false;
+	bool avx = false;
+	bool avx2 = false;
+	bool fma = false;
+	bool f16c = false;
+	bool bmi2 = false;
+	bool fast_pdep = false;	// bmi2 without the microcoded pdep / pext of AMD families 15h and 17h (Zen 1 / 2)
+	bool invariant_tsc = false;	// rdtsc ticks at a constant rate through frequency changes and sleep states
+};
+
+/** What the running CPU supports, detected once; compile-time flags without GCC / Clang builtins */
+inline const features& current()
+{
+	static const features f = [] {
+		features r;
+	#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+		__builtin_cpu_init();
+		r.sse41 = __builtin_cpu_supports("sse4.1");
+		r.avx = __builtin_cpu_supports("avx");
+		r.avx2 = __builtin_cpu_supports("avx2");
+		r.fma = __builtin_cpu_supports("fma");
+		r.f16c = __builtin_cpu_supports("f16c");
+		r.bmi2 = __builtin_cpu_supports("bmi2");
+		r.fast_pdep = r.bmi2 && !__builtin_cpu_is("amdfam15h") && !__builtin_cpu_is("amdfam17h");
+		unsigned a, b, c, d;
+		r.invariant_tsc = __get_cpuid(0x80000007, &a, &b, &c, &d) && (d & (1u << 8));
+	#else
+		#if defined(__SSE4_1__)
+		r.sse41 = true;
+		#endif
+		#if defined(__AVX__)
+		r.avx = true;
+		#endif
+		#if defined(__AVX2__)
+		r.avx2 = true;
+		#endif
+		#if defined(__FMA__)
+		r.fma = true;
+		#endif
+		#if defined(__F16C__)
+		r.f16c = true;
+		#endif
+		#if defined(__BMI2__)
+		r.bmi2 = true;
+		r.fast_pdep = true;
+		#endif
+	#endif
+		return r;
+	}();
+	return f;
+}
+
+}
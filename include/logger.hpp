@@ -1,6 +1,14 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
+
+#include "logger/format.hpp"
+#include "logger/sink.hpp"
 
 #ifndef LOG_DATE
 # define LOG_DATE 1
@@ -10,18 +18,162 @@
 # define LOG_TIME 1
 #endif
 
+/** Calls of the templated API below this level compile to nothing, 0 (TRACE) .. 4 (ERROR) */
+#ifndef LOG_MIN_LEVEL
+# define LOG_MIN_LEVEL 0
+#endif
+
 namespace cu::logger {
 
-	enum Level {
+	enum Level : int {
+		TRACE,
+		DEBUG,
 		INFO,
 		WARN,
 		ERROR
 	};
 
+	namespace detail {
+
+		inline std::atomic<int>	threshold{INFO};
+
+		std::int64_t	now();
+
+		/** Async only: a record of size bytes, filled by encode(dst, ctx) on this thread's buffer */
+		bool	enqueue_deferred(Level lvl, std::int64_t time, std::size_t size, void (*encode)(std::byte *, const void *), const void *ctx);
+
+		/** Queues the formatted line in async mode, writes it otherwise */
+		void	write(Level lvl, std::int64_t time, std::string_view msg);
+
+		/** Per-thread format buffer, flagged once destroyed so that later log calls (static destructors) use a local one */
+		struct Scratch
+		{
+			std::string	text;
+
+			static inline thread_local bool	destroyed = false;
+
+			~Scratch() { destroyed = true; }
+		};
+
+		template <typename... Args>
+		void	submit(Level lvl, std::string_view fmt, const Args &...args)
+		{
+			std::int64_t time = now();
+
+			if constexpr ((deferrable_argument<Args> && ...))
+			{
+				struct Context { std::string_view fmt; std::tuple<const Args &...> args; } ctx{fmt, {args...}};
+				auto encode = [](std::byte *dst, const void *p) {
+					const Context &c = *static_cast<const Context *>(p);
+					std::apply([&](const Args &...a) { encode_record(dst, c.fmt, a...); }, c.args);
+				};
+				if (enqueue_deferred(lvl, time, record_size(args...), encode, &ctx))
+					return;
+			}
+
+			if (Scratch::destroyed)
+			{
+				std::string msg;
+				vformat(msg, fmt, args...);
+				write(lvl, time, msg);
+				return;
+			}
+
+			thread_local Scratch scratch;
+			scratch.text.clear();
+			vformat(scratch.text, fmt, args...);
+			write(lvl, time, scratch.text);
+		}
+
+	}
+
+	/** Runtime threshold, checked before any formatting; INFO by default */
+	inline void		set_level(Level lvl) { detail::threshold.store(lvl, std::memory_order_relaxed); }
+	inline Level	level() { return static_cast<Level>(detail::threshold.load(std::memory_order_relaxed)); }
+	inline bool		enabled(Level lvl) { return lvl >= detail::threshold.load(std::memory_order_relaxed); }
+
 	void	log(Level lvl, const std::string &msg);
 
 	inline void	info(const std::string &msg) { log(INFO, msg); }
 	inline void	warn(const std::string &msg) { log(WARN, msg); }
 	inline void	error(const std::string &msg) { log(ERROR, msg); }
 
-}
\ No newline at end of file
+	/**
+	 * log<INFO>("{} rays in {} ms", rays, ms): std::format syntax, checked at compile time
+	 * Below LOG_MIN_LEVEL the call is removed, below the runtime level it returns before
+	 * touching the arguments. In async mode arithmetic / enum / pointer / string arguments
+	 * are copied as bytes and formatted by the writer thread
+	 */
+	template <Level L, typename... Args>
+	inline void	log(format_string<Args...> fmt, Args &&...args)
+	{
+		if constexpr (L >= LOG_MIN_LEVEL)
+		{
+			if (!enabled(L))
+				return;
+			detail::submit(L, fmt.get(), args...);
+		}
+	}
+
+	template <typename... Args>
+	inline void	trace(format_string<Args...> fmt, Args &&...args) { log<TRACE>(fmt, std::forward<Args>(args)...); }
+	template <typename... Args>
+	inline void	debug(format_string<Args...> fmt, Args &&...args) { log<DEBUG>(fmt, std::forward<Args>(args)...); }
+	template <typename... Args>
+	inline void	info(format_string<Args...> fmt, Args &&...args) { log<INFO>(fmt, std::forward<Args>(args)...); }
+	template <typename... Args>
+	inline void	warn(format_string<Args...> fmt, Args &&...args) { log<WARN>(fmt, std::forward<Args>(args)...); }
+	template <typename... Args>
+	inline void	error(format_string<Args...> fmt, Args &&...args) { log<ERROR>(fmt, std::forward<Args>(args)...); }
+
+/**
+ * Same as log<L>(), except the arguments are not evaluated either when the level is
+ * filtered out, at compile time or at runtime: LOG_TRACE("node {}", expensive(n))
+ */
+#define CU_LOG_AT(lvl, ...) \
+	do { \
+		if constexpr ((lvl) >= LOG_MIN_LEVEL) \
+			if (::cu::logger::enabled(lvl)) \
+				::cu::logger::log<lvl>(__VA_ARGS__); \
+	} while (0)
+
+#define LOG_TRACE(...)	CU_LOG_AT(::cu::logger::TRACE, __VA_ARGS__)
+#define LOG_DEBUG(...)	CU_LOG_AT(::cu::logger::DEBUG, __VA_ARGS__)
+#define LOG_INFO(...)	CU_LOG_AT(::cu::logger::INFO, __VA_ARGS__)
+#define LOG_WARN(...)	CU_LOG_AT(::cu::logger::WARN, __VA_ARGS__)
+#define LOG_ERROR(...)	CU_LOG_AT(::cu::logger::ERROR, __VA_ARGS__)
+
+	/** What log() does when the calling thread's buffer is full in async mode */
+	enum Overflow {
+		BLOCK,			// wait for the writer to make room, nothing is lost
+		DROP,			// discard the message, dropped() counts it
+		DROP_AND_COUNT	// discard, and the writer logs how many were lost since the last report
+	};
+
+	struct AsyncOptions {
+		std::size_t					buffer_size = 1 << 16;	// bytes per logging thread, rounded up to a power of two
+		Overflow					overflow = BLOCK;
+		std::chrono::milliseconds	flush_interval{5};		// longest a message waits in a buffer
+	};
+
+	/**
+	 * Async mode: log() copies the message into a lock-free buffer owned by the calling
+	 * thread and returns, one background thread drains every buffer, merges the lines
+	 * in timestamp order and hands them to the sinks in batches (the console does one
+	 * write(2) per stream per batch)
+	 *
+	 * Messages longer than a quarter of buffer_size are truncated. Logging stays
+	 * synchronous until start_async() and after stop_async()
+	 */
+	void	start_async(const AsyncOptions &options = {});
+
+	/** Drains every buffer, writes and joins the writer; also runs at exit */
+	void	stop_async();
+
+	/** Returns once everything logged before the call is written */
+	void	flush();
+
+	bool			is_async();
+	std::uint64_t	dropped();	// messages lost to DROP / DROP_AND_COUNT since start_async
+
+}
@@ -0,0 +1,564 @@
+#pragma once
+
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <version>
+
+#if defined(__cpp_lib_format)
+# include <format>
+# include <iterator>
+#endif
+
+namespace cu::logger {
+
+#if defined(__cpp_lib_format)
+
+	template <typename... Args>
+	using format_string = std::format_string<Args...>;
+
+	namespace detail {
+
+		template <typename... Args>
+		inline void vformat(std::string &out, std::string_view fmt, const Args &...args)
+		{
+			std::vformat_to(std::back_inserter(out), fmt, std::make_format_args(args...));
+		}
+
+	}
+
+#else
+
+	/**
+	 * Stand-in for std::format_string on standard libraries without <format>: "{}"
+	 * placeholders in order, "{{" / "}}" escapes, and the standard format spec
+	 * [[fill]align][sign][#][0][width][.precision][type] with the same output as
+	 * std::format. Checked at compile time like std::format_string: placeholder count,
+	 * spec syntax, and the spec against its argument's type. Explicit argument indices,
+	 * nested "{}" widths, locale 'L' and '#' on floats are not supported and do not compile
+	 */
+	namespace detail {
+
+		void	format_argument_count_mismatch();	// never defined, reached only in constant evaluation
+		void	format_spec_invalid();				// same, for a spec std::format would reject or this one cannot honor
+
+		struct format_spec
+		{
+			char	fill = ' ';
+			char	align = 0;			// '<', '>', '^', 0 for the type's default
+			char	sign = 0;			// '+', '-', ' ', 0 for the default '-'
+			bool	alternate = false;
+			bool	zero = false;
+			int		width = -1;
+			int		precision = -1;
+			char	type = 0;
+		};
+
+		/** The part of a placeholder after ':', false if it is not a well formed spec */
+		constexpr bool parse_spec(std::string_view s, format_spec &spec)
+		{
+			auto is_align = [](char c) { return c == '<' || c == '>' || c == '^'; };
+			auto is_digit = [](char c) { return c >= '0' && c <= '9'; };
+
+			std::size_t i = 0;
+			if (s.size() >= 2 && is_align(s[1]))
+			{
+				spec.fill = s[0];
+				spec.align = s[1];
+				i = 2;
+			}
+			else if (!s.empty() && is_align(s[0]))
+				spec.align = s[i++];
+			if (i < s.size() && (s[i] == '+' || s[i] == '-' || s[i] == ' '))
+				spec.sign = s[i++];
+			if (i < s.size() && s[i] == '#')
+			{
+				spec.alternate = true;
+				++i;
+			}
+			if (i < s.size() && s[i] == '0')
+			{
+				spec.zero = true;
+				++i;
+			}
+			if (i < s.size() && is_digit(s[i]))
+			{
+				spec.width = 0;
+				while (i < s.size() && is_digit(s[i]))
+					spec.width = spec.width * 10 + (s[i++] - '0');
+			}
+			if (i < s.size() && s[i] == '.')
+			{
+				if (++i == s.size() || !is_digit(s[i]))
+					return false;
+				spec.precision = 0;
+				while (i < s.size() && is_digit(s[i]))
+					spec.precision = spec.precision * 10 + (s[i++] - '0');
+			}
+			if (i < s.size())
+				spec.type = s[i++];
+			return i == s.size();
+		}
+
+		/** How an argument type formats: integer, floating, string, bool, char, pointer, other */
+		enum class format_kind { integer, floating, string, boolean, character, pointer, other };
+
+		template <typename T>
+		consteval format_kind kind_of()
+		{
+			if constexpr (std::is_same_v<T, bool>)
+				return format_kind::boolean;
+			else if constexpr (std::is_same_v<T, char>)
+				return format_kind::character;
+			else if constexpr (std::is_integral_v<T> || std::is_enum_v<T>)
+				return format_kind::integer;
+			else if constexpr (std::is_floating_point_v<T>)
+				return format_kind::floating;
+			else if constexpr (std::is_convertible_v<const T &, std::string_view> || std::is_same_v<std::decay_t<T>, const char *>
+				|| std::is_same_v<std::decay_t<T>, char *>)
+				return format_kind::string;
+			else if constexpr (std::is_pointer_v<T> || std::is_same_v<T, std::nullptr_t>)
+				return format_kind::pointer;
+			else
+				return format_kind::other;
+		}
+
+		constexpr bool one_of(char c, std::string_view set) { return set.find(c) != std::string_view::npos; }
+
+		/** What std::format accepts for each kind, minus the unsupported parts listed above */
+		constexpr bool spec_allowed(const format_spec &s, format_kind kind)
+		{
+			bool numeric_flags = s.sign || s.alternate || s.zero;
+			switch (kind)
+			{
+				case format_kind::integer:
+					return s.precision < 0 && (!s.type || one_of(s.type, "bBcdoxX")) && !(s.type == 'c' && numeric_flags);
+				case format_kind::floating:
+					return !s.alternate && (!s.type || one_of(s.type, "aAeEfFgG"));
+				case format_kind::string:
+					return !numeric_flags && (!s.type || s.type == 's');
+				case format_kind::boolean:
+				case format_kind::character:
+					if (!s.type || s.type == 's' || s.type == 'c')
+						return !numeric_flags && s.precision < 0 && (s.type != 'c' || kind == format_kind::character)
+							&& (s.type != 's' || kind == format_kind::boolean);
+					return s.precision < 0 && one_of(s.type, "bBdoxX");
+				case format_kind::pointer:
+					return !numeric_flags && s.precision < 0 && (!s.type || s.type == 'p');
+				default:
+					// math types and other to_chars types print as a whole, with no spec
+					return s.fill == ' ' && !s.align && !numeric_flags && s.width < 0 && s.precision < 0 && !s.type;
+			}
+		}
+
+		/** Each placeholder of fmt, in order: calls fn(spec text after ':'), returns their count */
+		template <typename Fn>
+		constexpr std::size_t for_each_placeholder(std::string_view fmt, Fn &&fn)
+		{
+			std::size_t n = 0;
+			for (std::size_t i = 0; i < fmt.size(); ++i)
+			{
+				if (fmt[i] == '{')
+				{
+					if (i + 1 < fmt.size() && fmt[i + 1] == '{')
+					{
+						++i;
+						continue;
+					}
+					std::size_t end = fmt.find('}', i);
+					if (end == std::string_view::npos)
+						format_spec_invalid();
+					std::string_view field = fmt.substr(i + 1, end - i - 1);
+					if (!field.empty() && field[0] != ':')
+						format_spec_invalid();
+					fn(n++, field.empty() ? field : field.substr(1));
+					i = end;
+				}
+				else if (fmt[i] == '}')
+				{
+					if (i + 1 < fmt.size() && fmt[i + 1] == '}')
+						++i;
+					else
+						format_spec_invalid();
+				}
+			}
+			return n;
+		}
+
+	}
+
+	template <typename... Args>
+	struct basic_format_string
+	{
+		template <typename S>
+			requires std::convertible_to<const S &, std::string_view>
+		consteval basic_format_string(const S &s) : _str(s)
+		{
+			constexpr detail::format_kind kinds[] = {detail::kind_of<std::remove_cvref_t<Args>>()..., detail::format_kind::other};
+			std::size_t count = detail::for_each_placeholder(_str, [&](std::size_t n, std::string_view text) {
+				detail::format_spec spec;
+				if (!detail::parse_spec(text, spec) || (n < sizeof...(Args) && !detail::spec_allowed(spec, kinds[n])))
+					detail::format_spec_invalid();
+			});
+			if (count != sizeof...(Args))
+				detail::format_argument_count_mismatch();
+		}
+
+		constexpr std::string_view	get() const { return _str; }
+
+	private:
+		std::string_view	_str;
+	};
+
+	template <typename... Args>
+	using format_string = basic_format_string<std::type_identity_t<Args>...>;
+
+	namespace detail {
+
+		inline constexpr std::size_t	no_zero_fill = std::string::npos;
+
+		/**
+		 * Pads what was appended since start to the width: with zeros after the sign and
+		 * base prefix (zero_at) for numbers with the '0' flag and no alignment, with the
+		 * fill character otherwise
+		 */
+		inline void pad(std::string &out, std::size_t start, const format_spec &spec, char default_align, std::size_t zero_at = no_zero_fill)
+		{
+			std::size_t length = out.size() - start;
+			if (spec.width < 0 || length >= static_cast<std::size_t>(spec.width))
+				return;
+			std::size_t n = static_cast<std::size_t>(spec.width) - length;
+			if (spec.zero && !spec.align && zero_at != no_zero_fill)
+			{
+				out.insert(zero_at, n, '0');
+				return;
+			}
+			char align = spec.align ? spec.align : default_align;
+			std::size_t before = align == '>' ? n : (align == '^' ? n / 2 : 0);
+			out.insert(start, before, spec.fill);
+			out.append(n - before, spec.fill);
+		}
+
+		/** Appends what convert(first, last) writes, growing the room until it fits */
+		template <typename Convert>
+		inline void append_chars(std::string &out, Convert &&convert)
+		{
+			std::size_t at = out.size();
+			for (std::size_t n = 64;; n *= 2)
+			{
+				out.resize(at + n);
+				std::to_chars_result r = convert(out.data() + at, out.data() + at + n);
+				if (r.ec == std::errc())
+				{
+					out.resize(static_cast<std::size_t>(r.ptr - out.data()));
+					return;
+				}
+			}
+		}
+
+		inline void to_upper(std::string &out, std::size_t start)
+		{
+			for (std::size_t i = start; i < out.size(); ++i)
+				if (out[i] >= 'a' && out[i] <= 'z')
+					out[i] = static_cast<char>(out[i] - 'a' + 'A');
+		}
+
+		template <typename T>
+			requires std::is_integral_v<T>
+		inline void append_integer(std::string &out, T v, const format_spec &spec)
+		{
+			std::size_t start = out.size();
+			if (spec.type == 'c')
+			{
+				out += static_cast<char>(v);
+				pad(out, start, spec, '<');
+				return;
+			}
+
+			using U = std::make_unsigned_t<T>;
+			U magnitude = static_cast<U>(v);
+			if constexpr (std::is_signed_v<T>)
+				if (v < 0)
+				{
+					magnitude = static_cast<U>(U(0) - magnitude);
+					out += '-';
+				}
+			if (out.size() == start && (spec.sign == '+' || spec.sign == ' '))
+				out += spec.sign;
+
+			int base = 10;
+			switch (spec.type)
+			{
+				case 'x': case 'X': base = 16; break;
+				case 'b': case 'B': base = 2; break;
+				case 'o': base = 8; break;
+				default: break;
+			}
+			if (spec.alternate && base != 10)
+			{
+				if (base == 8)
+				{
+					if (magnitude != 0)
+						out += '0';
+				}
+				else
+				{
+					out += '0';
+					out += spec.type;		// 0x, 0X, 0b or 0B like the type
+				}
+			}
+
+			std::size_t zero_at = out.size();
+			append_chars(out, [&](char *first, char *last) { return std::to_chars(first, last, magnitude, base); });
+			if (spec.type == 'X')
+				to_upper(out, zero_at);
+			pad(out, start, spec, '>', zero_at);
+		}
+
+		template <typename T>
+			requires std::is_floating_point_v<T>
+		inline void append_floating(std::string &out, T v, const format_spec &spec)
+		{
+			std::size_t start = out.size();
+			bool finite = v == v && v - v == v - v;
+			if (!(v < 0 || (v == 0 && 1 / v < 0)) && (spec.sign == '+' || spec.sign == ' '))
+				out += spec.sign;
+
+			append_chars(out, [&](char *first, char *last) {
+				switch (spec.type)
+				{
+					case 'e': case 'E':
+						return std::to_chars(first, last, v, std::chars_format::scientific, spec.precision < 0 ? 6 : spec.precision);
+					case 'f': case 'F':
+						return std::to_chars(first, last, v, std::chars_format::fixed, spec.precision < 0 ? 6 : spec.precision);
+					case 'g': case 'G':
+						return std::to_chars(first, last, v, std::chars_format::general, spec.precision < 0 ? 6 : spec.precision);
+					case 'a': case 'A':
+						return spec.precision < 0 ? std::to_chars(first, last, v, std::chars_format::hex)
+							: std::to_chars(first, last, v, std::chars_format::hex, spec.precision);
+					default:
+						return spec.precision < 0 ? std::to_chars(first, last, v)
+							: std::to_chars(first, last, v, std::chars_format::general, spec.precision);
+				}
+			});
+			if (spec.type == 'E' || spec.type == 'F' || spec.type == 'G' || spec.type == 'A')
+				to_upper(out, start);
+
+			// infinity and NaN are padded with the fill, never zeros
+			std::size_t zero_at = no_zero_fill;
+			if (finite)
+				zero_at = start + (out[start] == '-' || out[start] == '+' || out[start] == ' ' ? 1 : 0);
+			pad(out, start, spec, '>', zero_at);
+		}
+
+		inline void append_string(std::string &out, std::string_view v, const format_spec &spec)
+		{
+			std::size_t start = out.size();
+			if (spec.precision >= 0 && v.size() > static_cast<std::size_t>(spec.precision))
+				v = v.substr(0, static_cast<std::size_t>(spec.precision));
+			out += v;
+			pad(out, start, spec, '<');
+		}
+
+		inline void append_value(std::string &out, std::string_view v, const format_spec &spec) { append_string(out, v, spec); }
+		inline void append_value(std::string &out, const char *v, const format_spec &spec) { append_string(out, v ? v : "(null)", spec); }
+		inline void append_value(std::string &out, const std::string &v, const format_spec &spec) { append_string(out, v, spec); }
+
+		inline void append_value(std::string &out, bool v, const format_spec &spec)
+		{
+			if (spec.type && spec.type != 's')
+				append_integer(out, static_cast<unsigned char>(v), spec);
+			else
+				append_string(out, v ? "true" : "false", spec);
+		}
+
+		inline void append_value(std::string &out, char v, const format_spec &spec)
+		{
+			if (spec.type && spec.type != 'c')
+				append_integer(out, v, spec);
+			else
+				append_string(out, std::string_view(&v, 1), spec);
+		}
+
+		template <typename T>
+			requires (std::is_integral_v<T> && !std::is_same_v<T, bool> && !std::is_same_v<T, char>)
+		inline void append_value(std::string &out, T v, const format_spec &spec) { append_integer(out, v, spec); }
+
+		template <typename T>
+			requires std::is_floating_point_v<T>
+		inline void append_value(std::string &out, T v, const format_spec &spec) { append_floating(out, v, spec); }
+
+		template <typename T>
+			requires std::is_enum_v<T>
+		inline void append_value(std::string &out, T v, const format_spec &spec) { append_integer(out, static_cast<std::underlying_type_t<T>>(v), spec); }
+
+		inline void append_value(std::string &out, const void *v, const format_spec &spec)
+		{
+			std::size_t start = out.size();
+			out += "0x";
+			append_chars(out, [&](char *first, char *last) { return std::to_chars(first, last, reinterpret_cast<std::uintptr_t>(v), 16); });
+			pad(out, start, spec, '>');
+		}
+
+		inline void append_value(std::string &out, std::nullptr_t, const format_spec &spec) { append_value(out, static_cast<const void *>(nullptr), spec); }
+
+		/** Class types with a to_chars(first, last, v) found by ADL, like the math types of string/numeric.hpp */
+		template <typename T>
+			requires (std::is_class_v<T> && requires (char *p, const T &v) { { to_chars(p, p, v) } -> std::same_as<std::to_chars_result>; })
+		inline void append_value(std::string &out, const T &v, const format_spec &)
+		{
+			append_chars(out, [&](char *first, char *last) { return to_chars(first, last, v); });
+		}
+
+		/** Literal text up to the next placeholder, whose spec is returned in spec; false at the end */
+		inline bool append_literal(std::string &out, std::string_view fmt, std::size_t &i, format_spec &spec)
+		{
+			while (i < fmt.size())
+			{
+				char c = fmt[i++];
+				if ((c == '{' || c == '}') && i < fmt.size() && fmt[i] == c)
+				{
+					out += c;
+					++i;
+				}
+				else if (c == '{')
+				{
+					std::size_t end = fmt.find('}', i);
+					std::string_view field = fmt.substr(i, end - i);
+					spec = format_spec{};
+					if (!field.empty())
+						parse_spec(field.substr(1), spec);		// validated at compile time
+					i = end + 1;
+					return true;
+				}
+				else
+					out += c;
+			}
+			return false;
+		}
+
+		template <typename... Args>
+		inline void vformat(std::string &out, std::string_view fmt, const Args &...args)
+		{
+			std::size_t i = 0;
+			format_spec spec;
+			((append_literal(out, fmt, i, spec) ? append_value(out, args, spec) : void()), ...);
+			append_literal(out, fmt, i, spec);
+		}
+
+	}
+
+#endif
+
+	namespace detail {
+
+		/**
+		 * Deferred formatting: the arguments of a log call are copied into the record as
+		 * bytes and formatted by the writer thread. Only types whose formatted output
+		 * depends on nothing but their bytes qualify (arithmetic, enums, void pointers)
+		 * plus strings, which are copied; anything else is formatted on the calling thread
+		 */
+		template <typename T>
+		concept string_argument = std::is_convertible_v<const T &, std::string_view>;
+
+		template <typename T>
+		concept deferrable_argument = string_argument<T> || std::is_arithmetic_v<T> || std::is_enum_v<T>
+			|| std::is_same_v<T, const void *> || std::is_same_v<T, void *> || std::is_same_v<T, std::nullptr_t>;
+
+		/** What the writer formats: strings as string_view into the record, the rest as is */
+		template <typename T>
+		using stored_argument = std::conditional_t<string_argument<T>, std::string_view, T>;
+
+		using format_fn = void (*)(std::string &out, const std::byte *args);
+
+		template <typename T>
+		inline std::size_t encoded_size(const T &v)
+		{
+			if constexpr (string_argument<T>)
+				return sizeof(std::uint32_t) + std::string_view(v).size();
+			else
+				return sizeof(T);
+		}
+
+		template <typename T>
+		inline std::byte *encode(std::byte *p, const T &v)
+		{
+			if constexpr (string_argument<T>)
+			{
+				std::string_view s(v);
+				std::uint32_t size = static_cast<std::uint32_t>(s.size());
+				std::memcpy(p, &size, sizeof(size));
+				std::memcpy(p + sizeof(size), s.data(), s.size());
+				return p + sizeof(size) + s.size();
+			}
+			else
+			{
+				std::memcpy(p, &v, sizeof(T));
+				return p + sizeof(T);
+			}
+		}
+
+		template <typename S>
+		inline S decode(const std::byte *&p)
+		{
+			if constexpr (std::is_same_v<S, std::string_view>)
+			{
+				std::uint32_t size;
+				std::memcpy(&size, p, sizeof(size));
+				std::string_view s(reinterpret_cast<const char *>(p + sizeof(size)), size);
+				p += sizeof(size) + size;
+				return s;
+			}
+			else
+			{
+				S v;
+				std::memcpy(&v, p, sizeof(S));
+				p += sizeof(S);
+				return v;
+			}
+		}
+
+		/** Record layout: format_fn, format string (pointer + size, it is a literal), arguments */
+		template <typename... S>
+		void format_record(std::string &out, const std::byte *p)
+		{
+			const char	*fmt_data;
+			std::size_t	fmt_size;
+			std::memcpy(&fmt_data, p, sizeof(fmt_data));
+			std::memcpy(&fmt_size, p + sizeof(fmt_data), sizeof(fmt_size));
+			p += sizeof(fmt_data) + sizeof(fmt_size);
+
+			std::tuple<S...> values;
+			std::apply([&](S &...v) { ((v = decode<S>(p)), ...); }, values);
+			std::apply([&](const S &...v) { vformat(out, std::string_view(fmt_data, fmt_size), v...); }, values);
+		}
+
+		template <typename... Args>
+		inline std::size_t record_size(const Args &...args)
+		{
+			return sizeof(format_fn) + sizeof(const char *) + sizeof(std::size_t) + (std::size_t(0) + ... + encoded_size(args));
+		}
+
+		template <typename... Args>
+		inline void encode_record(std::byte *p, std::string_view fmt, const Args &...args)
+		{
+			format_fn fn = &format_record<stored_argument<Args>...>;
+			const char *fmt_data = fmt.data();
+			std::size_t fmt_size = fmt.size();
+			std::memcpy(p, &fn, sizeof(fn));
+			std::memcpy(p + sizeof(fn), &fmt_data, sizeof(fmt_data));
+			std::memcpy(p + sizeof(fn) + sizeof(fmt_data), &fmt_size, sizeof(fmt_size));
+			p += sizeof(fn) + sizeof(fmt_data) + sizeof(fmt_size);
+			((p = encode(p, args)), ...);
+		}
+
+	}
+
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "return.hpp"
+
+namespace cu::logger {
+
+	enum Level : int;
+
+	/**
+	 * Destination of formatted log lines. The logger serializes every call into its sinks
+	 * (the writer thread in async mode, a lock otherwise), implementations need no locking
+	 */
+	class Sink
+	{
+	public:
+		virtual ~Sink() = default;
+
+		/** One complete line, newline included; may be buffered until flush() */
+		virtual void	write(Level lvl, std::string_view line) = 0;
+
+		/** End of a batch (async) or of a line (synchronous) */
+		virtual void	flush() {}
+
+		/** Whether lines carry the colors.hpp escape codes around the level */
+		virtual bool	color() const { return false; }
+	};
+
+	/** stdout, and stderr for ERROR; one write(2) per stream per batch. The default sink */
+	class ConsoleSink : public Sink
+	{
+	public:
+		void	write(Level lvl, std::string_view line) override;
+		void	flush() override;
+		bool	color() const override { return true; }
+
+	private:
+		std::string	_out;
+		std::string	_err;
+	};
+
+	struct FileSinkOptions
+	{
+		std::string					path;						// "logs/render.log" -> logs/render.<time>.<n>.log
+		std::size_t					segment_size = 64 << 20;	// bytes mapped per segment, rotates when full
+		std::chrono::seconds		max_age{0};					// also rotate segments older than this, 0 = size only
+		std::size_t					max_segments = 0;			// delete the oldest segments past this count, 0 = keep all
+	};
+
+	/**
+	 * Log file written through a shared memory mapping: each segment is allocated up
+	 * front (posix_fallocate) and mapped once, a line is a memcpy at the current offset,
+	 * so writing costs no syscall until the segment rotates. The page cache owns the
+	 * data, it survives a crash of the process; a segment is truncated to its used size
+	 * when it is closed
+	 *
+	 * Lines carry no color codes. POSIX only, open() fails elsewhere
+	 */
+	class FileSink : public Sink
+	{
+	public:
+		FileSink() = default;
+		~FileSink() override;
+
+		FileSink(const FileSink &) = delete;
+		FileSink &operator=(const FileSink &) = delete;
+
+		Result	open(const FileSinkOptions &options);
+		void	close();
+
+		void	write(Level lvl, std::string_view line) override;
+		void	flush() override;
+
+		const std::string	&segment_path() const { return _segment_path; }
+
+		/** Bytes used in the current segment, published after each line for other threads */
+		std::size_t			offset() const { return _offset.load(std::memory_order_acquire); }
+
+	private:
+		Result	open_segment();
+		void	close_segment();
+		void	rotate();
+
+		FileSinkOptions							_options;
+		std::string								_segment_path;
+		std::deque<std::string>					_segments;		// oldest first
+		std::chrono::steady_clock::time_point	_opened;
+		std::uint64_t							_sequence = 0;
+
+		int					_fd = -1;
+		char				*_map = nullptr;
+		std::size_t			_size = 0;
+		std::atomic<std::size_t>	_offset{0};
+	};
+
+	/** Sinks receive every line from now on; the ConsoleSink is installed by default */
+	void	add_sink(std::shared_ptr<Sink> sink);
+	void	remove_sink(const std::shared_ptr<Sink> &sink);
+	void	clear_sinks();
+
+}
@@ -3,11 +3,27 @@
 #define degreesToRadians(x) x*(3.141592f/180.0f)
 #define radiansToDegrees(x) x*(180.0f/3.141592f)
 
+#include "math/fast.hpp"
+#include "math/scalar.hpp"
+#include "math/half.hpp"
+#include "math/vec.hpp"
+#include "math/mat.hpp"
+
 #include "math/vec2.hpp"
 #include "math/vec3.hpp"
 #include "math/vec4.hpp"
+#include "math/vec3a.hpp"
+
+#include "math/floatx4.hpp"
+#include "math/floatx8.hpp"
+#include "math/vec3x.hpp"
 
 #include "math/mat4.hpp"
 #include "math/quat.hpp"
+#include "math/packed.hpp"
 
 #include "math/transform.hpp"
+
+#include "math/ray.hpp"
+#include "math/intersect.hpp"
+#include "math/frustum.hpp"
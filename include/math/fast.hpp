@@ -0,0 +1,466 @@
+#pragma once
+
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+#include "math/floatx4.hpp"
+#include "math/floatx8.hpp"
+
+#if defined(__SSE__)
+#include <immintrin.h>
+#endif
+
+namespace cu::math::fast {
+
+/**
+ * Polynomial approximations of the libm functions, for float, floatx4 / floatx8
+ * and raw __m128 / __m256. Each function takes an accuracy tier, max relative error
+ * measured against the double precision libm over [-4pi, 4pi] (sin / cos / tan), the
+ * full domain (asin / acos), [-1e4, 1e4] (atan / atan2) and every positive normal
+ * float (rsqrt), without FMA; tests/fast_accuracy.cpp measures them:
+ *
+ *            low         medium      high
+ * sin, cos   5.7e-4      2.0e-6      1.5 ulp
+ * tan        5.9e-4      2.1e-6      3.5 ulp
+ * asin, acos 7.6e-5      3.7e-6      2.4 ulp
+ * atan(2)    1.6e-3      4.6e-6      3.8 ulp
+ * rsqrt      3.3e-4      4.0 ulp     4.0 ulp
+ *
+ * Coefficients are minimax fits (Lawson's algorithm on the relative error). sin / cos
+ * reduce by pi/2 with a 4 part Cody-Waite split and stay within 2.5 ulp while |x| < 8192.
+ * Not handled: inf / nan inputs of atan2, the sign of atan2(+-0, -0) and of sin(-0)
+ * https://github.com/jeremybarnes/cephes/blob/master/single/sinf.c
+ */
+enum class precision
+{
+	low,
+	medium,
+	high,
+};
+
+template <typename F>
+concept lane_type = std::is_same_v<F, float> || std::is_same_v<F, floatx4> || std::is_same_v<F, floatx8>;
+
+namespace detail {
+
+inline constexpr float pi = 3.14159265358979323846f;
+inline constexpr float half_pi = 1.57079632679489661923f;
+inline constexpr float two_over_pi = 0.63661977236758134308f;
+
+// pi/2 split so that k * part is exact for the first three parts
+inline constexpr float pio2_1 = 1.5703125f;
+inline constexpr float pio2_2 = 4.837512969970703125e-4f;
+inline constexpr float pio2_3 = 7.549533620476723e-8f;
+inline constexpr float pio2_4 = 2.5633441e-12f;
+
+// adding 1.5 * 2^23 rounds to an integer, which then sits in the low mantissa bits
+inline constexpr float round_magic = 12582912.0f;
+
+/* ---------------------------------------------------------------------------------- */
+/* float                                                                              */
+/* ---------------------------------------------------------------------------------- */
+
+inline float madd(float a, float b, float c)
+{
+#if defined(__FMA__)
+	return std::fma(a, b, c);
+#else
+	return a * b + c;
+#endif
+}
+
+inline float select(bool m, float a, float b) { return m ? a : b; }
+inline float abs(float x) { return std::fabs(x); }
+inline float min(float a, float b) { return a < b ? a : b; }
+inline float max(float a, float b) { return a > b ? a : b; }
+inline float sqrt(float x) { return std::sqrt(x); }
+
+/** a with its sign flipped where s is negative */
+inline float xorsign(float a, float s)
+{
+	return std::bit_cast<float>(std::bit_cast<std::uint32_t>(a) ^ (std::bit_cast<std::uint32_t>(s) & 0x80000000u));
+}
+
+/** Bit B of the integer held in t = k + round_magic, as a mask and as a sign bit */
+template <int B>
+inline bool bit_mask(float t) { return (std::bit_cast<std::uint32_t>(t) >> B) & 1u; }
+
+template <int B>
+inline float bit_sign(float t) { return std::bit_cast<float>((std::bit_cast<std::uint32_t>(t) << (31 - B)) & 0x80000000u); }
+
+inline float rsqrt_estimate(float x)
+{
+#if defined(__SSE__)
+	return _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+#else
+	// http://www.lomont.org/papers/2003/InvSqrt.pdf, refined once to match the 12 bits of rsqrtss
+	float e = std::bit_cast<float>(0x5f375a86u - (std::bit_cast<std::uint32_t>(x) >> 1));
+	return e * (1.5f - 0.5f * x * e * e);
+#endif
+}
+
+/* ---------------------------------------------------------------------------------- */
+/* floatx4 / floatx8                                                                  */
+/* ---------------------------------------------------------------------------------- */
+
+inline floatx4 madd(const floatx4& a, const floatx4& b, const floatx4& c) { return floatx4::fmadd(a, b, c); }
+inline floatx4 select(const maskx4& m, const floatx4& a, const floatx4& b) { return floatx4::select(m, a, b); }
+inline floatx4 abs(const floatx4& x) { return floatx4::abs(x); }
+inline floatx4 min(const floatx4& a, const floatx4& b) { return floatx4::min(a, b); }
+inline floatx4 max(const floatx4& a, const floatx4& b) { return floatx4::max(a, b); }
+inline floatx4 sqrt(const floatx4& x) { return floatx4::sqrt(x); }
+
+inline floatx8 madd(const floatx8& a, const floatx8& b, const floatx8& c) { return floatx8::fmadd(a, b, c); }
+inline floatx8 select(const maskx8& m, const floatx8& a, const floatx8& b) { return floatx8::select(m, a, b); }
+inline floatx8 abs(const floatx8& x) { return floatx8::abs(x); }
+inline floatx8 min(const floatx8& a, const floatx8& b) { return floatx8::min(a, b); }
+inline floatx8 max(const floatx8& a, const floatx8& b) { return floatx8::max(a, b); }
+inline floatx8 sqrt(const floatx8& x) { return floatx8::sqrt(x); }
+
+#if defined(__SSE2__)
+inline floatx4 xorsign(const floatx4& a, const floatx4& s) { return floatx4(_mm_xor_ps(a.v, _mm_and_ps(s.v, _mm_set1_ps(-0.0f)))); }
+
+template <int B>
+inline maskx4 bit_mask(const floatx4& t)
+{
+	return maskx4(_mm_castsi128_ps(_mm_srai_epi32(_mm_slli_epi32(_mm_castps_si128(t.v), 31 - B), 31)));
+}
+
+template <int B>
+inline floatx4 bit_sign(const floatx4& t)
+{
+	return floatx4(_mm_and_ps(_mm_castsi128_ps(_mm_slli_epi32(_mm_castps_si128(t.v), 31 - B)), _mm_set1_ps(-0.0f)));
+}
+
+inline floatx4 rsqrt_estimate(const floatx4& x) { return floatx4(_mm_rsqrt_ps(x.v)); }
+#else
+// scalar floatx4, every helper goes lane by lane through the float versions
+template <typename Fn>
+inline floatx4 per_lane(Fn fn)
+{
+	alignas(16) float r[4];
+	for (int i = 0; i < 4; ++i)
+		r[i] = fn(i);
+	return floatx4::load(r);
+}
+
+inline floatx4 xorsign(const floatx4& a, const floatx4& s) { return per_lane([&](int i) { return xorsign(a[i], s[i]); }); }
+
+template <int B>
+inline maskx4 bit_mask(const floatx4& t)
+{
+	// lanes compare equal to themselves (mask set) unless they are replaced by a NaN
+	floatx4 m = per_lane([&](int i) { return bit_mask<B>(t[i]) ? 0.0f : NAN; });
+	return m == m;
+}
+
+template <int B>
+inline floatx4 bit_sign(const floatx4& t) { return per_lane([&](int i) { return bit_sign<B>(t[i]); }); }
+
+inline floatx4 rsqrt_estimate(const floatx4& x) { return per_lane([&](int i) { return rsqrt_estimate(x[i]); }); }
+#endif
+
+#if defined(__AVX__)
+inline floatx8 xorsign(const floatx8& a, const floatx8& s) { return floatx8(_mm256_xor_ps(a.v, _mm256_and_ps(s.v, _mm256_set1_ps(-0.0f)))); }
+inline floatx8 rsqrt_estimate(const floatx8& x) { return floatx8(_mm256_rsqrt_ps(x.v)); }
+
+#if defined(__AVX2__)
+template <int B>
+inline maskx8 bit_mask(const floatx8& t)
+{
+	return maskx8(_mm256_castsi256_ps(_mm256_srai_epi32(_mm256_slli_epi32(_mm256_castps_si256(t.v), 31 - B), 31)));
+}
+
+template <int B>
+inline floatx8 bit_sign(const floatx8& t)
+{
+	return floatx8(_mm256_and_ps(_mm256_castsi256_ps(_mm256_slli_epi32(_mm256_castps_si256(t.v), 31 - B)), _mm256_set1_ps(-0.0f)));
+}
+#else
+// AVX without AVX2 has no 256-bit integer shifts, both halves go through SSE2
+inline floatx4 lo_half(const floatx8& v) { return floatx4(_mm256_castps256_ps128(v.v)); }
+inline floatx4 hi_half(const floatx8& v) { return floatx4(_mm256_extractf128_ps(v.v, 1)); }
+inline __m256 combine(__m128 lo, __m128 hi) { return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1); }
+
+template <int B>
+inline maskx8 bit_mask(const floatx8& t) { return maskx8(combine(bit_mask<B>(lo_half(t)).v, bit_mask<B>(hi_half(t)).v)); }
+
+template <int B>
+inline floatx8 bit_sign(const floatx8& t) { return floatx8(combine(bit_sign<B>(lo_half(t)).v, bit_sign<B>(hi_half(t)).v)); }
+#endif
+#else
+inline floatx8 xorsign(const floatx8& a, const floatx8& s) { return {xorsign(a.lo, s.lo), xorsign(a.hi, s.hi)}; }
+inline floatx8 rsqrt_estimate(const floatx8& x) { return {rsqrt_estimate(x.lo), rsqrt_estimate(x.hi)}; }
+
+template <int B>
+inline maskx8 bit_mask(const floatx8& t) { return {bit_mask<B>(t.lo), bit_mask<B>(t.hi)}; }
+
+template <int B>
+inline floatx8 bit_sign(const floatx8& t) { return {bit_sign<B>(t.lo), bit_sign<B>(t.hi)}; }
+#endif
+
+/* ---------------------------------------------------------------------------------- */
+/* kernels                                                                            */
+/* ---------------------------------------------------------------------------------- */
+
+/** c0 + x * (c1 + x * (c2 + ...)) */
+template <typename F>
+inline F horner(const F&, float c) { return F(c); }
+
+template <typename F, typename... C>
+inline F horner(const F& x, float c, C... cs) { return madd(horner(x, cs...), x, F(c)); }
+
+/** sin(r) = r + r^3 P(r^2) on [-pi/4, pi/4] */
+template <precision P, typename F>
+inline F sin_poly(const F& r, const F& r2)
+{
+	F p;
+	if constexpr (P == precision::low)
+		p = F(-1.624279022e-1f);
+	else if constexpr (P == precision::medium)
+		p = horner(r2, -1.666339040e-1f, 8.163281716e-3f);
+	else
+		p = horner(r2, -1.666665524e-1f, 8.332160302e-3f, -1.951528247e-4f);
+	return madd(r * r2, p, r);
+}
+
+/** cos(r) = 1 + r^2 Q(r^2) on [-pi/4, pi/4] */
+template <precision P, typename F>
+inline F cos_poly(const F& r2)
+{
+	if constexpr (P == precision::low)
+		return horner(r2, 1.0f, -4.997605681e-1f, 4.045845196e-2f);
+	else if constexpr (P == precision::medium)
+		return horner(r2, 1.0f, -4.999988377e-1f, 4.165577516e-2f, -1.359185320e-3f);
+	else
+		return horner(r2, 1.0f, -5.0e-1f, 4.166661948e-2f, -1.388668199e-3f, 2.438356751e-5f);
+}
+
+/**
+ * r = x - k pi/2 with k = round(x * 2/pi), returns k + round_magic so the
+ * quadrant bits can be read from the mantissa
+ */
+template <typename F>
+inline F reduce_half_pi(const F& x, F& r)
+{
+	F t = madd(x, F(two_over_pi), F(round_magic));
+	F k = t - F(round_magic);
+
+	r = madd(k, F(-pio2_1), x);
+	r = madd(k, F(-pio2_2), r);
+	r = madd(k, F(-pio2_3), r);
+	r = madd(k, F(-pio2_4), r);
+	return t;
+}
+
+/** atan(z) = z P(z^2) on [0, 1] */
+template <precision P, typename F>
+inline F atan_poly(const F& z)
+{
+	F z2 = z * z;
+	F p;
+	if constexpr (P == precision::low)
+		p = horner(z2, 9.984248877e-1f, -3.010417521e-1f, 8.925291151e-2f);
+	else if constexpr (P == precision::medium)
+		p = horner(z2, 9.999956489e-1f, -3.329946399e-1f, 1.956361979e-1f, -1.212396771e-1f, 5.747791380e-2f, -1.348068565e-2f);
+	else
+		p = horner(z2, 9.999998808e-1f, -3.333199024e-1f, 1.996972561e-1f, -1.401949227e-1f,
+			9.914318472e-2f, -5.948672816e-2f, 2.425262332e-2f, -4.693333991e-3f);
+	return z * p;
+}
+
+/** asin(s) = s + s^3 P(s^2) on [0, 1/2], z = s^2 */
+template <precision P, typename F>
+inline F asin_poly(const F& s, const F& z)
+{
+	F p;
+	if constexpr (P == precision::low)
+		p = horner(z, 1.650577486e-1f, 9.429872036e-2f);
+	else if constexpr (P == precision::medium)
+		p = horner(z, 1.668012589e-1f, 7.189978659e-2f, 6.410734355e-2f);
+	else
+		p = horner(z, 1.666675210e-1f, 7.495297492e-2f, 4.547037929e-2f, 2.417950146e-2f, 4.216632992e-2f);
+	return madd(s * z, p, s);
+}
+
+/**
+ * asin(|x|) as s + s^3 P(s^2), split at 1/2: above it asin(a) = pi/2 - 2 asin(sqrt((1 - a) / 2))
+ * big tells the caller which form p is in
+ */
+template <precision P, typename F>
+inline F asin_reduced(const F& a, decltype(a > a)& big)
+{
+	big = a > F(0.5f);
+	F z = select(big, (F(1.0f) - a) * F(0.5f), a * a);
+	F s = select(big, sqrt(z), a);
+	return asin_poly<P>(s, z);
+}
+
+}
+
+/* ---------------------------------------------------------------------------------- */
+
+/** Both at once, they share the range reduction and the quadrant logic */
+template <precision P = precision::high, lane_type F>
+inline void sincos(const F& x, F& s, F& c)
+{
+	using namespace detail;
+
+	F r, t = reduce_half_pi(x, r);
+	F r2 = r * r;
+	F ps = sin_poly<P>(r, r2);
+	F pc = cos_poly<P>(r2);
+
+	// quadrant k mod 4: odd swaps sin and cos, sin flips on 2 and 3, cos on 1 and 2 (k + 1)
+	auto odd = bit_mask<0>(t);
+	s = xorsign(select(odd, pc, ps), bit_sign<1>(t));
+	c = xorsign(select(odd, ps, pc), bit_sign<1>(t + F(1.0f)));
+}
+
+template <precision P = precision::high, lane_type F>
+inline F sin(const F& x)
+{
+	using namespace detail;
+
+	if constexpr (std::is_same_v<F, float>)
+	{
+		// a single lane only needs the polynomial of its quadrant
+		float r, t = reduce_half_pi(x, r);
+		float p = bit_mask<0>(t) ? cos_poly<P>(r * r) : sin_poly<P>(r, r * r);
+		return xorsign(p, bit_sign<1>(t));
+	}
+	else
+	{
+		F s, c;
+		sincos<P>(x, s, c);
+		return s;
+	}
+}
+
+template <precision P = precision::high, lane_type F>
+inline F cos(const F& x)
+{
+	using namespace detail;
+
+	if constexpr (std::is_same_v<F, float>)
+	{
+		float r, t = reduce_half_pi(x, r);
+		float p = bit_mask<0>(t) ? sin_poly<P>(r, r * r) : cos_poly<P>(r * r);
+		return xorsign(p, bit_sign<1>(t + 1.0f));
+	}
+	else
+	{
+		F s, c;
+		sincos<P>(x, s, c);
+		return c;
+	}
+}
+
+template <precision P = precision::high, lane_type F>
+inline F tan(const F& x)
+{
+	F s, c;
+	sincos<P>(x, s, c);
+	return s / c;
+}
+
+template <precision P = precision::high, lane_type F>
+inline F asin(const F& x)
+{
+	using namespace detail;
+
+	decltype(x > x) big;
+	F p = asin_reduced<P>(abs(x), big);
+	return xorsign(select(big, madd(p, F(-2.0f), F(half_pi)), p), x);
+}
+
+template <precision P = precision::high, lane_type F>
+inline F acos(const F& x)
+{
+	using namespace detail;
+
+	decltype(x > x) big;
+	F p = asin_reduced<P>(abs(x), big);
+
+	// |x| <= 1/2: pi/2 - asin(x), above: 2 asin(s) mirrored to pi - 2 asin(s) for x < 0
+	F small = F(half_pi) - xorsign(p, x);
+	F large = p * F(2.0f);
+	large = select(x < F(0.0f), F(pi) - large, large);
+	return select(big, large, small);
+}
+
+template <precision P = precision::high, lane_type F>
+inline F atan(const F& x)
+{
+	using namespace detail;
+
+	F a = abs(x);
+	auto inv = a > F(1.0f);
+	F p = atan_poly<P>(select(inv, F(1.0f) / a, a));
+	return xorsign(select(inv, F(half_pi) - p, p), x);
+}
+
+template <precision P = precision::high, lane_type F>
+inline F atan2(const F& y, const F& x)
+{
+	using namespace detail;
+
+	F ax = abs(x);
+	F ay = abs(y);
+	F hi = max(ax, ay);
+	F z = select(hi > F(0.0f), min(ax, ay) / hi, F(0.0f));
+
+	F r = atan_poly<P>(z);
+	r = select(ay > ax, F(half_pi) - r, r);
+	r = select(x < F(0.0f), F(pi) - r, r);
+	return xorsign(r, y);
+}
+
+/** 1 / sqrt(x) for x > 0: the hardware estimate, refined by a Newton step above the low tier */
+template <precision P = precision::high, lane_type F>
+inline F rsqrt(const F& x)
+{
+	using namespace detail;
+
+	F e = rsqrt_estimate(x);
+	if constexpr (P != precision::low)
+		e = e * (F(1.5f) - F(0.5f) * x * e * e);
+#if !defined(__SSE__)
+	// the bit trick estimate starts a few bits short of rsqrtps, one more step catches up
+	if constexpr (P == precision::high)
+		e = e * (F(1.5f) - F(0.5f) * x * e * e);
+#endif
+	return e;
+}
+
+/* ---------------------------------------------------------------------------------- */
+/* raw registers                                                                      */
+/* ---------------------------------------------------------------------------------- */
+
+#if defined(__SSE__)
+template <precision P = precision::high> inline void sincos(__m128 x, __m128& s, __m128& c) { floatx4 fs, fc; sincos<P>(floatx4(x), fs, fc); s = fs.v; c = fc.v; }
+template <precision P = precision::high> inline __m128 sin(__m128 x) { return sin<P>(floatx4(x)).v; }
+template <precision P = precision::high> inline __m128 cos(__m128 x) { return cos<P>(floatx4(x)).v; }
+template <precision P = precision::high> inline __m128 tan(__m128 x) { return tan<P>(floatx4(x)).v; }
+template <precision P = precision::high> inline __m128 asin(__m128 x) { return asin<P>(floatx4(x)).v; }
+template <precision P = precision::high> inline __m128 acos(__m128 x) { return acos<P>(floatx4(x)).v; }
+template <precision P = precision::high> inline __m128 atan(__m128 x) { return atan<P>(floatx4(x)).v; }
+template <precision P = precision::high> inline __m128 atan2(__m128 y, __m128 x) { return atan2<P>(floatx4(y), floatx4(x)).v; }
+template <precision P = precision::high> inline __m128 rsqrt(__m128 x) { return rsqrt<P>(floatx4(x)).v; }
+#endif
+
+#if defined(__AVX__)
+template <precision P = precision::high> inline void sincos(__m256 x, __m256& s, __m256& c) { floatx8 fs, fc; sincos<P>(floatx8(x), fs, fc); s = fs.v; c = fc.v; }
+template <precision P = precision::high> inline __m256 sin(__m256 x) { return sin<P>(floatx8(x)).v; }
+template <precision P = precision::high> inline __m256 cos(__m256 x) { return cos<P>(floatx8(x)).v; }
+template <precision P = precision::high> inline __m256 tan(__m256 x) { return tan<P>(floatx8(x)).v; }
+template <precision P = precision::high> inline __m256 asin(__m256 x) { return asin<P>(floatx8(x)).v; }
+template <precision P = precision::high> inline __m256 acos(__m256 x) { return acos<P>(floatx8(x)).v; }
+template <precision P = precision::high> inline __m256 atan(__m256 x) { return atan<P>(floatx8(x)).v; }
+template <precision P = precision::high> inline __m256 atan2(__m256 y, __m256 x) { return atan2<P>(floatx8(y), floatx8(x)).v; }
+template <precision P = precision::high> inline __m256 rsqrt(__m256 x) { return rsqrt<P>(floatx8(x)).v; }
+#endif
+
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE__)
+#include <immintrin.h>
+#endif
+
+namespace cu::math {
+
+/**
+ * 4-lane float packet, one lane per ray / vertex
+ * Used as the component type of the SoA packets (vec3x4)
+ * https://www.intel.com/content/www/us/en/docs/intrinsics-guide/index.html#techs=SSE_ALL
+ */
+struct alignas(16) maskx4
+{
+#if defined(__SSE__)
+	__m128 v;
+
+	maskx4() { v = _mm_setzero_ps(); }
+	explicit maskx4(__m128 m) : v(m) {}
+	explicit maskx4(bool b) { v = b ? _mm_castsi128_ps(_mm_set1_epi32(-1)) : _mm_setzero_ps(); }
+
+	inline maskx4 operator&(const maskx4& o) const { return maskx4(_mm_and_ps(v, o.v)); }
+	inline maskx4 operator|(const maskx4& o) const { return maskx4(_mm_or_ps(v, o.v)); }
+	inline maskx4 operator^(const maskx4& o) const { return maskx4(_mm_xor_ps(v, o.v)); }
+	inline maskx4 operator~() const { return maskx4(_mm_xor_ps(v, _mm_castsi128_ps(_mm_set1_epi32(-1)))); }
+
+	/** one bit per lane, lane 0 in bit 0 */
+	inline int bits() const { return _mm_movemask_ps(v); }
+#else
+	std::uint32_t l[4];
+
+	maskx4() : l{0, 0, 0, 0} {}
+	explicit maskx4(bool b) { for (int i = 0; i < 4; ++i) l[i] = b ? ~0u : 0u; }
+
+	inline maskx4 operator&(const maskx4& o) const { maskx4 r; for (int i = 0; i < 4; ++i) r.l[i] = l[i] & o.l[i]; return r; }
+	inline maskx4 operator|(const maskx4& o) const { maskx4 r; for (int i = 0; i < 4; ++i) r.l[i] = l[i] | o.l[i]; return r; }
+	inline maskx4 operator^(const maskx4& o) const { maskx4 r; for (int i = 0; i < 4; ++i) r.l[i] = l[i] ^ o.l[i]; return r; }
+	inline maskx4 operator~() const { maskx4 r; for (int i = 0; i < 4; ++i) r.l[i] = ~l[i]; return r; }
+
+	inline int bits() const { int b = 0; for (int i = 0; i < 4; ++i) b |= (l[i] >> 31) << i; return b; }
+#endif
+
+	inline bool any() const { return bits() != 0; }
+	inline bool all() const { return bits() == 0xF; }
+	inline bool none() const { return bits() == 0; }
+};
+
+struct alignas(16) floatx4
+{
+	static constexpr int width = 4;
+	using mask = maskx4;
+
+#if defined(__SSE__)
+	__m128 v;
+
+	floatx4() { v = _mm_setzero_ps(); }
+	floatx4(float n) { v = _mm_set1_ps(n); }
+	floatx4(float a, float b, float c, float d) { v = _mm_set_ps(d, c, b, a); }
+	explicit floatx4(__m128 m) : v(m) {}
+
+	static inline floatx4 load(const float* p) { return floatx4(_mm_loadu_ps(p)); }
+	inline void store(float* p) const { _mm_storeu_ps(p, v); }
+
+	inline float operator[](int i) const { alignas(16) float t[4]; _mm_store_ps(t, v); return t[i]; }
+
+	inline floatx4 operator+(const floatx4& o) const { return floatx4(_mm_add_ps(v, o.v)); }
+	inline floatx4 operator-(const floatx4& o) const { return floatx4(_mm_sub_ps(v, o.v)); }
+	inline floatx4 operator*(const floatx4& o) const { return floatx4(_mm_mul_ps(v, o.v)); }
+	inline floatx4 operator/(const floatx4& o) const { return floatx4(_mm_div_ps(v, o.v)); }
+	inline floatx4 operator-() const { return floatx4(_mm_xor_ps(v, _mm_set1_ps(-0.0f))); }
+
+	inline maskx4 operator<(const floatx4& o) const { return maskx4(_mm_cmplt_ps(v, o.v)); }
+	inline maskx4 operator<=(const floatx4& o) const { return maskx4(_mm_cmple_ps(v, o.v)); }
+	inline maskx4 operator>(const floatx4& o) const { return maskx4(_mm_cmpgt_ps(v, o.v)); }
+	inline maskx4 operator>=(const floatx4& o) const { return maskx4(_mm_cmpge_ps(v, o.v)); }
+	inline maskx4 operator==(const floatx4& o) const { return maskx4(_mm_cmpeq_ps(v, o.v)); }
+	inline maskx4 operator!=(const floatx4& o) const { return maskx4(_mm_cmpneq_ps(v, o.v)); }
+
+	static inline floatx4 min(const floatx4& a, const floatx4& b) { return floatx4(_mm_min_ps(a.v, b.v)); }
+	static inline floatx4 max(const floatx4& a, const floatx4& b) { return floatx4(_mm_max_ps(a.v, b.v)); }
+	static inline floatx4 sqrt(const floatx4& a) { return floatx4(_mm_sqrt_ps(a.v)); }
+	static inline floatx4 abs(const floatx4& a) { return floatx4(_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)); }
+
+	/** a * b + c, fused when FMA is available */
+	static inline floatx4 fmadd(const floatx4& a, const floatx4& b, const floatx4& c)
+	{
+	#if defined(__FMA__)
+		return floatx4(_mm_fmadd_ps(a.v, b.v, c.v));
+	#else
+		return floatx4(_mm_add_ps(_mm_mul_ps(a.v, b.v), c.v));
+	#endif
+	}
+
+	/** 1 / sqrt(a), hardware estimate refined with one Newton-Raphson step */
+	static inline floatx4 rsqrt(const floatx4& a)
+	{
+		__m128 e = _mm_rsqrt_ps(a.v);
+		__m128 half_a = _mm_mul_ps(_mm_set1_ps(0.5f), a.v);
+		__m128 t = _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(half_a, _mm_mul_ps(e, e)));
+		return floatx4(_mm_mul_ps(e, t));
+	}
+
+	/** m ? a : b, per lane */
+	static inline floatx4 select(const maskx4& m, const floatx4& a, const floatx4& b)
+	{
+	#if defined(__SSE4_1__)
+		return floatx4(_mm_blendv_ps(b.v, a.v, m.v));
+	#else
+		return floatx4(_mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v)));
+	#endif
+	}
+#else
+	float l[4];
+
+	floatx4() : l{0, 0, 0, 0} {}
+	floatx4(float n) : l{n, n, n, n} {}
+	floatx4(float a, float b, float c, float d) : l{a, b, c, d} {}
+
+	static inline floatx4 load(const float* p) { return {p[0], p[1], p[2], p[3]}; }
+	inline void store(float* p) const { for (int i = 0; i < 4; ++i) p[i] = l[i]; }
+
+	inline float operator[](int i) const { return l[i]; }
+
+	inline floatx4 operator+(const floatx4& o) const { return {l[0] + o.l[0], l[1] + o.l[1], l[2] + o.l[2], l[3] + o.l[3]}; }
+	inline floatx4 operator-(const floatx4& o) const { return {l[0] - o.l[0], l[1] - o.l[1], l[2] - o.l[2], l[3] - o.l[3]}; }
+	inline floatx4 operator*(const floatx4& o) const { return {l[0] * o.l[0], l[1] * o.l[1], l[2] * o.l[2], l[3] * o.l[3]}; }
+	inline floatx4 operator/(const floatx4& o) const { return {l[0] / o.l[0], l[1] / o.l[1], l[2] / o.l[2], l[3] / o.l[3]}; }
+	inline floatx4 operator-() const { return {-l[0], -l[1], -l[2], -l[3]}; }
+
+	#define CU_FLOATX4_CMP(op) \
+		inline maskx4 operator op(const floatx4& o) const { \
+			maskx4 r; for (int i = 0; i < 4; ++i) r.l[i] = (l[i] op o.l[i]) ? ~0u : 0u; return r; }
+	CU_FLOATX4_CMP(<)
+	CU_FLOATX4_CMP(<=)
+	CU_FLOATX4_CMP(>)
+	CU_FLOATX4_CMP(>=)
+	CU_FLOATX4_CMP(==)
+	CU_FLOATX4_CMP(!=)
+	#undef CU_FLOATX4_CMP
+
+	static inline floatx4 min(const floatx4& a, const floatx4& b)
+	{
+		floatx4 r; for (int i = 0; i < 4; ++i) r.l[i] = a.l[i] < b.l[i] ? a.l[i] : b.l[i]; return r;
+	}
+	static inline floatx4 max(const floatx4& a, const floatx4& b)
+	{
+		floatx4 r; for (int i = 0; i < 4; ++i) r.l[i] = a.l[i] > b.l[i] ? a.l[i] : b.l[i]; return r;
+	}
+	static inline floatx4 sqrt(const floatx4& a) { return {std::sqrt(a.l[0]), std::sqrt(a.l[1]), std::sqrt(a.l[2]), std::sqrt(a.l[3])}; }
+	static inline floatx4 abs(const floatx4& a) { return {std::fabs(a.l[0]), std::fabs(a.l[1]), std::fabs(a.l[2]), std::fabs(a.l[3])}; }
+	static inline floatx4 fmadd(const floatx4& a, const floatx4& b, const floatx4& c) { return a * b + c; }
+	static inline floatx4 rsqrt(const floatx4& a) { return floatx4(1.0f) / sqrt(a); }
+
+	static inline floatx4 select(const maskx4& m, const floatx4& a, const floatx4& b)
+	{
+		floatx4 r; for (int i = 0; i < 4; ++i) r.l[i] = m.l[i] ? a.l[i] : b.l[i]; return r;
+	}
+#endif
+
+	inline floatx4& operator+=(const floatx4& o) { *this = *this + o; return *this; }
+	inline floatx4& operator-=(const floatx4& o) { *this = *this - o; return *this; }
+	inline floatx4& operator*=(const floatx4& o) { *this = *this * o; return *this; }
+};
+
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "math/floatx4.hpp"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+namespace cu::math {
+
+/**
+ * 8-lane float packet, AVX when available, otherwise two floatx4 halves
+ * https://www.intel.com/content/www/us/en/docs/intrinsics-guide/index.html#techs=AVX_ALL
+ */
+struct alignas(32) maskx8
+{
+#if defined(__AVX__)
+	__m256 v;
+
+	maskx8() { v = _mm256_setzero_ps(); }
+	explicit maskx8(__m256 m) : v(m) {}
+	explicit maskx8(bool b) { v = b ? _mm256_castsi256_ps(_mm256_set1_epi32(-1)) : _mm256_setzero_ps(); }
+
+	inline maskx8 operator&(const maskx8& o) const { return maskx8(_mm256_and_ps(v, o.v)); }
+	inline maskx8 operator|(const maskx8& o) const { return maskx8(_mm256_or_ps(v, o.v)); }
+	inline maskx8 operator^(const maskx8& o) const { return maskx8(_mm256_xor_ps(v, o.v)); }
+	inline maskx8 operator~() const { return maskx8(_mm256_xor_ps(v, _mm256_castsi256_ps(_mm256_set1_epi32(-1)))); }
+
+	inline int bits() const { return _mm256_movemask_ps(v); }
+#else
+	maskx4 lo, hi;
+
+	maskx8() {}
+	maskx8(const maskx4& lo, const maskx4& hi) : lo(lo), hi(hi) {}
+	explicit maskx8(bool b) : lo(b), hi(b) {}
+
+	inline maskx8 operator&(const maskx8& o) const { return {lo & o.lo, hi & o.hi}; }
+	inline maskx8 operator|(const maskx8& o) const { return {lo | o.lo, hi | o.hi}; }
+	inline maskx8 operator^(const maskx8& o) const { return {lo ^ o.lo, hi ^ o.hi}; }
+	inline maskx8 operator~() const { return {~lo, ~hi}; }
+
+	inline int bits() const { return lo.bits() | (hi.bits() << 4); }
+#endif
+
+	inline bool any() const { return bits() != 0; }
+	inline bool all() const { return bits() == 0xFF; }
+	inline bool none() const { return bits() == 0; }
+};
+
+struct alignas(32) floatx8
+{
+	static constexpr int width = 8;
+	using mask = maskx8;
+
+#if defined(__AVX__)
+	__m256 v;
+
+	floatx8() { v = _mm256_setzero_ps(); }
+	floatx8(float n) { v = _mm256_set1_ps(n); }
+	floatx8(float a, float b, float c, float d, float e, float f, float g, float h) { v = _mm256_set_ps(h, g, f, e, d, c, b, a); }
+	explicit floatx8(__m256 m) : v(m) {}
+
+	static inline floatx8 load(const float* p) { return floatx8(_mm256_loadu_ps(p)); }
+	inline void store(float* p) const { _mm256_storeu_ps(p, v); }
+
+	inline float operator[](int i) const { alignas(32) float t[8]; _mm256_store_ps(t, v); return t[i]; }
+
+	inline floatx8 operator+(const floatx8& o) const { return floatx8(_mm256_add_ps(v, o.v)); }
+	inline floatx8 operator-(const floatx8& o) const { return floatx8(_mm256_sub_ps(v, o.v)); }
+	inline floatx8 operator*(const floatx8& o) const { return floatx8(_mm256_mul_ps(v, o.v)); }
+	inline floatx8 operator/(const floatx8& o) const { return floatx8(_mm256_div_ps(v, o.v)); }
+	inline floatx8 operator-() const { return floatx8(_mm256_xor_ps(v, _mm256_set1_ps(-0.0f))); }
+
+	inline maskx8 operator<(const floatx8& o) const { return maskx8(_mm256_cmp_ps(v, o.v, _CMP_LT_OQ)); }
+	inline maskx8 operator<=(const floatx8& o) const { return maskx8(_mm256_cmp_ps(v, o.v, _CMP_LE_OQ)); }
+	inline maskx8 operator>(const floatx8& o) const { return maskx8(_mm256_cmp_ps(v, o.v, _CMP_GT_OQ)); }
+	inline maskx8 operator>=(const floatx8& o) const { return maskx8(_mm256_cmp_ps(v, o.v, _CMP_GE_OQ)); }
+	inline maskx8 operator==(const floatx8& o) const { return maskx8(_mm256_cmp_ps(v, o.v, _CMP_EQ_OQ)); }
+	inline maskx8 operator!=(const floatx8& o) const { return maskx8(_mm256_cmp_ps(v, o.v, _CMP_NEQ_UQ)); }
+
+	static inline floatx8 min(const floatx8& a, const floatx8& b) { return floatx8(_mm256_min_ps(a.v, b.v)); }
+	static inline floatx8 max(const floatx8& a, const floatx8& b) { return floatx8(_mm256_max_ps(a.v, b.v)); }
+	static inline floatx8 sqrt(const floatx8& a) { return floatx8(_mm256_sqrt_ps(a.v)); }
+	static inline floatx8 abs(const floatx8& a) { return floatx8(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v)); }
+
+	static inline floatx8 fmadd(const floatx8& a, const floatx8& b, const floatx8& c)
+	{
+	#if defined(__FMA__)
+		return floatx8(_mm256_fmadd_ps(a.v, b.v, c.v));
+	#else
+		return floatx8(_mm256_add_ps(_mm256_mul_ps(a.v, b.v), c.v));
+	#endif
+	}
+
+	static inline floatx8 rsqrt(const floatx8& a)
+	{
+		__m256 e = _mm256_rsqrt_ps(a.v);
+		__m256 half_a = _mm256_mul_ps(_mm256_set1_ps(0.5f), a.v);
+		__m256 t = _mm256_sub_ps(_mm256_set1_ps(1.5f), _mm256_mul_ps(half_a, _mm256_mul_ps(e, e)));
+		return floatx8(_mm256_mul_ps(e, t));
+	}
+
+	static inline floatx8 select(const maskx8& m, const floatx8& a, const floatx8& b)
+	{
+		return floatx8(_mm256_blendv_ps(b.v, a.v, m.v));
+	}
+#else
+	floatx4 lo, hi;
+
+	floatx8() {}
+	floatx8(float n) : lo(n), hi(n) {}
+	floatx8(float a, float b, float c, float d, float e, float f, float g, float h) : lo(a, b, c, d), hi(e, f, g, h) {}
+	floatx8(const floatx4& lo, const floatx4& hi) : lo(lo), hi(hi) {}
+
+	static inline floatx8 load(const float* p) { return {floatx4::load(p), floatx4::load(p + 4)}; }
+	inline void store(float* p) const { lo.store(p); hi.store(p + 4); }
+
+	inline float operator[](int i) const { return i < 4 ? lo[i] : hi[i - 4]; }
+
+	inline floatx8 operator+(const floatx8& o) const { return {lo + o.lo, hi + o.hi}; }
+	inline floatx8 operator-(const floatx8& o) const { return {lo - o.lo, hi - o.hi}; }
+	inline floatx8 operator*(const floatx8& o) const { return {lo * o.lo, hi * o.hi}; }
+	inline floatx8 operator/(const floatx8& o) const { return {lo / o.lo, hi / o.hi}; }
+	inline floatx8 operator-() const { return {-lo, -hi}; }
+
+	inline maskx8 operator<(const floatx8& o) const { return {lo < o.lo, hi < o.hi}; }
+	inline maskx8 operator<=(const floatx8& o) const { return {lo <= o.lo, hi <= o.hi}; }
+	inline maskx8 operator>(const floatx8& o) const { return {lo > o.lo, hi > o.hi}; }
+	inline maskx8 operator>=(const floatx8& o) const { return {lo >= o.lo, hi >= o.hi}; }
+	inline maskx8 operator==(const floatx8& o) const { return {lo == o.lo, hi == o.hi}; }
+	inline maskx8 operator!=(const floatx8& o) const { return {lo != o.lo, hi != o.hi}; }
+
+	static inline floatx8 min(const floatx8& a, const floatx8& b) { return {floatx4::min(a.lo, b.lo), floatx4::min(a.hi, b.hi)}; }
+	static inline floatx8 max(const floatx8& a, const floatx8& b) { return {floatx4::max(a.lo, b.lo), floatx4::max(a.hi, b.hi)}; }
+	static inline floatx8 sqrt(const floatx8& a) { return {floatx4::sqrt(a.lo), floatx4::sqrt(a.hi)}; }
+	static inline floatx8 abs(const floatx8& a) { return {floatx4::abs(a.lo), floatx4::abs(a.hi)}; }
+	static inline floatx8 fmadd(const floatx8& a, const floatx8& b, const floatx8& c)
+	{
+		return {floatx4::fmadd(a.lo, b.lo, c.lo), floatx4::fmadd(a.hi, b.hi, c.hi)};
+	}
+	static inline floatx8 rsqrt(const floatx8& a) { return {floatx4::rsqrt(a.lo), floatx4::rsqrt(a.hi)}; }
+
+	static inline floatx8 select(const maskx8& m, const floatx8& a, const floatx8& b)
+	{
+		return {floatx4::select(m.lo, a.lo, b.lo), floatx4::select(m.hi, a.hi, b.hi)};
+	}
+#endif
+
+	inline floatx8& operator+=(const floatx8& o) { *this = *this + o; return *this; }
+	inline floatx8& operator-=(const floatx8& o) { *this = *this - o; return *this; }
+	inline floatx8& operator*=(const floatx8& o) { *this = *this * o; return *this; }
+};
+
+}
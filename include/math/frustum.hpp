@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "math/mat4.hpp"
+#include "math/ray.hpp"
+
+namespace cu::math {
+
+/** Clip-space depth of the projection the planes are extracted from */
+enum class clip_depth
+{
+	negative_one_to_one,	// OpenGL, what perspective() produces
+	zero_to_one				// Vulkan / D3D
+};
+
+/**
+ * View frustum as 6 planes, normals pointing inside and normalized so that
+ * dot(n, p) + d is a signed distance
+ *
+ * Planes come straight from the view-projection matrix (Gribb / Hartmann): with
+ * clip = p * m (mul_vec layout, lookAt() * perspective()), clip component j is
+ * dot(p, column j), so the half-spaces -w <= x <= w ... are column 3 +- column j.
+ * Matrices in the translate() layout need a transpose() first
+ * https://www.gamedevs.org/uploads/fast-extraction-viewing-frustum-planes-from-world-view-projection-matrix.pdf
+ *
+ * bottom / top are clip-space -y / +y: perspective() flips y for Vulkan, so there
+ * bottom is the top edge of the viewport. The culling result does not depend on it
+ *
+ * Sphere and box tests are conservative: objects outside the frustum near its edges
+ * and corners can be reported visible, never the other way around
+ */
+struct frustum
+{
+	enum plane_index { left, right, bottom, top, near, far };
+
+	vec4 planes[6];	// xyz normal, w offset
+
+	frustum() {}
+	explicit frustum(const mat4& view_proj, clip_depth depth = clip_depth::negative_one_to_one)
+	{
+		vec4 col[4];
+		for (int j = 0; j < 4; ++j)
+			col[j] = vec4(view_proj.m[0][j], view_proj.m[1][j], view_proj.m[2][j], view_proj.m[3][j]);
+
+		planes[left] = col[3] + col[0];
+		planes[right] = col[3] - col[0];
+		planes[bottom] = col[3] + col[1];
+		planes[top] = col[3] - col[1];
+		planes[near] = depth == clip_depth::zero_to_one ? col[2] : col[3] + col[2];
+		planes[far] = col[3] - col[2];
+
+		// an infinite far plane has a zero normal and accepts everything, left as is
+		for (vec4& p : planes)
+		{
+			float l2 = p.x * p.x + p.y * p.y + p.z * p.z;
+			if (l2 > 0.0f)
+				p = p * (1.0f / std::sqrt(l2));
+		}
+	}
+
+	inline float distance(int plane, const vec3& p) const
+	{
+		const vec4& n = planes[plane];
+		return n.x * p.x + n.y * p.y + n.z * p.z + n.w;
+	}
+
+	inline bool contains(const vec3& p) const
+	{
+		for (int i = 0; i < 6; ++i)
+			if (distance(i, p) < 0.0f)
+				return false;
+		return true;
+	}
+
+	inline bool intersects(const vec3& center, float radius) const
+	{
+		for (int i = 0; i < 6; ++i)
+			if (distance(i, center) < -radius)
+				return false;
+		return true;
+	}
+
+	/** Only the corner furthest along each normal (p-vertex) is tested */
+	inline bool intersects(const aabb& b) const
+	{
+		for (int i = 0; i < 6; ++i)
+		{
+			const vec4& n = planes[i];
+			vec3 p(n.x >= 0.0f ? b.max.x : b.min.x, n.y >= 0.0f ? b.max.y : b.min.y, n.z >= 0.0f ? b.max.z : b.min.z);
+			if (distance(i, p) < 0.0f)
+				return false;
+		}
+		return true;
+	}
+};
+
+/**
+ * Batched culling over SoA spans, 8 objects per iteration
+ * Bit i of visible (word i / 64, bit i % 64) is set when object i may be visible,
+ * bits past the object count are cleared. visible needs (count + 63) / 64 words
+ * All spans of one call must have the same size, returns the number of visible objects
+ */
+std::size_t cull_spheres(const frustum& f,
+	std::span<const float> x, std::span<const float> y, std::span<const float> z, std::span<const float> radius,
+	std::span<std::uint64_t> visible);
+
+std::size_t cull_aabbs(const frustum& f,
+	std::span<const float> min_x, std::span<const float> min_y, std::span<const float> min_z,
+	std::span<const float> max_x, std::span<const float> max_y, std::span<const float> max_z,
+	std::span<std::uint64_t> visible);
+
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+namespace cu::math {
+
+namespace detail {
+
+/**
+ * IEEE 754 binary16 <-> binary32, round to nearest even, NaN stays NaN
+ * Bit tricks from https://gist.github.com/rygorous/2156668 so they also work
+ * in constant evaluation, F16C is used at runtime when available
+ */
+constexpr std::uint16_t float_to_half(float f)
+{
+	constexpr std::uint32_t f32_infinity = 255u << 23;
+	constexpr std::uint32_t f16_max = (127u + 16u) << 23;
+	constexpr std::uint32_t denorm_magic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+	std::uint32_t u = std::bit_cast<std::uint32_t>(f);
+	std::uint32_t sign = u & 0x80000000u;
+	u ^= sign;
+
+	std::uint32_t h;
+	if (u >= f16_max)
+		h = u > f32_infinity ? 0x7e00u : 0x7c00u;
+	else if (u < (113u << 23))
+	{
+		// align the 10 mantissa bits at the bottom, the float add does the rounding
+		float r = std::bit_cast<float>(u) + std::bit_cast<float>(denorm_magic);
+		h = std::bit_cast<std::uint32_t>(r) - denorm_magic;
+	}
+	else
+	{
+		std::uint32_t mant_odd = (u >> 13) & 1u;
+		u += (static_cast<std::uint32_t>(15 - 127) << 23) + 0xfffu + mant_odd;
+		h = u >> 13;
+	}
+	return static_cast<std::uint16_t>(h | (sign >> 16));
+}
+
+constexpr float half_to_float(std::uint16_t h)
+{
+	constexpr std::uint32_t shifted_exp = 0x7c00u << 13;
+
+	std::uint32_t u = (h & 0x7fffu) << 13;
+	std::uint32_t exp = u & shifted_exp;
+	u += (127u - 15u) << 23;
+
+	if (exp == shifted_exp)
+		u += (128u - 16u) << 23;
+	else if (exp == 0)
+	{
+		u += 1u << 23;
+		u = std::bit_cast<std::uint32_t>(std::bit_cast<float>(u) - std::bit_cast<float>(113u << 23));
+	}
+	return std::bit_cast<float>(u | (static_cast<std::uint32_t>(h & 0x8000u) << 16));
+}
+
+}
+
+/**
+ * Half precision storage type, arithmetic goes through float
+ * Converting from float is implicit, back to float is explicit so that
+ * half + float picks the half operators instead of being ambiguous
+ */
+struct half
+{
+	std::uint16_t bits = 0;
+
+	constexpr half() = default;
+	constexpr half(float f) : bits(to_bits(f)) {}
+
+	static constexpr half from_bits(std::uint16_t b) { half h; h.bits = b; return h; }
+
+	explicit constexpr operator float() const
+	{
+	#if defined(__F16C__)
+		if (!std::is_constant_evaluated())
+			return _cvtsh_ss(bits);
+	#endif
+		return detail::half_to_float(bits);
+	}
+
+	constexpr half operator-() const { return from_bits(bits ^ 0x8000u); }
+
+	constexpr half operator+(half o) const { return float(*this) + float(o); }
+	constexpr half operator-(half o) const { return float(*this) - float(o); }
+	constexpr half operator*(half o) const { return float(*this) * float(o); }
+	constexpr half operator/(half o) const { return float(*this) / float(o); }
+
+	constexpr half& operator+=(half o) { return *this = *this + o; }
+	constexpr half& operator-=(half o) { return *this = *this - o; }
+	constexpr half& operator*=(half o) { return *this = *this * o; }
+	constexpr half& operator/=(half o) { return *this = *this / o; }
+
+	constexpr bool operator==(half o) const { return float(*this) == float(o); }
+	constexpr bool operator<(half o) const { return float(*this) < float(o); }
+	constexpr bool operator>(half o) const { return float(*this) > float(o); }
+	constexpr bool operator<=(half o) const { return float(*this) <= float(o); }
+	constexpr bool operator>=(half o) const { return float(*this) >= float(o); }
+
+private:
+	static constexpr std::uint16_t to_bits(float f)
+	{
+	#if defined(__F16C__)
+		if (!std::is_constant_evaluated())
+			return _cvtss_sh(f, _MM_FROUND_TO_NEAREST_INT);
+	#endif
+		return detail::float_to_half(f);
+	}
+};
+
+static_assert(sizeof(half) == 2);
+
+}
@@ -0,0 +1,337 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <span>
+
+#include "math/ray.hpp"
+#include "math/vec3x.hpp"
+
+namespace cu::math {
+
+namespace detail {
+
+inline float axis(const vec3& v, int k) { return k == 0 ? v.x : (k == 1 ? v.y : v.z); }
+
+template <typename F>
+inline const F& axis(const vec3xN<F>& v, int k) { return k == 0 ? v.x : (k == 1 ? v.y : v.z); }
+
+/**
+ * Conservative slab rounding, tfar is scaled by 1 + 2 * gamma(3) so that
+ * grazing rays never miss a box they touch
+ * https://pbr-book.org/4ed/Shapes/Basic_Shape_Interface#RayndashBoundsIntersections
+ */
+inline constexpr float slab_tfar_scale = 1.0f + 2.0f * (3.0f * std::numeric_limits<float>::epsilon() * 0.5f)
+	/ (1.0f - 3.0f * std::numeric_limits<float>::epsilon() * 0.5f);
+
+// NaN-ignoring min/max: the accumulator is returned when the slab value is NaN (0 * inf)
+inline float slab_min(float v, float acc) { return v < acc ? v : acc; }
+inline float slab_max(float v, float acc) { return v > acc ? v : acc; }
+
+/**
+ * a * b - c * d per lane, rounded once: float products are exact in double, so the
+ * result is the same whether or not the compiler contracts to FMA, and swapping (a, b)
+ * with (c, d), as the triangle across a shared edge does, negates it exactly
+ */
+inline floatx4 edge_function(const floatx4& a, const floatx4& b, const floatx4& c, const floatx4& d)
+{
+#if defined(__AVX__)
+	__m256d r = _mm256_sub_pd(_mm256_mul_pd(_mm256_cvtps_pd(a.v), _mm256_cvtps_pd(b.v)), _mm256_mul_pd(_mm256_cvtps_pd(c.v), _mm256_cvtps_pd(d.v)));
+	return floatx4(_mm256_cvtpd_ps(r));
+#elif defined(__SSE2__)
+	__m128d lo = _mm_sub_pd(_mm_mul_pd(_mm_cvtps_pd(a.v), _mm_cvtps_pd(b.v)), _mm_mul_pd(_mm_cvtps_pd(c.v), _mm_cvtps_pd(d.v)));
+	__m128d hi = _mm_sub_pd(
+		_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(a.v, a.v)), _mm_cvtps_pd(_mm_movehl_ps(b.v, b.v))),
+		_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(c.v, c.v)), _mm_cvtps_pd(_mm_movehl_ps(d.v, d.v))));
+	return floatx4(_mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi)));
+#else
+	alignas(16) float fa[4], fb[4], fc[4], fd[4], r[4];
+	a.store(fa); b.store(fb); c.store(fc); d.store(fd);
+	for (int i = 0; i < 4; ++i)
+		r[i] = static_cast<float>(static_cast<double>(fa[i]) * fb[i] - static_cast<double>(fc[i]) * fd[i]);
+	return floatx4::load(r);
+#endif
+}
+
+inline floatx8 edge_function(const floatx8& a, const floatx8& b, const floatx8& c, const floatx8& d)
+{
+#if defined(__AVX__)
+	floatx4 lo = edge_function(floatx4(_mm256_castps256_ps128(a.v)), floatx4(_mm256_castps256_ps128(b.v)),
+		floatx4(_mm256_castps256_ps128(c.v)), floatx4(_mm256_castps256_ps128(d.v)));
+	floatx4 hi = edge_function(floatx4(_mm256_extractf128_ps(a.v, 1)), floatx4(_mm256_extractf128_ps(b.v, 1)),
+		floatx4(_mm256_extractf128_ps(c.v, 1)), floatx4(_mm256_extractf128_ps(d.v, 1)));
+	return floatx8(_mm256_insertf128_ps(_mm256_castps128_ps256(lo.v), hi.v, 1));
+#else
+	return {edge_function(a.lo, b.lo, c.lo, d.lo), edge_function(a.hi, b.hi, c.hi, d.hi)};
+#endif
+}
+
+/**
+ * a * b - c * d per lane in float; near is set on the lanes whose sign rounding could
+ * have flipped, with or without FMA contraction (error <= gamma(2) * (|ab| + |cd|)),
+ * those are the lanes to redo with edge_function
+ */
+template <typename F>
+inline F edge_function_float(const F& a, const F& b, const F& c, const F& d, typename F::mask& near)
+{
+	F p = a * b;
+	F q = c * d;
+	F e = p - q;
+	F bound = (F::abs(p) + F::abs(q)) * F(4.0f * std::numeric_limits<float>::epsilon()) + F(std::numeric_limits<float>::min());
+	near = near | (F::abs(e) <= bound);
+	return e;
+}
+
+
+}
+
+struct tri_hit
+{
+	float t, u, v;	// u, v: barycentric weights of v1 and v2
+};
+
+/**
+ * Slab test, tnear/tfar are clipped to [r.tmin, r.tmax]
+ * Near/far planes are picked from the sign of the direction instead of sorting t0/t1,
+ * so empty boxes (min > max) never hit
+ * https://people.csail.mit.edu/amy/papers/box-jgt.pdf
+ */
+inline bool ray_aabb(const ray& r, const aabb& b, float& tnear, float& tfar)
+{
+	tnear = r.tmin;
+	tfar = r.tmax;
+
+	for (int k = 0; k < 3; ++k)
+	{
+		float o = detail::axis(r.origin, k);
+		float inv = detail::axis(r.inv_dir, k);
+		bool neg = inv < 0.0f;
+		float t0 = (detail::axis(neg ? b.max : b.min, k) - o) * inv;
+		float t1 = (detail::axis(neg ? b.min : b.max, k) - o) * inv;
+
+		tnear = detail::slab_max(t0, tnear);
+		tfar = detail::slab_min(t1 * detail::slab_tfar_scale, tfar);
+	}
+	return tnear <= tfar;
+}
+
+inline bool ray_aabb(const ray& r, const aabb& b)
+{
+	float tnear, tfar;
+	return ray_aabb(r, b, tnear, tfar);
+}
+
+/**
+ * Per-ray constants of the watertight ray/triangle test: the ray is mapped to +z
+ * by a permutation (kx, ky, kz) and a shear (sx, sy, sz), triangles are then tested
+ * in 2D with edge functions that never leak on shared edges
+ * http://jcgt.org/published/0002/01/05/paper.pdf
+ */
+struct watertight_ray
+{
+	vec3	origin;
+	float	tmin, tmax;
+	int		kx, ky, kz;
+	float	sx, sy, sz;
+
+	watertight_ray(const ray& r) : origin(r.origin), tmin(r.tmin), tmax(r.tmax)
+	{
+		vec3 a(std::fabs(r.dir.x), std::fabs(r.dir.y), std::fabs(r.dir.z));
+		kz = a.x > a.y ? (a.x > a.z ? 0 : 2) : (a.y > a.z ? 1 : 2);
+		kx = kz == 2 ? 0 : kz + 1;
+		ky = kx == 2 ? 0 : kx + 1;
+		if (detail::axis(r.dir, kz) < 0.0f)
+		{
+			int tmp = kx;
+			kx = ky;
+			ky = tmp;
+		}
+
+		float dz = detail::axis(r.dir, kz);
+		sx = detail::axis(r.dir, kx) / dz;
+		sy = detail::axis(r.dir, ky) / dz;
+		sz = 1.0f / dz;
+	}
+};
+
+/**
+ * Watertight ray/triangle (Woop, Benthin, Wald 2013), double sided
+ */
+inline bool ray_triangle(const watertight_ray& r, const vec3& v0, const vec3& v1, const vec3& v2, tri_hit& hit)
+{
+	vec3 a = v0 - r.origin;
+	vec3 b = v1 - r.origin;
+	vec3 c = v2 - r.origin;
+
+	float az = detail::axis(a, r.kz), bz = detail::axis(b, r.kz), cz = detail::axis(c, r.kz);
+	float ax = detail::axis(a, r.kx) - r.sx * az;
+	float ay = detail::axis(a, r.ky) - r.sy * az;
+	float bx = detail::axis(b, r.kx) - r.sx * bz;
+	float by = detail::axis(b, r.ky) - r.sy * bz;
+	float cx = detail::axis(c, r.kx) - r.sx * cz;
+	float cy = detail::axis(c, r.ky) - r.sy * cz;
+
+	// float products are exact in double, so the edge functions are rounded once
+	// and stay consistent on shared edges even when the compiler contracts to FMA
+	float u = static_cast<float>(static_cast<double>(cx) * by - static_cast<double>(cy) * bx);
+	float v = static_cast<float>(static_cast<double>(ax) * cy - static_cast<double>(ay) * cx);
+	float w = static_cast<float>(static_cast<double>(bx) * ay - static_cast<double>(by) * ax);
+
+	if ((u < 0.0f || v < 0.0f || w < 0.0f) && (u > 0.0f || v > 0.0f || w > 0.0f))
+		return false;
+
+	float det = u + v + w;
+	if (det == 0.0f)
+		return false;
+
+	float inv_det = 1.0f / det;
+	float t = (u * r.sz * az + v * r.sz * bz + w * r.sz * cz) * inv_det;
+	if (!(t >= r.tmin && t <= r.tmax))
+		return false;
+
+	hit.t = t;
+	hit.u = v * inv_det;
+	hit.v = w * inv_det;
+	return true;
+}
+
+inline bool ray_triangle(const ray& r, const vec3& v0, const vec3& v1, const vec3& v2, tri_hit& hit)
+{
+	return ray_triangle(watertight_ray(r), v0, v1, v2, hit);
+}
+
+/**
+ * SoA boxes / triangles, one per lane
+ * aabb4/triangle4 -> SSE, aabb8/triangle8 -> AVX
+ */
+template <typename F>
+struct aabbxN
+{
+	vec3xN<F> min, max;
+
+	/** Lanes past the end of src are empty boxes and never hit */
+	static inline aabbxN load(std::span<const aabb> src, std::size_t first = 0)
+	{
+		constexpr int w = F::width;
+		alignas(32) float t[6][w];
+		for (int i = 0; i < w; ++i)
+		{
+			aabb b = first + i < src.size() ? src[first + i] : aabb();
+			t[0][i] = b.min.x; t[1][i] = b.min.y; t[2][i] = b.min.z;
+			t[3][i] = b.max.x; t[4][i] = b.max.y; t[5][i] = b.max.z;
+		}
+		return {
+			{F::load(t[0]), F::load(t[1]), F::load(t[2])},
+			{F::load(t[3]), F::load(t[4]), F::load(t[5])}
+		};
+	}
+};
+
+template <typename F>
+struct trianglexN
+{
+	vec3xN<F> v0, v1, v2;
+
+	/** Lanes past the end of the spans are degenerate and never hit */
+	static inline trianglexN load(std::span<const vec3> v0, std::span<const vec3> v1, std::span<const vec3> v2, std::size_t first = 0)
+	{
+		return {vec3xN<F>::load(v0, first), vec3xN<F>::load(v1, first), vec3xN<F>::load(v2, first)};
+	}
+};
+
+using aabb4 = aabbxN<floatx4>;
+using aabb8 = aabbxN<floatx8>;
+using triangle4 = trianglexN<floatx4>;
+using triangle8 = trianglexN<floatx8>;
+
+/**
+ * One ray against F::width boxes, same semantics as the scalar slab test
+ * Returns the hit mask, tnear is valid for the hit lanes
+ */
+template <typename F>
+inline typename F::mask ray_aabb(const ray& r, const aabbxN<F>& b, F& tnear)
+{
+	F tn(r.tmin);
+	F tf(r.tmax);
+	const F scale(detail::slab_tfar_scale);
+
+	for (int k = 0; k < 3; ++k)
+	{
+		float inv_k = detail::axis(r.inv_dir, k);
+		bool neg = inv_k < 0.0f;
+		F o(detail::axis(r.origin, k));
+		F inv(inv_k);
+		F t0 = (detail::axis(neg ? b.max : b.min, k) - o) * inv;
+		F t1 = (detail::axis(neg ? b.min : b.max, k) - o) * inv;
+
+		tn = F::max(t0, tn);
+		tf = F::min(t1 * scale, tf);
+	}
+
+	tnear = tn;
+	return tn <= tf;
+}
+
+/**
+ * One ray against F::width triangles, watertight test in float: the edge
+ * functions are redone in double (detail::edge_function) only on the lanes
+ * where one is too close to 0 for its float sign to be trusted, so the test
+ * stays watertight whatever -ffp-contract is
+ * Returns the hit mask, t/u/v are valid for the hit lanes
+ */
+template <typename F>
+inline typename F::mask ray_triangle(const watertight_ray& r, const trianglexN<F>& tri, F& t, F& u, F& v)
+{
+	using mask = typename F::mask;
+
+	vec3xN<F> o(r.origin);
+	vec3xN<F> a = tri.v0 - o;
+	vec3xN<F> b = tri.v1 - o;
+	vec3xN<F> c = tri.v2 - o;
+
+	const F sx(r.sx), sy(r.sy), sz(r.sz);
+
+	const F& az = detail::axis(a, r.kz);
+	const F& bz = detail::axis(b, r.kz);
+	const F& cz = detail::axis(c, r.kz);
+	F ax = detail::axis(a, r.kx) - sx * az;
+	F ay = detail::axis(a, r.ky) - sy * az;
+	F bx = detail::axis(b, r.kx) - sx * bz;
+	F by = detail::axis(b, r.ky) - sy * bz;
+	F cx = detail::axis(c, r.kx) - sx * cz;
+	F cy = detail::axis(c, r.ky) - sy * cz;
+
+	mask near;
+	F eu = detail::edge_function_float(cx, by, cy, bx, near);
+	F ev = detail::edge_function_float(ax, cy, ay, cx, near);
+	F ew = detail::edge_function_float(bx, ay, by, ax, near);
+	if (near.any()) {
+		eu = F::select(near, detail::edge_function(cx, by, cy, bx), eu);
+		ev = F::select(near, detail::edge_function(ax, cy, ay, cx), ev);
+		ew = F::select(near, detail::edge_function(bx, ay, by, ax), ew);
+	}
+
+	const F zero(0.0f);
+	mask neg = (eu < zero) | (ev < zero) | (ew < zero);
+	mask pos = (eu > zero) | (ev > zero) | (ew > zero);
+
+	F det = eu + ev + ew;
+	F inv_det = F(1.0f) / det;
+	F tt = (eu * az + ev * bz + ew * cz) * sz * inv_det;
+
+	mask hit = ~(neg & pos) & (det != zero) & (tt >= F(r.tmin)) & (tt <= F(r.tmax));
+
+	t = tt;
+	u = ev * inv_det;
+	v = ew * inv_det;
+	return hit;
+}
+
+template <typename F>
+inline typename F::mask ray_triangle(const ray& r, const trianglexN<F>& tri, F& t, F& u, F& v)
+{
+	return ray_triangle(watertight_ray(r), tri, t, u, v);
+}
+
+}
@@ -0,0 +1,637 @@
+#pragma once
+
+#include <type_traits>
+
+#include "math/vec.hpp"
+
+#if defined(__SSE__)
+#include <immintrin.h>
+#endif
+
+namespace cu::math {
+
+namespace detail {
+
+/**
+ * Scalar algorithms shared by the generic template and the constant-evaluated
+ * paths of the SIMD specialization, M is any type with an m[R][C] array
+ */
+template <typename Out, int R, int K, int C, typename A, typename B>
+constexpr Out mat_mul(const A& a, const B& b)
+{
+	Out r;
+	for (int i = 0; i < R; ++i)
+		for (int j = 0; j < C; ++j)
+		{
+			auto s = a.m[i][0] * b.m[0][j];
+			for (int k = 1; k < K; ++k)
+				s += a.m[i][k] * b.m[k][j];
+			r.m[i][j] = s;
+		}
+	return r;
+}
+
+// v.x * m[0] + v.y * m[1] + ..., same convention as the SIMD path
+template <typename Out, int R, int C, typename M, typename V>
+constexpr Out mat_mul_vec(const M& a, const V& v)
+{
+	Out r;
+	for (int j = 0; j < C; ++j)
+	{
+		auto s = v[0] * a.m[0][j];
+		for (int i = 1; i < R; ++i)
+			s += v[i] * a.m[i][j];
+		r[j] = s;
+	}
+	return r;
+}
+
+template <typename Out, int R, int C, typename M, typename T>
+constexpr Out mat_scale(const M& a, T s)
+{
+	Out r;
+	for (int i = 0; i < R; ++i)
+		for (int j = 0; j < C; ++j)
+			r.m[i][j] = a.m[i][j] * s;
+	return r;
+}
+
+template <typename Out, int R, int C, typename M>
+constexpr Out mat_transpose(const M& a)
+{
+	Out r;
+	for (int i = 0; i < R; ++i)
+		for (int j = 0; j < C; ++j)
+			r.m[j][i] = a.m[i][j];
+	return r;
+}
+
+// 2x2 sub-determinants of the top (s) and bottom (c) row pairs, Laplace expansion
+template <typename M>
+constexpr auto determinant4(const M& a)
+{
+	const auto& m = a.m;
+	auto s0 = m[0][0] * m[1][1] - m[1][0] * m[0][1];
+	auto s1 = m[0][0] * m[1][2] - m[1][0] * m[0][2];
+	auto s2 = m[0][0] * m[1][3] - m[1][0] * m[0][3];
+	auto s3 = m[0][1] * m[1][2] - m[1][1] * m[0][2];
+	auto s4 = m[0][1] * m[1][3] - m[1][1] * m[0][3];
+	auto s5 = m[0][2] * m[1][3] - m[1][2] * m[0][3];
+
+	auto c5 = m[2][2] * m[3][3] - m[3][2] * m[2][3];
+	auto c4 = m[2][1] * m[3][3] - m[3][1] * m[2][3];
+	auto c3 = m[2][1] * m[3][2] - m[3][1] * m[2][2];
+	auto c2 = m[2][0] * m[3][3] - m[3][0] * m[2][3];
+	auto c1 = m[2][0] * m[3][2] - m[3][0] * m[2][2];
+	auto c0 = m[2][0] * m[3][1] - m[3][0] * m[2][1];
+
+	return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+}
+
+template <typename M>
+constexpr M inverse4(const M& a)
+{
+	using T = std::remove_cvref_t<decltype(a.m[0][0])>;
+	const auto& m = a.m;
+
+	T s0 = m[0][0] * m[1][1] - m[1][0] * m[0][1];
+	T s1 = m[0][0] * m[1][2] - m[1][0] * m[0][2];
+	T s2 = m[0][0] * m[1][3] - m[1][0] * m[0][3];
+	T s3 = m[0][1] * m[1][2] - m[1][1] * m[0][2];
+	T s4 = m[0][1] * m[1][3] - m[1][1] * m[0][3];
+	T s5 = m[0][2] * m[1][3] - m[1][2] * m[0][3];
+
+	T c5 = m[2][2] * m[3][3] - m[3][2] * m[2][3];
+	T c4 = m[2][1] * m[3][3] - m[3][1] * m[2][3];
+	T c3 = m[2][1] * m[3][2] - m[3][1] * m[2][2];
+	T c2 = m[2][0] * m[3][3] - m[3][0] * m[2][3];
+	T c1 = m[2][0] * m[3][2] - m[3][0] * m[2][2];
+	T c0 = m[2][0] * m[3][1] - m[3][0] * m[2][1];
+
+	T inv = T(1) / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);
+
+	M r;
+	r.m[0][0] = ( m[1][1] * c5 - m[1][2] * c4 + m[1][3] * c3) * inv;
+	r.m[0][1] = (-m[0][1] * c5 + m[0][2] * c4 - m[0][3] * c3) * inv;
+	r.m[0][2] = ( m[3][1] * s5 - m[3][2] * s4 + m[3][3] * s3) * inv;
+	r.m[0][3] = (-m[2][1] * s5 + m[2][2] * s4 - m[2][3] * s3) * inv;
+
+	r.m[1][0] = (-m[1][0] * c5 + m[1][2] * c2 - m[1][3] * c1) * inv;
+	r.m[1][1] = ( m[0][0] * c5 - m[0][2] * c2 + m[0][3] * c1) * inv;
+	r.m[1][2] = (-m[3][0] * s5 + m[3][2] * s2 - m[3][3] * s1) * inv;
+	r.m[1][3] = ( m[2][0] * s5 - m[2][2] * s2 + m[2][3] * s1) * inv;
+
+	r.m[2][0] = ( m[1][0] * c4 - m[1][1] * c2 + m[1][3] * c0) * inv;
+	r.m[2][1] = (-m[0][0] * c4 + m[0][1] * c2 - m[0][3] * c0) * inv;
+	r.m[2][2] = ( m[3][0] * s4 - m[3][1] * s2 + m[3][3] * s0) * inv;
+	r.m[2][3] = (-m[2][0] * s4 + m[2][1] * s2 - m[2][3] * s0) * inv;
+
+	r.m[3][0] = (-m[1][0] * c3 + m[1][1] * c1 - m[1][2] * c0) * inv;
+	r.m[3][1] = ( m[0][0] * c3 - m[0][1] * c1 + m[0][2] * c0) * inv;
+	r.m[3][2] = (-m[3][0] * s3 + m[3][1] * s1 - m[3][2] * s0) * inv;
+	r.m[3][3] = ( m[2][0] * s3 - m[2][1] * s1 + m[2][2] * s0) * inv;
+	return r;
+}
+
+// translate() puts the translation in m[0..2][3] instead of m[3], see mat::affine_inverse()
+template <typename M>
+constexpr bool translation_in_last_column(const M& a)
+{
+	using T = std::remove_cvref_t<decltype(a.m[0][0])>;
+	return a.m[0][3] != T(0) || a.m[1][3] != T(0) || a.m[2][3] != T(0);
+}
+
+template <typename M>
+constexpr M affine_inverse4(const M& a)
+{
+	using T = std::remove_cvref_t<decltype(a.m[0][0])>;
+	if (translation_in_last_column(a))
+		return mat_transpose<M, 4, 4>(affine_inverse4(mat_transpose<M, 4, 4>(a)));
+
+	const auto& m = a.m;
+	T a00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+	T a01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+	T a02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+	T inv = T(1) / (m[0][0] * a00 + m[0][1] * a01 + m[0][2] * a02);
+
+	M r;
+	r.m[0][0] = a00 * inv;
+	r.m[0][1] = (m[2][1] * m[0][2] - m[2][2] * m[0][1]) * inv;
+	r.m[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * inv;
+	r.m[1][0] = a01 * inv;
+	r.m[1][1] = (m[2][2] * m[0][0] - m[2][0] * m[0][2]) * inv;
+	r.m[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * inv;
+	r.m[2][0] = a02 * inv;
+	r.m[2][1] = (m[2][0] * m[0][1] - m[2][1] * m[0][0]) * inv;
+	r.m[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * inv;
+	r.m[0][3] = r.m[1][3] = r.m[2][3] = T(0);
+
+	for (int j = 0; j < 3; ++j)
+		r.m[3][j] = -(m[3][0] * r.m[0][j] + m[3][1] * r.m[1][j] + m[3][2] * r.m[2][j]);
+	r.m[3][3] = T(1);
+	return r;
+}
+
+template <typename M>
+constexpr M trs_inverse4(const M& a)
+{
+	using T = std::remove_cvref_t<decltype(a.m[0][0])>;
+	if (translation_in_last_column(a))
+		return mat_transpose<M, 4, 4>(trs_inverse4(mat_transpose<M, 4, 4>(a)));
+
+	const auto& m = a.m;
+	M r;
+	for (int i = 0; i < 3; ++i)
+	{
+		T inv = T(1) / (m[i][0] * m[i][0] + m[i][1] * m[i][1] + m[i][2] * m[i][2]);
+		for (int j = 0; j < 3; ++j)
+			r.m[j][i] = m[i][j] * inv;
+		r.m[i][3] = T(0);
+	}
+	for (int j = 0; j < 3; ++j)
+		r.m[3][j] = -(m[3][0] * r.m[0][j] + m[3][1] * r.m[1][j] + m[3][2] * r.m[2][j]);
+	r.m[3][3] = T(1);
+	return r;
+}
+
+}
+
+/**
+ * R x C matrix stored row by row, every operation is constexpr
+ * m[i] is what mul_vec() scales by v[i], so for 4x4 transforms m[3] holds the translation
+ * mat<float, 4, 4> is specialized below with SSE
+ */
+template <typename T, int R, int C>
+struct mat
+{
+	using value_type = T;
+	static constexpr int rows = R;
+	static constexpr int cols = C;
+
+	T m[R][C];
+
+	constexpr mat(T diag = T(0)) : m{}
+	{
+		for (int i = 0; i < R && i < C; ++i)
+			m[i][i] = diag;
+	}
+
+	template <typename U>
+	explicit constexpr mat(const mat<U, R, C>& o) : m{}
+	{
+		for (int i = 0; i < R; ++i)
+			for (int j = 0; j < C; ++j)
+				m[i][j] = static_cast<T>(o.m[i][j]);
+	}
+
+	static constexpr mat identity() requires (R == C) { return mat(T(1)); }
+
+	template <int K>
+	constexpr mat<T, R, K> operator*(const mat<T, C, K>& o) const { return detail::mat_mul<mat<T, R, K>, R, C, K>(*this, o); }
+
+	constexpr vec<T, C> mul_vec(const vec<T, R>& v) const { return detail::mat_mul_vec<vec<T, C>, R, C>(*this, v); }
+	constexpr mat operator*(T s) const { return detail::mat_scale<mat, R, C>(*this, s); }
+	constexpr mat<T, C, R> transpose() const { return detail::mat_transpose<mat<T, C, R>, R, C>(*this); }
+
+	constexpr T determinant() const requires (R == 4 && C == 4) { return detail::determinant4(*this); }
+	constexpr mat inverse() const requires (R == 4 && C == 4) { return detail::inverse4(*this); }
+	constexpr mat affine_inverse() const requires (R == 4 && C == 4) { return detail::affine_inverse4(*this); }
+	constexpr mat trs_inverse() const requires (R == 4 && C == 4) { return detail::trs_inverse4(*this); }
+};
+
+#if defined(__SSE__)
+namespace detail {
+
+/** (v[x], v[y], v[z], v[w]) */
+template <int x, int y, int z, int w>
+inline __m128 swizzle(__m128 v)
+{
+	return _mm_shuffle_ps(v, v, _MM_SHUFFLE(w, z, y, x));
+}
+
+/**
+ * 2x2 matrices packed in one register as (m00, m01, m10, m11)
+ * https://lxjk.github.io/2017/09/03/Fast-4x4-Matrix-Inverse-with-SSE-SIMD-Explained.html
+ */
+// A * B
+inline __m128 mat2_mul(__m128 a, __m128 b)
+{
+	return _mm_add_ps(_mm_mul_ps(a, detail::swizzle<0, 3, 0, 3>(b)),
+	                  _mm_mul_ps(detail::swizzle<1, 0, 3, 2>(a), detail::swizzle<2, 1, 2, 1>(b)));
+}
+
+// adj(A) * B
+inline __m128 mat2_adj_mul(__m128 a, __m128 b)
+{
+	return _mm_sub_ps(_mm_mul_ps(detail::swizzle<3, 3, 0, 0>(a), b),
+	                  _mm_mul_ps(detail::swizzle<1, 1, 2, 2>(a), detail::swizzle<2, 3, 0, 1>(b)));
+}
+
+// A * adj(B)
+inline __m128 mat2_mul_adj(__m128 a, __m128 b)
+{
+	return _mm_sub_ps(_mm_mul_ps(a, detail::swizzle<3, 0, 3, 0>(b)),
+	                  _mm_mul_ps(detail::swizzle<1, 0, 3, 2>(a), detail::swizzle<2, 1, 2, 1>(b)));
+}
+
+// x + y + z + w, broadcast
+inline __m128 hsum(__m128 v)
+{
+	v = _mm_add_ps(v, detail::swizzle<1, 0, 3, 2>(v));
+	return _mm_add_ps(v, detail::swizzle<2, 3, 0, 1>(v));
+}
+
+// a.yzx * b.zxy - a.zxy * b.yzx
+inline __m128 cross3(__m128 a, __m128 b)
+{
+	__m128 r = _mm_sub_ps(_mm_mul_ps(a, detail::swizzle<1, 2, 0, 3>(b)), _mm_mul_ps(detail::swizzle<1, 2, 0, 3>(a), b));
+	return detail::swizzle<1, 2, 0, 3>(r);
+}
+
+}
+
+/**
+ * mat4 using SIMD, one row per register
+ * Constant evaluation goes through the generic algorithms above
+ */
+template <>
+struct alignas(16) mat<float, 4, 4>
+{
+	using value_type = float;
+	static constexpr int rows = 4;
+	static constexpr int cols = 4;
+
+	union {
+		float  m[4][4];
+		__m128 row[4];
+	};
+
+	constexpr mat(float diag = 0.0f)
+		: m{{diag, 0.0f, 0.0f, 0.0f}, {0.0f, diag, 0.0f, 0.0f}, {0.0f, 0.0f, diag, 0.0f}, {0.0f, 0.0f, 0.0f, diag}} {}
+
+	template <typename U>
+	explicit constexpr mat(const mat<U, 4, 4>& o) : mat()
+	{
+		for (int i = 0; i < 4; ++i)
+			for (int j = 0; j < 4; ++j)
+				m[i][j] = static_cast<float>(o.m[i][j]);
+	}
+
+	static constexpr mat identity() { return mat(1.0f); }
+
+	/**
+	 * mat4 * mat4
+	 * https://en.wikipedia.org/wiki/Matrix_multiplication
+	 * https://i.sstatic.net/iRxxe.png
+	 */
+	constexpr mat operator*(const mat& o) const
+	{
+		if (std::is_constant_evaluated())
+			return detail::mat_mul<mat, 4, 4, 4>(*this, o);
+
+		mat r;
+
+	#if defined(__AVX__)
+		// two rows of this per register, the rows of o repeated in both halves
+		__m256 b0 = _mm256_broadcast_ps(&o.row[0]);
+		__m256 b1 = _mm256_broadcast_ps(&o.row[1]);
+		__m256 b2 = _mm256_broadcast_ps(&o.row[2]);
+		__m256 b3 = _mm256_broadcast_ps(&o.row[3]);
+
+		for (int i = 0; i < 4; i += 2)
+		{
+			__m256 a = _mm256_loadu_ps(m[i]);
+
+			__m256 a0 = _mm256_shuffle_ps(a, a, _MM_SHUFFLE(0,0,0,0));
+			__m256 a1 = _mm256_shuffle_ps(a, a, _MM_SHUFFLE(1,1,1,1));
+			__m256 a2 = _mm256_shuffle_ps(a, a, _MM_SHUFFLE(2,2,2,2));
+			__m256 a3 = _mm256_shuffle_ps(a, a, _MM_SHUFFLE(3,3,3,3));
+
+		#if defined(__FMA__)
+			__m256 result =
+				_mm256_fmadd_ps(a0, b0,
+				_mm256_fmadd_ps(a1, b1,
+				_mm256_fmadd_ps(a2, b2,
+				_mm256_mul_ps(a3, b3))));
+		#else
+			__m256 result =
+				_mm256_add_ps(
+					_mm256_add_ps(
+						_mm256_mul_ps(a0, b0),
+						_mm256_mul_ps(a1, b1)),
+					_mm256_add_ps(
+						_mm256_mul_ps(a2, b2),
+						_mm256_mul_ps(a3, b3)));
+		#endif
+
+			_mm256_storeu_ps(r.m[i], result);
+		}
+	#else
+		__m128 b0 = o.row[0];
+		__m128 b1 = o.row[1];
+		__m128 b2 = o.row[2];
+		__m128 b3 = o.row[3];
+
+		for (int i = 0; i < 4; ++i)
+		{
+			__m128 a = row[i];
+
+			__m128 a0 = _mm_shuffle_ps(a, a, _MM_SHUFFLE(0,0,0,0));
+			__m128 a1 = _mm_shuffle_ps(a, a, _MM_SHUFFLE(1,1,1,1));
+			__m128 a2 = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2,2,2,2));
+			__m128 a3 = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3,3,3,3));
+
+		#if defined(__FMA__)
+			__m128 result =
+				_mm_fmadd_ps(a0, b0,
+				_mm_fmadd_ps(a1, b1,
+				_mm_fmadd_ps(a2, b2,
+				_mm_mul_ps(a3, b3))));
+		#else
+			__m128 result =
+				_mm_add_ps(
+					_mm_add_ps(
+						_mm_mul_ps(a0, b0),
+						_mm_mul_ps(a1, b1)),
+					_mm_add_ps(
+						_mm_mul_ps(a2, b2),
+						_mm_mul_ps(a3, b3)));
+		#endif
+
+			r.row[i] = result;
+		}
+	#endif
+
+		return r;
+
+	}
+
+	/**
+	 * vec4 * mat4
+	 * https://en.wikipedia.org/wiki/Matrix_multiplication
+	 * https://thebookofshaders.com/08/matrixes.png
+	 */
+	constexpr vec4 mul_vec(const vec4& v) const
+	{
+		if (std::is_constant_evaluated())
+			return detail::mat_mul_vec<vec4, 4, 4>(*this, v);
+
+		__m128 vx = _mm_shuffle_ps(v.v, v.v, _MM_SHUFFLE(0,0,0,0));
+		__m128 vy = _mm_shuffle_ps(v.v, v.v, _MM_SHUFFLE(1,1,1,1));
+		__m128 vz = _mm_shuffle_ps(v.v, v.v, _MM_SHUFFLE(2,2,2,2));
+		__m128 vw = _mm_shuffle_ps(v.v, v.v, _MM_SHUFFLE(3,3,3,3));
+
+	#if defined(__FMA__)
+		__m128 result =
+			_mm_fmadd_ps(vx, row[0],
+			_mm_fmadd_ps(vy, row[1],
+			_mm_fmadd_ps(vz, row[2],
+			_mm_mul_ps(vw, row[3]))));
+	#else
+		__m128 result =
+			_mm_add_ps(
+				_mm_add_ps(
+					_mm_mul_ps(vx, row[0]),
+					_mm_mul_ps(vy, row[1])),
+				_mm_add_ps(
+					_mm_mul_ps(vz, row[2]),
+					_mm_mul_ps(vw, row[3])));
+	#endif
+
+		vec4 out;
+		out.v = result;
+		return out;
+	}
+
+	/**
+	 * float * mat4
+	 * https://en.wikipedia.org/wiki/Matrix_multiplication
+	 */
+	constexpr mat operator*(float s) const
+	{
+		if (std::is_constant_evaluated())
+			return detail::mat_scale<mat, 4, 4>(*this, s);
+
+		mat r;
+		__m128 scalar = _mm_set1_ps(s);
+		r.row[0] = _mm_mul_ps(row[0], scalar);
+		r.row[1] = _mm_mul_ps(row[1], scalar);
+		r.row[2] = _mm_mul_ps(row[2], scalar);
+		r.row[3] = _mm_mul_ps(row[3], scalar);
+		return r;
+	}
+
+	constexpr mat transpose() const
+	{
+		if (std::is_constant_evaluated())
+			return detail::mat_transpose<mat, 4, 4>(*this);
+
+		mat r;
+		r.row[0] = row[0];
+		r.row[1] = row[1];
+		r.row[2] = row[2];
+		r.row[3] = row[3];
+		_MM_TRANSPOSE4_PS(r.row[0], r.row[1], r.row[2], r.row[3]);
+		return r;
+	}
+
+	/**
+	 * Block-wise 2x2 determinant and inverse
+	 * |M| = |A||D| + |B||C| - tr(adj(A) B adj(D) C)
+	 * https://lxjk.github.io/2017/09/03/Fast-4x4-Matrix-Inverse-with-SSE-SIMD-Explained.html
+	 */
+	constexpr float determinant() const
+	{
+		if (std::is_constant_evaluated())
+			return detail::determinant4(*this);
+
+		__m128 A = _mm_movelh_ps(row[0], row[1]);
+		__m128 B = _mm_movehl_ps(row[1], row[0]);
+		__m128 C = _mm_movelh_ps(row[2], row[3]);
+		__m128 D = _mm_movehl_ps(row[3], row[2]);
+
+		// (|A|, |B|, |C|, |D|)
+		__m128 det_sub = _mm_sub_ps(
+			_mm_mul_ps(_mm_shuffle_ps(row[0], row[2], _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(row[1], row[3], _MM_SHUFFLE(3, 1, 3, 1))),
+			_mm_mul_ps(_mm_shuffle_ps(row[0], row[2], _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_ps(row[1], row[3], _MM_SHUFFLE(2, 0, 2, 0))));
+
+		__m128 ad_bc = _mm_mul_ps(det_sub, detail::swizzle<3, 2, 1, 0>(det_sub));
+		__m128 tr = _mm_mul_ps(detail::mat2_adj_mul(A, B), detail::swizzle<0, 2, 1, 3>(detail::mat2_adj_mul(D, C)));
+
+		return _mm_cvtss_f32(_mm_add_ss(ad_bc, _mm_sub_ss(detail::swizzle<1, 1, 1, 1>(ad_bc), detail::hsum(tr))));
+	}
+
+	/**
+	 * General inverse, a singular matrix gives inf/nan
+	 * Prefer affine_inverse() / trs_inverse() for model and view matrices
+	 * Accuracy, here and in the two below: every element is within
+	 * 2 * cond(M) * FLT_EPSILON of the exact inverse, relative to its largest element,
+	 * with cond(M) = |M| |inv(M)| in the infinity norm (tests/mat4_inverse.cpp)
+	 */
+	constexpr mat inverse() const
+	{
+		if (std::is_constant_evaluated())
+			return detail::inverse4(*this);
+
+		mat r;
+		__m128 A = _mm_movelh_ps(row[0], row[1]);
+		__m128 B = _mm_movehl_ps(row[1], row[0]);
+		__m128 C = _mm_movelh_ps(row[2], row[3]);
+		__m128 D = _mm_movehl_ps(row[3], row[2]);
+
+		__m128 det_sub = _mm_sub_ps(
+			_mm_mul_ps(_mm_shuffle_ps(row[0], row[2], _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(row[1], row[3], _MM_SHUFFLE(3, 1, 3, 1))),
+			_mm_mul_ps(_mm_shuffle_ps(row[0], row[2], _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_ps(row[1], row[3], _MM_SHUFFLE(2, 0, 2, 0))));
+
+		__m128 det_a = detail::swizzle<0, 0, 0, 0>(det_sub);
+		__m128 det_b = detail::swizzle<1, 1, 1, 1>(det_sub);
+		__m128 det_c = detail::swizzle<2, 2, 2, 2>(det_sub);
+		__m128 det_d = detail::swizzle<3, 3, 3, 3>(det_sub);
+
+		// inverse = 1/|M| * | adj(X) adj(Y) |
+		//                   | adj(Z) adj(W) |
+		__m128 d_c = detail::mat2_adj_mul(D, C);
+		__m128 a_b = detail::mat2_adj_mul(A, B);
+
+		__m128 x = _mm_sub_ps(_mm_mul_ps(det_d, A), detail::mat2_mul(B, d_c));
+		__m128 w = _mm_sub_ps(_mm_mul_ps(det_a, D), detail::mat2_mul(C, a_b));
+		__m128 y = _mm_sub_ps(_mm_mul_ps(det_b, C), detail::mat2_mul_adj(D, a_b));
+		__m128 z = _mm_sub_ps(_mm_mul_ps(det_c, B), detail::mat2_mul_adj(A, d_c));
+
+		__m128 tr = detail::hsum(_mm_mul_ps(a_b, detail::swizzle<0, 2, 1, 3>(d_c)));
+		__m128 det = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(det_a, det_d), _mm_mul_ps(det_b, det_c)), tr);
+
+		__m128 rdet = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det);
+		x = _mm_mul_ps(x, rdet);
+		y = _mm_mul_ps(y, rdet);
+		z = _mm_mul_ps(z, rdet);
+		w = _mm_mul_ps(w, rdet);
+
+		// adjugate swizzle and block reassembly in one shuffle
+		r.row[0] = _mm_shuffle_ps(x, y, _MM_SHUFFLE(1, 3, 1, 3));
+		r.row[1] = _mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 2, 0, 2));
+		r.row[2] = _mm_shuffle_ps(z, w, _MM_SHUFFLE(1, 3, 1, 3));
+		r.row[3] = _mm_shuffle_ps(z, w, _MM_SHUFFLE(0, 2, 0, 2));
+		return r;
+	}
+
+	/**
+	 * Inverse of | L t |, any invertible 3x3 L (rotation, scale, shear)
+	 *            | 0 1 |
+	 * inverse = | inv(L) -inv(L)t |, inv(L) from 3 cross products
+	 *           |   0        1    |
+	 * Works for both layouts found in the tree: translation in m[3] (lookAt, mul_vec)
+	 * or in m[0..2][3] (translate()), detected from which one holds the zeros
+	 */
+	constexpr mat affine_inverse() const
+	{
+		if (std::is_constant_evaluated())
+			return detail::affine_inverse4(*this);
+		if (m[0][3] != 0.0f || m[1][3] != 0.0f || m[2][3] != 0.0f)
+			return transpose().affine_inverse().transpose();
+
+		mat r;
+		// rows of inv(L) are cross products of the columns of L
+		__m128 r0 = detail::cross3(row[1], row[2]);
+		__m128 r1 = detail::cross3(row[2], row[0]);
+		__m128 r2 = detail::cross3(row[0], row[1]);
+
+		__m128 det = detail::hsum(_mm_mul_ps(row[0], r0));
+		__m128 rdet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+		__m128 c0 = _mm_mul_ps(r0, rdet);
+		__m128 c1 = _mm_mul_ps(r1, rdet);
+		__m128 c2 = _mm_mul_ps(r2, rdet);
+		__m128 c3 = _mm_setzero_ps();
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+		__m128 t = row[3];
+		__m128 it = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(detail::swizzle<0, 0, 0, 0>(t), c0), _mm_mul_ps(detail::swizzle<1, 1, 1, 1>(t), c1)),
+			_mm_mul_ps(detail::swizzle<2, 2, 2, 2>(t), c2));
+
+		r.row[0] = c0;
+		r.row[1] = c1;
+		r.row[2] = c2;
+		r.row[3] = _mm_sub_ps(_mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f), it);
+		return r;
+	}
+
+	/**
+	 * Inverse of a translate * rotate * scale matrix (orthogonal axes, no shear):
+	 * inv(R S) = inv(S) R^T, each axis divided by its squared length
+	 * Same layout detection as affine_inverse(), same accuracy when the axes are
+	 * orthogonal to float rounding (quat::toMatrix() scaled per axis)
+	 */
+	constexpr mat trs_inverse() const
+	{
+		if (std::is_constant_evaluated())
+			return detail::trs_inverse4(*this);
+		if (m[0][3] != 0.0f || m[1][3] != 0.0f || m[2][3] != 0.0f)
+			return transpose().trs_inverse().transpose();
+
+		mat r;
+		__m128 c0 = _mm_div_ps(row[0], detail::hsum(_mm_mul_ps(row[0], row[0])));
+		__m128 c1 = _mm_div_ps(row[1], detail::hsum(_mm_mul_ps(row[1], row[1])));
+		__m128 c2 = _mm_div_ps(row[2], detail::hsum(_mm_mul_ps(row[2], row[2])));
+		__m128 c3 = _mm_setzero_ps();
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+		__m128 t = row[3];
+		__m128 it = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(detail::swizzle<0, 0, 0, 0>(t), c0), _mm_mul_ps(detail::swizzle<1, 1, 1, 1>(t), c1)),
+			_mm_mul_ps(detail::swizzle<2, 2, 2, 2>(t), c2));
+
+		r.row[0] = c0;
+		r.row[1] = c1;
+		r.row[2] = c2;
+		r.row[3] = _mm_sub_ps(_mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f), it);
+		return r;
+	}
+};
+#endif
+
+using mat4 = mat<float, 4, 4>;
+using dmat4 = mat<double, 4, 4>;
+
+}
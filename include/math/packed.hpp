@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+#include "math/half.hpp"
+#include "math/vec.hpp"
+#include "math/quat.hpp"
+
+namespace cu::math {
+
+/**
+ * Compressed storage formats, meant for resident vertex and animation data
+ * Decode back to vec3 / vec4 / quat before doing math with them
+ *
+ *                  bytes   error (measured over random inputs, documented as bounds)
+ * vec3 -> vec3h      6     half precision: relative 2^-11 (4.9e-4), |x| <= 65504, below 6.1e-5 subnormal
+ * vec4 -> vec4h      8     same as vec3h
+ * vec3 -> oct32      4     unit vectors only, max angular error 0.0037 degrees (6.5e-5 rad)
+ * quat -> quat48     6     unit quaternions, max component error 5.7e-5, rotation error 0.0076 degrees
+ * quat -> quat64     8     unit quaternions, max component error 1.9e-6, rotation error 0.00026 degrees
+ */
+
+using vec3h = vec<half, 3>;
+using vec4h = vec<half, 4>;
+
+static_assert(sizeof(vec3h) == 6 && sizeof(vec4h) == 8);
+
+/**
+ * Octahedral unit vector: the sphere is projected on the octahedron |x| + |y| + |z| = 1,
+ * the lower half folded over the upper one, and x/y stored as two snorm16
+ * https://jcgt.org/published/0003/02/01/paper.pdf
+ */
+struct oct32
+{
+	std::uint32_t bits = 0;		// x in the low 16 bits, y in the high 16 bits
+};
+
+/**
+ * Smallest three: the largest component of a unit quaternion is dropped and rebuilt
+ * from the other three, which all fit in [-1/sqrt(2), 1/sqrt(2)]. q and -q are the same
+ * rotation, so the dropped component is always made positive
+ * https://gafferongames.com/post/snapshot_compression/
+ *
+ * quat48: 2 bit index + 3 x 15 bits, quat64: 2 bit index + 3 x 20 bits
+ */
+struct quat48
+{
+	std::uint16_t bits[3] = {};
+};
+
+struct quat64
+{
+	std::uint64_t bits = 0;
+};
+
+static_assert(sizeof(oct32) == 4 && sizeof(quat48) == 6 && sizeof(quat64) == 8);
+
+oct32	encode_oct32(const vec3& n);
+vec3	decode_oct32(oct32 p);
+
+quat48	encode_quat48(const quat& q);
+quat	decode_quat48(const quat48& p);
+quat64	encode_quat64(const quat& q);
+quat	decode_quat64(const quat64& p);
+
+/**
+ * Bulk kernels, in and out must have the same size
+ * Half conversions use F16C when the build enables it, an SSE2 bit trick otherwise,
+ * the other formats run 4 elements per iteration in SoA form
+ */
+void	encode_half(std::span<const float> in, std::span<half> out);
+void	decode_half(std::span<const half> in, std::span<float> out);
+void	encode_half(std::span<const vec3> in, std::span<vec3h> out);
+void	decode_half(std::span<const vec3h> in, std::span<vec3> out);
+void	encode_half(std::span<const vec4> in, std::span<vec4h> out);
+void	decode_half(std::span<const vec4h> in, std::span<vec4> out);
+
+void	encode_oct32(std::span<const vec3> in, std::span<oct32> out);
+void	decode_oct32(std::span<const oct32> in, std::span<vec3> out);
+
+void	encode_quat48(std::span<const quat> in, std::span<quat48> out);
+void	decode_quat48(std::span<const quat48> in, std::span<quat> out);
+void	encode_quat64(std::span<const quat> in, std::span<quat64> out);
+void	decode_quat64(std::span<const quat64> in, std::span<quat> out);
+
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cmath>
+#include <span>
 #include "vec3.hpp"
 #include "mat4.hpp"
 
@@ -38,13 +39,32 @@ struct quat
 		return {v - q.v};
 	}
 
+	/**
+	 * Hamilton product, the SSE path is a * b = a.w * b + a.x * b.xwzy + a.y * b.yzwx + a.z * b.zyxw
+	 * with the signs applied through xor masks
+	 * https://en.wikipedia.org/wiki/Quaternion#Hamilton_product
+	 */
 	inline quat operator*(const quat& q) const {
+	#if defined(__SSE__)
+		const __m128 sx = _mm_setr_ps(-0.0f, 0.0f, -0.0f, 0.0f);
+		const __m128 sy = _mm_setr_ps(-0.0f, 0.0f, 0.0f, -0.0f);
+		const __m128 sz = _mm_setr_ps(-0.0f, -0.0f, 0.0f, 0.0f);
+
+		__m128 a = v.v;
+		__m128 b = q.v.v;
+		__m128 r = _mm_mul_ps(detail::swizzle<0, 0, 0, 0>(a), b);
+		r = _mm_add_ps(r, _mm_xor_ps(_mm_mul_ps(detail::swizzle<1, 1, 1, 1>(a), detail::swizzle<1, 0, 3, 2>(b)), sx));
+		r = _mm_add_ps(r, _mm_xor_ps(_mm_mul_ps(detail::swizzle<2, 2, 2, 2>(a), detail::swizzle<2, 3, 0, 1>(b)), sy));
+		r = _mm_add_ps(r, _mm_xor_ps(_mm_mul_ps(detail::swizzle<3, 3, 3, 3>(a), detail::swizzle<3, 2, 1, 0>(b)), sz));
+		return from_m128(r);
+	#else
 		return {
 			w * q.w - x * q.x - y * q.y - z * q.z,
 			w * q.x + x * q.w + y * q.z - z * q.y,
 			w * q.y - x * q.z + y * q.w + z * q.x,
 			w * q.z + x * q.y - y * q.x + z * q.w
 		};
+	#endif
 	}
 
 	inline quat operator*(float s) const {
@@ -78,11 +98,21 @@ struct quat
 	}
 
 	inline quat normalized() const {
+		if constexpr (scalar::fast_math) {
+			float l2 = v.length_sq();
+			return l2 > 0 ? *this * scalar::rsqrt(l2) : quat();
+		}
 		float l = length();
 		return l > 0 ? *this / l : quat();
 	}
 
 	inline quat& normalize() {
+		if constexpr (scalar::fast_math) {
+			float l2 = v.length_sq();
+			if (l2 > 0)
+				*this = *this * scalar::rsqrt(l2);
+			return *this;
+		}
 		float l = length();
 		if (l > 0) {
 			w /= l; x /= l; y /= l; z /= l;
@@ -118,15 +148,15 @@ struct quat
 
 		d = d < -1.0f ? -1.0f : (d > 1.0f ? 1.0f : d);
 
-		float theta = std::acos(d);
-		float sin_theta = std::sin(theta);
+		float theta = scalar::acos(d);
+		float sin_theta = scalar::sin(theta);
 
 		if (sin_theta < 0.001f) {
 			return lerp(qa, qb, t);
 		}
 
-		float w1 = std::sin((1.0f - t) * theta) / sin_theta;
-		float w2 = std::sin(t * theta) / sin_theta;
+		float w1 = scalar::sin((1.0f - t) * theta) / sin_theta;
+		float w2 = scalar::sin(t * theta) / sin_theta;
 
 		return ((qa * w1) + (qb * w2)).normalized();
 	}
@@ -134,9 +164,9 @@ struct quat
 	static inline quat fromAxisAngle(const vec3& axis, float angle) {
 		vec3 normalized_axis = vec3::normalize(axis);
 		float half_angle = angle * 0.5f;
-		float sin_half = std::sin(half_angle);
+		float sin_half = scalar::sin(half_angle);
 		return {
-			std::cos(half_angle),
+			scalar::cos(half_angle),
 			normalized_axis.x * sin_half,
 			normalized_axis.y * sin_half,
 			normalized_axis.z * sin_half
@@ -145,9 +175,9 @@ struct quat
 
 	static inline void toAxisAngle(const quat& q, vec3& axis, float& angle) {
 		quat normalized = q.normalized();
-		angle = 2.0f * std::acos(std::fmax(-1.0f, std::fmin(1.0f, normalized.w)));
+		angle = 2.0f * scalar::acos(std::fmax(-1.0f, std::fmin(1.0f, normalized.w)));
 		
-		float sin_half_angle = std::sin(angle * 0.5f);
+		float sin_half_angle = scalar::sin(angle * 0.5f);
 		if (sin_half_angle < 0.001f) {
 			axis = {0, 0, 1};
 		} else {
@@ -161,12 +191,12 @@ struct quat
 
 	// roll (X), pitch (Y), yaw (Z)
 	static inline quat fromEuler(float roll, float pitch, float yaw) {
-		float cy = std::cos(yaw * 0.5f);
-		float sy = std::sin(yaw * 0.5f);
-		float cp = std::cos(pitch * 0.5f);
-		float sp = std::sin(pitch * 0.5f);
-		float cr = std::cos(roll * 0.5f);
-		float sr = std::sin(roll * 0.5f);
+		float cy = scalar::cos(yaw * 0.5f);
+		float sy = scalar::sin(yaw * 0.5f);
+		float cp = scalar::cos(pitch * 0.5f);
+		float sp = scalar::sin(pitch * 0.5f);
+		float cr = scalar::cos(roll * 0.5f);
+		float sr = scalar::sin(roll * 0.5f);
 
 		return {
 			cy * cp * cr + sy * sp * sr,
@@ -186,30 +216,77 @@ struct quat
 		// Roll (X)
 		float sinr_cosp = 2 * (w * x + y * z);
 		float cosr_cosp = 1 - 2 * (x * x + y * y);
-		float roll = std::atan2(sinr_cosp, cosr_cosp);
+		float roll = scalar::atan2(sinr_cosp, cosr_cosp);
 
 		// Pitch (Y)
 		float sinp = 2 * (w * y - z * x);
 		sinp = sinp > 1.0f ? 1.0f : (sinp < -1.0f ? -1.0f : sinp);
-		float pitch = std::asin(sinp);
+		float pitch = scalar::asin(sinp);
 
 		// Yaw (Z)
 		float siny_cosp = 2 * (w * z + x * y);
 		float cosy_cosp = 1 - 2 * (y * y + z * z);
-		float yaw = std::atan2(siny_cosp, cosy_cosp);
+		float yaw = scalar::atan2(siny_cosp, cosy_cosp);
 
 		return {roll, pitch, yaw};
 	}
 
-	inline vec3 rotate(const vec3& v) const {
-		quat q = normalized();
-		quat p(0, v.x, v.y, v.z);
-		quat result = q * p * q.conjugate();
-		return {result.x, result.y, result.z};
+	/**
+	 * v + w * t + cross(q.xyz, t) with t = 2 * cross(q.xyz, v) / |q|^2, which is
+	 * q * v * conjugate(q) for the normalized quaternion without the two products
+	 * and the square root
+	 * https://fgiesen.wordpress.com/2019/02/09/rotating-a-single-vector-using-a-quaternion/
+	 */
+	inline vec3 rotate(const vec3& p) const {
+		float n = v.length_sq();
+		if (!(n > 0.0f))
+			return p;
+		float s = 2.0f / n;
+	#if defined(__SSE__)
+		__m128 q = detail::swizzle<1, 2, 3, 0>(v.v);
+		__m128 a = _mm_setr_ps(p.x, p.y, p.z, 0.0f);
+		__m128 t = _mm_mul_ps(detail::cross3(q, a), _mm_set1_ps(s));
+		__m128 r = _mm_add_ps(_mm_add_ps(a, _mm_mul_ps(detail::swizzle<0, 0, 0, 0>(v.v), t)), detail::cross3(q, t));
+		alignas(16) float out[4];
+		_mm_store_ps(out, r);
+		return {out[0], out[1], out[2]};
+	#else
+		vec3 q(x, y, z);
+		vec3 t = vec3::cross(q, p) * s;
+		return p + t * w + vec3::cross(q, t);
+	#endif
 	}
 
 	inline mat4 toMatrix() const {
 		quat q = normalized();
+	#if defined(__SSE__)
+		// lanes are (w, x, y, z), every row is 1 - diagonal products plus/minus cross terms
+		const __m128 keep3 = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+		__m128 a = q.v.v;
+		__m128 a2 = _mm_add_ps(a, a);
+
+		mat4 result;
+		__m128 p = _mm_mul_ps(detail::swizzle<2, 1, 1, 0>(a), detail::swizzle<2, 2, 3, 0>(a2));	// yy xy xz
+		__m128 m = _mm_mul_ps(detail::swizzle<3, 0, 0, 0>(a), detail::swizzle<3, 3, 2, 0>(a2));	// zz wz wy
+		p = _mm_xor_ps(p, _mm_setr_ps(-0.0f, 0.0f, 0.0f, 0.0f));
+		m = _mm_xor_ps(m, _mm_setr_ps(-0.0f, -0.0f, 0.0f, 0.0f));
+		result.row[0] = _mm_add_ps(_mm_and_ps(_mm_add_ps(p, m), keep3), _mm_setr_ps(1.0f, 0.0f, 0.0f, 0.0f));
+
+		p = _mm_mul_ps(detail::swizzle<1, 1, 2, 0>(a), detail::swizzle<2, 1, 3, 0>(a2));			// xy xx yz
+		m = _mm_mul_ps(detail::swizzle<0, 3, 0, 0>(a), detail::swizzle<3, 3, 1, 0>(a2));			// wz zz wx
+		p = _mm_xor_ps(p, _mm_setr_ps(0.0f, -0.0f, 0.0f, 0.0f));
+		m = _mm_xor_ps(m, _mm_setr_ps(0.0f, -0.0f, -0.0f, 0.0f));
+		result.row[1] = _mm_add_ps(_mm_and_ps(_mm_add_ps(p, m), keep3), _mm_setr_ps(0.0f, 1.0f, 0.0f, 0.0f));
+
+		p = _mm_mul_ps(detail::swizzle<1, 2, 1, 0>(a), detail::swizzle<3, 3, 1, 0>(a2));			// xz yz xx
+		m = _mm_mul_ps(detail::swizzle<0, 0, 2, 0>(a), detail::swizzle<2, 1, 2, 0>(a2));			// wy wx yy
+		p = _mm_xor_ps(p, _mm_setr_ps(0.0f, 0.0f, -0.0f, 0.0f));
+		m = _mm_xor_ps(m, _mm_setr_ps(-0.0f, 0.0f, -0.0f, 0.0f));
+		result.row[2] = _mm_add_ps(_mm_and_ps(_mm_add_ps(p, m), keep3), _mm_setr_ps(0.0f, 0.0f, 1.0f, 0.0f));
+
+		result.row[3] = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+		return result;
+	#else
 		float w = q.w, x = q.x, y = q.y, z = q.z;
 
 		float xx = x * x, yy = y * y, zz = z * z;
@@ -222,12 +299,36 @@ struct quat
 		result.m[2][0] = 2 * (xz - wy);		result.m[2][1] = 2 * (yz + wx);		result.m[2][2] = 1 - 2 * (xx + yy);	result.m[2][3] = 0;
 		result.m[3][0] = 0;					result.m[3][1] = 0;					result.m[3][2] = 0;					result.m[3][3] = 1;
 		return result;
+	#endif
 	}
 
+private:
+#if defined(__SSE__)
+	static inline quat from_m128(__m128 r) {
+		quat q;
+		q.v.v = r;
+		return q;
+	}
+#endif
 };
 
 inline quat operator*(float s, const quat& q) {
 	return q * s;
 }
 
+/**
+ * Batched quaternion kernels for animation sampling, 8 quaternions per iteration in SoA form
+ * Spans must have the same size, out may alias an input
+ * parallel splits spans larger than a few thousand elements across hardware threads
+ *
+ * slerp_many:  a and b are expected to be unit quaternions (animation keys), the shortest
+ *              arc is taken and the result is renormalized. Uses a polynomial fit of the
+ *              slerp weights instead of acos/sin, weights within 1e-6
+ * rotate_many: same result as quat::rotate for each (q[i], in[i]) pair, or for one
+ *              quaternion applied to every vector
+ */
+void slerp_many(std::span<const quat> a, std::span<const quat> b, std::span<const float> t, std::span<quat> out, bool parallel = false);
+void rotate_many(std::span<const quat> q, std::span<const vec3> in, std::span<vec3> out, bool parallel = false);
+void rotate_many(const quat& q, std::span<const vec3> in, std::span<vec3> out, bool parallel = false);
+
 }
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+
+#include "math/vec3.hpp"
+#include "math/vec4.hpp"
+
+namespace cu::math {
+
+/**
+ * Ray with its reciprocal direction precomputed for the slab test
+ * A zero direction component gives +-inf in inv_dir, which the slab test handles
+ * https://pbr-book.org/4ed/Geometry_and_Transformations/Rays
+ */
+struct ray
+{
+	vec3	origin;
+	float	tmin;
+	vec3	dir;
+	float	tmax;
+	vec3	inv_dir;
+
+	ray() : tmin(0.0f), tmax(std::numeric_limits<float>::infinity()) {}
+	ray(const vec3& origin, const vec3& dir,
+		float tmin = 0.0f, float tmax = std::numeric_limits<float>::infinity())
+		: origin(origin), tmin(tmin), dir(dir), tmax(tmax),
+		  inv_dir(1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z) {}
+	ray(const vec4& origin, const vec4& dir,
+		float tmin = 0.0f, float tmax = std::numeric_limits<float>::infinity())
+		: ray(vec3(origin.x, origin.y, origin.z), vec3(dir.x, dir.y, dir.z), tmin, tmax) {}
+
+	inline vec3 at(float t) const { return origin + dir * t; }
+};
+
+/**
+ * Axis-aligned bounding box, default constructed empty (min = +inf, max = -inf)
+ * so that expand() works from the first point
+ */
+struct aabb
+{
+	vec3 min, max;
+
+	aabb() : min(std::numeric_limits<float>::infinity()), max(-std::numeric_limits<float>::infinity()) {}
+	aabb(const vec3& min, const vec3& max) : min(min), max(max) {}
+
+	// plain compares instead of std::fmin/fmax, which are libm calls without -ffast-math
+	inline aabb& expand(const vec3& p)
+	{
+		min = {p.x < min.x ? p.x : min.x, p.y < min.y ? p.y : min.y, p.z < min.z ? p.z : min.z};
+		max = {p.x > max.x ? p.x : max.x, p.y > max.y ? p.y : max.y, p.z > max.z ? p.z : max.z};
+		return *this;
+	}
+
+	inline aabb& expand(const aabb& b)
+	{
+		min = {b.min.x < min.x ? b.min.x : min.x, b.min.y < min.y ? b.min.y : min.y, b.min.z < min.z ? b.min.z : min.z};
+		max = {b.max.x > max.x ? b.max.x : max.x, b.max.y > max.y ? b.max.y : max.y, b.max.z > max.z ? b.max.z : max.z};
+		return *this;
+	}
+
+	inline bool empty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+	inline vec3 center() const { return (min + max) * 0.5f; }
+	inline vec3 extent() const { return max - min; }
+
+	inline float surface_area() const
+	{
+		if (empty())
+			return 0.0f;
+		vec3 e = extent();
+		return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+	}
+
+	/** 0 = x, 1 = y, 2 = z */
+	inline int largest_axis() const
+	{
+		vec3 e = extent();
+		return e.x > e.y ? (e.x > e.z ? 0 : 2) : (e.y > e.z ? 1 : 2);
+	}
+};
+
+}
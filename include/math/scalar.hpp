@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+#include "math/fast.hpp"
+
+namespace cu::math::scalar {
+
+/**
+ * constexpr versions of the <cmath> functions used by the vector/matrix templates
+ * Constant evaluation goes through double precision series, runtime calls the libm
+ * function so there is no cost outside of constexpr contexts
+ *
+ * Building with CU_FAST_MATH sends the float runtime calls to cu::math::fast instead
+ */
+#if defined(CU_FAST_MATH)
+inline constexpr bool fast_math = true;
+#else
+inline constexpr bool fast_math = false;
+#endif
+
+namespace detail {
+
+inline constexpr double pi = 3.14159265358979323846;
+
+constexpr double sqrt(double x)
+{
+	if (!(x > 0.0) || x == std::numeric_limits<double>::infinity())
+		return x == 0.0 || x == std::numeric_limits<double>::infinity() ? x : std::numeric_limits<double>::quiet_NaN();
+
+	// scale into [0.25, 1) by powers of 4 so Newton starts close and needs few steps
+	double scale = 1.0;
+	while (x >= 1.0) { x *= 0.25; scale *= 2.0; }
+	while (x < 0.25) { x *= 4.0; scale *= 0.5; }
+
+	double r = 0.5 + 0.5 * x;
+	for (int i = 0; i < 8; ++i)
+		r = 0.5 * (r + x / r);
+	return r * scale;
+}
+
+// Taylor series on [-pi, pi] after reduction, converges to double precision in 30 terms
+constexpr double sin(double x)
+{
+	double k = x / (2.0 * pi);
+	k = static_cast<double>(static_cast<long long>(k + (k < 0.0 ? -0.5 : 0.5)));
+	x -= k * 2.0 * pi;
+
+	double term = x, sum = x, x2 = x * x;
+	for (int n = 1; n < 30; ++n)
+	{
+		term *= -x2 / ((2.0 * n) * (2.0 * n + 1.0));
+		sum += term;
+	}
+	return sum;
+}
+
+constexpr double cos(double x) { return sin(x + 0.5 * pi); }
+
+template <typename T>
+inline constexpr bool use_fast = fast_math && std::is_same_v<T, float>;
+
+template <typename T>
+constexpr auto narrow(T x)
+{
+	if constexpr (std::is_floating_point_v<T>)
+		return x;
+	else
+		return static_cast<float>(x);
+}
+
+}
+
+/**
+ * Type the matrix builders evaluate trig in: double so that constexpr and runtime
+ * results match bit for bit, float when CU_FAST_MATH trades that for speed
+ */
+template <typename T>
+using trig_t = std::conditional_t<fast_math && !std::is_same_v<T, double>, float, double>;
+
+/** x as a double, storage types (half) convert through float */
+template <typename T>
+constexpr double widen(T x)
+{
+	if constexpr (std::is_floating_point_v<T>)
+		return static_cast<double>(x);
+	else
+		return static_cast<double>(static_cast<float>(x));
+}
+
+template <typename T>
+constexpr T sqrt(T x)
+{
+	if (std::is_constant_evaluated())
+		return static_cast<T>(detail::sqrt(widen(x)));
+	return static_cast<T>(std::sqrt(detail::narrow(x)));
+}
+
+template <typename T>
+constexpr T sin(T x)
+{
+	if (std::is_constant_evaluated())
+		return static_cast<T>(detail::sin(widen(x)));
+	if constexpr (detail::use_fast<T>)
+		return fast::sin(x);
+	return static_cast<T>(std::sin(detail::narrow(x)));
+}
+
+template <typename T>
+constexpr T cos(T x)
+{
+	if (std::is_constant_evaluated())
+		return static_cast<T>(detail::cos(widen(x)));
+	if constexpr (detail::use_fast<T>)
+		return fast::cos(x);
+	return static_cast<T>(std::cos(detail::narrow(x)));
+}
+
+template <typename T>
+constexpr T tan(T x)
+{
+	if (std::is_constant_evaluated())
+		return static_cast<T>(detail::sin(widen(x)) / detail::cos(widen(x)));
+	if constexpr (detail::use_fast<T>)
+		return fast::tan(x);
+	return static_cast<T>(std::tan(detail::narrow(x)));
+}
+
+/** 1 / sqrt(x), normalize() multiplies by it when CU_FAST_MATH is on */
+template <typename T>
+constexpr T rsqrt(T x)
+{
+	if (std::is_constant_evaluated())
+		return static_cast<T>(1.0 / detail::sqrt(widen(x)));
+	if constexpr (detail::use_fast<T>)
+		return fast::rsqrt(x);
+	return static_cast<T>(T(1) / std::sqrt(detail::narrow(x)));
+}
+
+// runtime only, the inverse functions have no constexpr caller
+
+template <typename T>
+inline T asin(T x)
+{
+	if constexpr (detail::use_fast<T>)
+		return fast::asin(x);
+	return static_cast<T>(std::asin(detail::narrow(x)));
+}
+
+template <typename T>
+inline T acos(T x)
+{
+	if constexpr (detail::use_fast<T>)
+		return fast::acos(x);
+	return static_cast<T>(std::acos(detail::narrow(x)));
+}
+
+template <typename T>
+inline T atan2(T y, T x)
+{
+	if constexpr (detail::use_fast<T>)
+		return fast::atan2(y, x);
+	return static_cast<T>(std::atan2(detail::narrow(y), detail::narrow(x)));
+}
+
+}
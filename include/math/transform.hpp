@@ -1,18 +1,158 @@
 #pragma once
 
+#include <span>
+#include <type_traits>
+
 #include "math/vec3.hpp"
 #include "math/mat4.hpp"
 
 namespace cu::math {
 
-mat4 rotate(mat4 model, float angle, const vec3& axis);
-mat4 getRotationMatrix(float angle, const vec3& axis);
-mat4 lookAt(const vec3& eye, const vec3& center, const vec3& up);
-mat4 perspective(float fov_y, float aspect, float near, float far);
+/**
+ * Matrix builders, constexpr for every precision: constexpr mat4 proj = perspective(...)
+ * is folded at compile time, perspective<double>(...) / lookAt(dvec3...) give dmat4
+ * The float overloads keep braced and mixed int/float arguments working
+ */
+
+/**
+ * https://fr.wikipedia.org/wiki/Matrice_de_rotation
+ */
+template <typename T>
+constexpr mat<T, 4, 4> getRotationMatrix(std::type_identity_t<T> angle, const vec<T, 3>& axis)
+{
+	// trig in double, float results match the libm double calls this used to make
+	using trig = scalar::trig_t<T>;
+	vec<T, 3> a = axis.normalized();
+	T c = static_cast<T>(scalar::cos(static_cast<trig>(scalar::widen(angle))));
+	T s = static_cast<T>(scalar::sin(static_cast<trig>(scalar::widen(angle))));
+	T x = a.x, y = a.y, z = a.z;
+
+	mat<T, 4, 4> r;
+	r.m[0][0] = c + x*x*(1-c);
+	r.m[1][0] = x*y*(1-c) - z*s;
+	r.m[2][0] = x*z*(1-c) + y*s;
+	r.m[3][0] = 0;
+
+	r.m[0][1] = y*x*(1-c) + z*s;
+	r.m[1][1] = c + y*y*(1-c);
+	r.m[2][1] = y*z*(1-c) - x*s;
+	r.m[3][1] = 0;
+
+	r.m[0][2] = z*x*(1-c) - y*s;
+	r.m[1][2] = z*y*(1-c) + x*s;
+	r.m[2][2] = c + z*z*(1-c);
+	r.m[3][2] = 0;
+
+	r.m[0][3] = 0;
+	r.m[1][3] = 0;
+	r.m[2][3] = 0;
+	r.m[3][3] = 1;
+	return r;
+}
+
+template <typename T>
+constexpr mat<T, 4, 4> rotate(const mat<T, 4, 4>& model, std::type_identity_t<T> angle, const vec<T, 3>& axis)
+{
+	return model * getRotationMatrix<T>(angle, axis);
+}
+
+template <typename T>
+constexpr mat<T, 4, 4> lookAt(const vec<T, 3>& eye, const vec<T, 3>& center, const vec<T, 3>& up)
+{
+	using v3 = vec<T, 3>;
+	v3 const f(v3::normalize(center - eye));
+	v3 const s(v3::normalize(v3::cross(f, up)));
+	v3 const u(v3::cross(s, f));
+
+	mat<T, 4, 4> res(1);
+
+	res.m[0][0] = s.x;
+	res.m[1][0] = s.y;
+	res.m[2][0] = s.z;
+
+	res.m[0][1] = u.x;
+	res.m[1][1] = u.y;
+	res.m[2][1] = u.z;
+
+	res.m[0][2] = -f.x;
+	res.m[1][2] = -f.y;
+	res.m[2][2] = -f.z;
+
+	res.m[3][0] = -v3::dot(s, eye);
+	res.m[3][1] = -v3::dot(u, eye);
+	res.m[3][2] =  v3::dot(f, eye);
+
+	return res;
+}
+
+/**
+ * https://www.scratchapixel.com/lessons/3d-basic-rendering/perspective-and-orthographic-projection-matrix/opengl-perspective-projection-matrix.html
+ * + y inversion to match vulkan perspective
+*/
+template <typename T>
+constexpr mat<T, 4, 4> perspective(std::type_identity_t<T> fov_y, std::type_identity_t<T> aspect, std::type_identity_t<T> near, std::type_identity_t<T> far)
+{
+	using trig = scalar::trig_t<T>;
+	const T f = static_cast<T>(trig(1) / scalar::tan(static_cast<trig>(scalar::widen(fov_y / T(2)))));
+
+	mat<T, 4, 4> m(0);
+	m.m[0][0] = f / aspect;
+	m.m[1][1] = -f;
+	m.m[2][2] = -(far + near) / (far - near);
+	m.m[2][3] = T(-1);
+	m.m[3][2] = -(T(2) * far * near) / (far - near);
+	return m;
+}
+
+template <typename T, int N>
+constexpr mat<T, 4, 4> translate(const mat<T, 4, 4>& m, const vec<T, N>& v) requires (N == 3 || N == 4)
+{
+	mat<T, 4, 4> r = m;
+	r.m[0][3] += v.x;
+	r.m[1][3] += v.y;
+	r.m[2][3] += v.z;
+	return r;
+}
+
+template <typename T, int N>
+constexpr mat<T, 4, 4> scale(const mat<T, 4, 4>& m, const vec<T, N>& v) requires (N == 3 || N == 4)
+{
+	mat<T, 4, 4> r = m;
+	r.m[0][0] *= v.x;
+	r.m[1][1] *= v.y;
+	r.m[2][2] *= v.z;
+	return r;
+}
+
+constexpr mat4 getRotationMatrix(float angle, const vec3& axis) { return getRotationMatrix<float>(angle, axis); }
+constexpr mat4 rotate(mat4 model, float angle, const vec3& axis) { return rotate<float>(model, angle, axis); }
+constexpr mat4 lookAt(const vec3& eye, const vec3& center, const vec3& up) { return lookAt<float>(eye, center, up); }
+constexpr mat4 perspective(float fov_y, float aspect, float near, float far) { return perspective<float>(fov_y, aspect, near, far); }
+
+constexpr mat4 translate(const mat4& m, const vec3& v) { return translate<float, 3>(m, v); }
+constexpr mat4 translate(const mat4& m, const vec4& v) { return translate<float, 4>(m, v); }
+constexpr mat4 scale(const mat4& m, const vec3& v) { return scale<float, 3>(m, v); }
+constexpr mat4 scale(const mat4& m, const vec4& v) { return scale<float, 4>(m, v); }
+
+/**
+ * Batched transforms, same convention as mat4::mul_vec (m[3] holds the translation)
+ * in and out must have the same size, in-place (in.data() == out.data()) is allowed
+ * parallel splits spans larger than a few thousand elements across hardware threads
+ * Baseline builds switch to AVX2 + FMA kernels at load time on CPUs that have them (cpu.hpp)
+ *
+ * points:     w = 1, projective row ignored
+ * directions: w = 0
+ * normals:    inverse-transpose of the upper 3x3, renormalized
+ */
+void transform_points(const mat4& m, std::span<const vec3> in, std::span<vec3> out, bool parallel = false);
+void transform_directions(const mat4& m, std::span<const vec3> in, std::span<vec3> out, bool parallel = false);
+void transform_normals(const mat4& m, std::span<const vec3> in, std::span<vec3> out, bool parallel = false);
 
-mat4 translate(const mat4& m, const vec3& v);
-mat4 translate(const mat4& m, const vec4& v);
-mat4 scale(const mat4& m, const vec3& v);
-mat4 scale(const mat4& m, const vec4& v);
+/**
+ * out[i] = a[i] * b[i], or a[i] * b for every i (world * view_proj), in-place allowed
+ * Same dispatch as the transforms above, the AVX2 kernel handles two rows per register
+ */
+void multiply(std::span<const mat4> a, std::span<const mat4> b, std::span<mat4> out, bool parallel = false);
+void multiply(std::span<const mat4> a, const mat4& b, std::span<mat4> out, bool parallel = false);
 
 }
\ No newline at end of file
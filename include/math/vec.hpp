@@ -0,0 +1,286 @@
+#pragma once
+
+#include <type_traits>
+
+#include "math/half.hpp"
+#include "math/scalar.hpp"
+
+#if defined(__SSE__) || defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+namespace cu::math {
+
+namespace detail {
+
+/** Named components up to 4, plain array past that */
+template <typename T, int N>
+struct vec_storage
+{
+	T e[N];
+
+	constexpr T& operator[](int i) { return e[i]; }
+	constexpr const T& operator[](int i) const { return e[i]; }
+};
+
+template <typename T>
+struct vec_storage<T, 2>
+{
+	T x, y;
+
+	constexpr T& operator[](int i) { return i == 0 ? x : y; }
+	constexpr const T& operator[](int i) const { return i == 0 ? x : y; }
+};
+
+template <typename T>
+struct vec_storage<T, 3>
+{
+	T x, y, z;
+
+	constexpr T& operator[](int i) { return i == 0 ? x : (i == 1 ? y : z); }
+	constexpr const T& operator[](int i) const { return i == 0 ? x : (i == 1 ? y : z); }
+};
+
+template <typename T>
+struct vec_storage<T, 4>
+{
+	T x, y, z, w;
+
+	constexpr T& operator[](int i) { return i == 0 ? x : (i == 1 ? y : (i == 2 ? z : w)); }
+	constexpr const T& operator[](int i) const { return i == 0 ? x : (i == 1 ? y : (i == 2 ? z : w)); }
+};
+
+// sums of half products are accumulated in float
+template <typename T>
+using accumulate_t = std::conditional_t<std::is_floating_point_v<T>, T, float>;
+
+}
+
+/**
+ * N-component vector, every operation is constexpr
+ * vec<float, 4> (SSE) and vec<double, 4> (AVX) are specialized below, their
+ * constant-evaluated paths are scalar so they stay usable in constexpr code
+ */
+template <typename T, int N>
+struct vec : detail::vec_storage<T, N>
+{
+	using value_type = T;
+	static constexpr int size = N;
+
+	constexpr vec() : detail::vec_storage<T, N>{} {}
+	constexpr vec(T n) : vec() { for (int i = 0; i < N; ++i) (*this)[i] = n; }
+	constexpr vec(T x, T y) requires (N == 2) : detail::vec_storage<T, N>{x, y} {}
+	constexpr vec(T x, T y, T z) requires (N == 3) : detail::vec_storage<T, N>{x, y, z} {}
+	constexpr vec(T x, T y, T z, T w) requires (N == 4) : detail::vec_storage<T, N>{x, y, z, w} {}
+
+	template <typename U>
+	explicit constexpr vec(const vec<U, N>& o) : vec() { for (int i = 0; i < N; ++i) (*this)[i] = static_cast<T>(o[i]); }
+
+	constexpr vec operator+(const vec& o) const { vec r; for (int i = 0; i < N; ++i) r[i] = (*this)[i] + o[i]; return r; }
+	constexpr vec operator-(const vec& o) const { vec r; for (int i = 0; i < N; ++i) r[i] = (*this)[i] - o[i]; return r; }
+	constexpr vec operator*(const vec& o) const { vec r; for (int i = 0; i < N; ++i) r[i] = (*this)[i] * o[i]; return r; }
+	constexpr vec operator/(const vec& o) const { vec r; for (int i = 0; i < N; ++i) r[i] = (*this)[i] / o[i]; return r; }
+	constexpr vec operator*(T s) const { vec r; for (int i = 0; i < N; ++i) r[i] = (*this)[i] * s; return r; }
+	constexpr vec operator/(T s) const { vec r; for (int i = 0; i < N; ++i) r[i] = (*this)[i] / s; return r; }
+	constexpr vec operator-() const { vec r; for (int i = 0; i < N; ++i) r[i] = -(*this)[i]; return r; }
+
+	constexpr vec& operator+=(const vec& o) { return *this = *this + o; }
+	constexpr vec& operator-=(const vec& o) { return *this = *this - o; }
+	constexpr vec& operator*=(T s) { return *this = *this * s; }
+	constexpr vec& operator/=(T s) { return *this = *this / s; }
+
+	constexpr bool operator==(const vec& o) const
+	{
+		for (int i = 0; i < N; ++i)
+			if (!((*this)[i] == o[i]))
+				return false;
+		return true;
+	}
+
+	static constexpr T dot(const vec& a, const vec& b) { return static_cast<T>(dot_acc(a, b)); }
+
+	static constexpr vec cross(const vec& a, const vec& b) requires (N == 3)
+	{
+		return {
+			a.y * b.z - a.z * b.y,
+			a.z * b.x - a.x * b.z,
+			a.x * b.y - a.y * b.x
+		};
+	}
+
+	static constexpr vec normalize(const vec& v) { return v.normalized(); }
+
+	constexpr T length() const { return static_cast<T>(scalar::sqrt(dot_acc(*this, *this))); }
+	constexpr T length_sq() const { return dot(*this, *this); }
+	constexpr vec normalized() const
+	{
+		if constexpr (scalar::fast_math && std::is_same_v<T, float>)
+		{
+			T l2 = length_sq();
+			return l2 > T(0) ? *this * scalar::rsqrt(l2) : *this;
+		}
+		T l = length();
+		return l > T(0) ? *this / l : *this;
+	}
+
+private:
+	static constexpr detail::accumulate_t<T> dot_acc(const vec& a, const vec& b)
+	{
+		using A = detail::accumulate_t<T>;
+		A r = A(0);
+		for (int i = 0; i < N; ++i)
+			r += static_cast<A>(a[i]) * static_cast<A>(b[i]);
+		return r;
+	}
+};
+
+#if defined(__SSE__)
+/**
+ * vec4 using SIMD
+ * https://www.intel.com/content/www/us/en/docs/intrinsics-guide/index.html#techs=SSE_ALL
+ */
+template <>
+struct alignas(16) vec<float, 4>
+{
+	using value_type = float;
+	static constexpr int size = 4;
+
+	union {
+		__m128 v;
+		struct { float x, y, z, w; };
+	};
+
+	constexpr vec() : x(0), y(0), z(0), w(0) {}
+	constexpr vec(float n) : x(n), y(n), z(n), w(n) {}
+	constexpr vec(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+
+	template <typename U>
+	explicit constexpr vec(const vec<U, 4>& o)
+		: x(static_cast<float>(o[0])), y(static_cast<float>(o[1])), z(static_cast<float>(o[2])), w(static_cast<float>(o[3])) {}
+
+	constexpr float& operator[](int i) { return i == 0 ? x : (i == 1 ? y : (i == 2 ? z : w)); }
+	constexpr const float& operator[](int i) const { return i == 0 ? x : (i == 1 ? y : (i == 2 ? z : w)); }
+
+	constexpr vec operator+(const vec& o) const { if (std::is_constant_evaluated()) return {x + o.x, y + o.y, z + o.z, w + o.w}; return from(_mm_add_ps(v, o.v)); }
+	constexpr vec operator-(const vec& o) const { if (std::is_constant_evaluated()) return {x - o.x, y - o.y, z - o.z, w - o.w}; return from(_mm_sub_ps(v, o.v)); }
+	constexpr vec operator*(const vec& o) const { if (std::is_constant_evaluated()) return {x * o.x, y * o.y, z * o.z, w * o.w}; return from(_mm_mul_ps(v, o.v)); }
+	constexpr vec operator/(const vec& o) const { if (std::is_constant_evaluated()) return {x / o.x, y / o.y, z / o.z, w / o.w}; return from(_mm_div_ps(v, o.v)); }
+	constexpr vec operator*(float s) const { if (std::is_constant_evaluated()) return {x * s, y * s, z * s, w * s}; return from(_mm_mul_ps(v, _mm_set1_ps(s))); }
+	constexpr vec operator/(float s) const { if (std::is_constant_evaluated()) return {x / s, y / s, z / s, w / s}; return from(_mm_div_ps(v, _mm_set1_ps(s))); }
+	constexpr vec operator-() const { if (std::is_constant_evaluated()) return {-x, -y, -z, -w}; return from(_mm_xor_ps(v, _mm_set1_ps(-0.0f))); }
+
+	constexpr vec& operator+=(const vec& o) { return *this = *this + o; }
+	constexpr vec& operator-=(const vec& o) { return *this = *this - o; }
+	constexpr vec& operator*=(float s) { return *this = *this * s; }
+	constexpr vec& operator/=(float s) { return *this = *this / s; }
+
+	constexpr bool operator==(const vec& o) const { return x == o.x && y == o.y && z == o.z && w == o.w; }
+
+	static constexpr float dot(const vec& a, const vec& b)
+	{
+		if (std::is_constant_evaluated())
+			return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+
+		__m128 t = _mm_mul_ps(a.v, b.v);
+	#if defined(__SSE3__)
+		t = _mm_hadd_ps(t, t);
+		t = _mm_hadd_ps(t, t);
+		return _mm_cvtss_f32(t);
+	#else
+		float tmp[4]; _mm_storeu_ps(tmp, t);
+		return tmp[0] + tmp[1] + tmp[2] + tmp[3];
+	#endif
+	}
+
+	static constexpr vec normalize(const vec& v) { return v.normalized(); }
+
+	constexpr float length() const { return scalar::sqrt(dot(*this, *this)); }
+	constexpr float length_sq() const { return dot(*this, *this); }
+	constexpr vec normalized() const
+	{
+		if constexpr (scalar::fast_math)
+		{
+			float l2 = length_sq();
+			return l2 > 0 ? *this * scalar::rsqrt(l2) : *this;
+		}
+		float l = length();
+		return l > 0 ? *this / l : *this;
+	}
+
+private:
+	static inline vec from(__m128 m) { vec r; r.v = m; return r; }
+};
+#endif
+
+#if defined(__AVX__)
+/**
+ * double4 in one AVX register, for large-world positions
+ * https://www.intel.com/content/www/us/en/docs/intrinsics-guide/index.html#techs=AVX_ALL
+ */
+template <>
+struct alignas(32) vec<double, 4>
+{
+	using value_type = double;
+	static constexpr int size = 4;
+
+	union {
+		__m256d v;
+		struct { double x, y, z, w; };
+	};
+
+	constexpr vec() : x(0), y(0), z(0), w(0) {}
+	constexpr vec(double n) : x(n), y(n), z(n), w(n) {}
+	constexpr vec(double x, double y, double z, double w) : x(x), y(y), z(z), w(w) {}
+
+	template <typename U>
+	explicit constexpr vec(const vec<U, 4>& o)
+		: x(static_cast<double>(o[0])), y(static_cast<double>(o[1])), z(static_cast<double>(o[2])), w(static_cast<double>(o[3])) {}
+
+	constexpr double& operator[](int i) { return i == 0 ? x : (i == 1 ? y : (i == 2 ? z : w)); }
+	constexpr const double& operator[](int i) const { return i == 0 ? x : (i == 1 ? y : (i == 2 ? z : w)); }
+
+	constexpr vec operator+(const vec& o) const { if (std::is_constant_evaluated()) return {x + o.x, y + o.y, z + o.z, w + o.w}; return from(_mm256_add_pd(v, o.v)); }
+	constexpr vec operator-(const vec& o) const { if (std::is_constant_evaluated()) return {x - o.x, y - o.y, z - o.z, w - o.w}; return from(_mm256_sub_pd(v, o.v)); }
+	constexpr vec operator*(const vec& o) const { if (std::is_constant_evaluated()) return {x * o.x, y * o.y, z * o.z, w * o.w}; return from(_mm256_mul_pd(v, o.v)); }
+	constexpr vec operator/(const vec& o) const { if (std::is_constant_evaluated()) return {x / o.x, y / o.y, z / o.z, w / o.w}; return from(_mm256_div_pd(v, o.v)); }
+	constexpr vec operator*(double s) const { if (std::is_constant_evaluated()) return {x * s, y * s, z * s, w * s}; return from(_mm256_mul_pd(v, _mm256_set1_pd(s))); }
+	constexpr vec operator/(double s) const { if (std::is_constant_evaluated()) return {x / s, y / s, z / s, w / s}; return from(_mm256_div_pd(v, _mm256_set1_pd(s))); }
+	constexpr vec operator-() const { if (std::is_constant_evaluated()) return {-x, -y, -z, -w}; return from(_mm256_xor_pd(v, _mm256_set1_pd(-0.0))); }
+
+	constexpr vec& operator+=(const vec& o) { return *this = *this + o; }
+	constexpr vec& operator-=(const vec& o) { return *this = *this - o; }
+	constexpr vec& operator*=(double s) { return *this = *this * s; }
+	constexpr vec& operator/=(double s) { return *this = *this / s; }
+
+	constexpr bool operator==(const vec& o) const { return x == o.x && y == o.y && z == o.z && w == o.w; }
+
+	static constexpr double dot(const vec& a, const vec& b)
+	{
+		if (std::is_constant_evaluated())
+			return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+
+		__m256d t = _mm256_mul_pd(a.v, b.v);
+		__m128d s = _mm_add_pd(_mm256_castpd256_pd128(t), _mm256_extractf128_pd(t, 1));
+		return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+	}
+
+	static constexpr vec normalize(const vec& v) { return v.normalized(); }
+
+	constexpr double length() const { return scalar::sqrt(dot(*this, *this)); }
+	constexpr double length_sq() const { return dot(*this, *this); }
+	constexpr vec normalized() const { double l = length(); return l > 0 ? *this / l : *this; }
+
+private:
+	static inline vec from(__m256d m) { vec r; r.v = m; return r; }
+};
+#endif
+
+using vec2 = vec<float, 2>;
+using vec3 = vec<float, 3>;
+using vec4 = vec<float, 4>;
+
+using dvec2 = vec<double, 2>;
+using dvec3 = vec<double, 3>;
+using dvec4 = vec<double, 4>;
+
+}
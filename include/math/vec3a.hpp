@@ -0,0 +1,173 @@
+#pragma once
+
+#include <type_traits>
+
+#include "math/mat.hpp"
+#include "math/vec3.hpp"
+
+namespace cu::math {
+
+/**
+ * vec3 padded to 16 bytes and kept in one SSE register, w stays 0
+ * For hot per-element code (particles, skinning, physics) where the packed 12-byte
+ * vec3 can only be handled one float at a time. Converts to and from vec3 implicitly,
+ * arrays of vec3a cost a third more memory than arrays of vec3
+ *
+ * dot / length sum x, y, z in the same order as vec3, so results match bit for bit
+ */
+struct alignas(16) vec3a
+{
+	using value_type = float;
+	static constexpr int size = 3;
+
+#if defined(__SSE__)
+	union {
+		__m128 v;
+		struct { float x, y, z, w; };
+	};
+#else
+	float x, y, z, w;
+#endif
+
+	constexpr vec3a() : x(0), y(0), z(0), w(0) {}
+	constexpr vec3a(float n) : x(n), y(n), z(n), w(0) {}
+	constexpr vec3a(float x, float y, float z) : x(x), y(y), z(z), w(0) {}
+	constexpr vec3a(const vec3& o) : x(o.x), y(o.y), z(o.z), w(0) {}
+
+	constexpr operator vec3() const { return {x, y, z}; }
+
+	constexpr float& operator[](int i) { return i == 0 ? x : (i == 1 ? y : z); }
+	constexpr const float& operator[](int i) const { return i == 0 ? x : (i == 1 ? y : z); }
+
+#if defined(__SSE__)
+	constexpr vec3a operator+(const vec3a& o) const { if (std::is_constant_evaluated()) return {x + o.x, y + o.y, z + o.z}; return from(_mm_add_ps(v, o.v)); }
+	constexpr vec3a operator-(const vec3a& o) const { if (std::is_constant_evaluated()) return {x - o.x, y - o.y, z - o.z}; return from(_mm_sub_ps(v, o.v)); }
+	constexpr vec3a operator*(const vec3a& o) const { if (std::is_constant_evaluated()) return {x * o.x, y * o.y, z * o.z}; return from(_mm_mul_ps(v, o.v)); }
+	constexpr vec3a operator*(float s) const { if (std::is_constant_evaluated()) return {x * s, y * s, z * s}; return from(_mm_mul_ps(v, _mm_set1_ps(s))); }
+	constexpr vec3a operator-() const { if (std::is_constant_evaluated()) return {-x, -y, -z}; return from(_mm_xor_ps(v, _mm_setr_ps(-0.0f, -0.0f, -0.0f, 0.0f))); }
+
+	// 0 / 0 in w is masked back to 0
+	constexpr vec3a operator/(const vec3a& o) const { if (std::is_constant_evaluated()) return {x / o.x, y / o.y, z / o.z}; return from(_mm_and_ps(_mm_div_ps(v, o.v), xyz_mask())); }
+	constexpr vec3a operator/(float s) const { if (std::is_constant_evaluated()) return {x / s, y / s, z / s}; return from(_mm_and_ps(_mm_div_ps(v, _mm_set1_ps(s)), xyz_mask())); }
+#else
+	constexpr vec3a operator+(const vec3a& o) const { return {x + o.x, y + o.y, z + o.z}; }
+	constexpr vec3a operator-(const vec3a& o) const { return {x - o.x, y - o.y, z - o.z}; }
+	constexpr vec3a operator*(const vec3a& o) const { return {x * o.x, y * o.y, z * o.z}; }
+	constexpr vec3a operator*(float s) const { return {x * s, y * s, z * s}; }
+	constexpr vec3a operator-() const { return {-x, -y, -z}; }
+	constexpr vec3a operator/(const vec3a& o) const { return {x / o.x, y / o.y, z / o.z}; }
+	constexpr vec3a operator/(float s) const { return {x / s, y / s, z / s}; }
+#endif
+
+	constexpr vec3a& operator+=(const vec3a& o) { return *this = *this + o; }
+	constexpr vec3a& operator-=(const vec3a& o) { return *this = *this - o; }
+	constexpr vec3a& operator*=(float s) { return *this = *this * s; }
+	constexpr vec3a& operator/=(float s) { return *this = *this / s; }
+
+	constexpr bool operator==(const vec3a& o) const { return x == o.x && y == o.y && z == o.z; }
+
+	static constexpr float dot(const vec3a& a, const vec3a& b)
+	{
+	#if defined(__SSE__)
+		if (!std::is_constant_evaluated())
+		{
+			__m128 t = _mm_mul_ps(a.v, b.v);
+			__m128 s = _mm_add_ss(t, detail::swizzle<1, 1, 1, 1>(t));
+			return _mm_cvtss_f32(_mm_add_ss(s, _mm_movehl_ps(t, t)));
+		}
+	#endif
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	static constexpr vec3a cross(const vec3a& a, const vec3a& b)
+	{
+	#if defined(__SSE__)
+		if (!std::is_constant_evaluated())
+			return from(detail::cross3(a.v, b.v));
+	#endif
+		return {
+			a.y * b.z - a.z * b.y,
+			a.z * b.x - a.x * b.z,
+			a.x * b.y - a.y * b.x
+		};
+	}
+
+	static constexpr vec3a min(const vec3a& a, const vec3a& b)
+	{
+	#if defined(__SSE__)
+		if (!std::is_constant_evaluated())
+			return from(_mm_min_ps(a.v, b.v));
+	#endif
+		return {a.x < b.x ? a.x : b.x, a.y < b.y ? a.y : b.y, a.z < b.z ? a.z : b.z};
+	}
+
+	static constexpr vec3a max(const vec3a& a, const vec3a& b)
+	{
+	#if defined(__SSE__)
+		if (!std::is_constant_evaluated())
+			return from(_mm_max_ps(a.v, b.v));
+	#endif
+		return {a.x > b.x ? a.x : b.x, a.y > b.y ? a.y : b.y, a.z > b.z ? a.z : b.z};
+	}
+
+	static constexpr vec3a normalize(const vec3a& v) { return v.normalized(); }
+
+	constexpr float length() const { return scalar::sqrt(dot(*this, *this)); }
+	constexpr float length_sq() const { return dot(*this, *this); }
+	constexpr vec3a normalized() const
+	{
+		if constexpr (scalar::fast_math)
+		{
+			float l2 = length_sq();
+			return l2 > 0 ? *this * scalar::rsqrt(l2) : *this;
+		}
+		float l = length();
+		return l > 0 ? *this / l : *this;
+	}
+
+#if defined(__SSE__)
+private:
+	static inline vec3a from(__m128 m) { vec3a r; r.v = m; return r; }
+	static inline __m128 xyz_mask() { return _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0)); }
+#endif
+};
+
+static_assert(sizeof(vec3a) == 16);
+
+/** p * m with w = 1, mul_vec layout (m[3] holds the translation), the projective column is ignored */
+constexpr vec3a transform_point(const mat4& m, const vec3a& p)
+{
+#if defined(__SSE__)
+	if (!std::is_constant_evaluated())
+	{
+		__m128 r = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(detail::swizzle<0, 0, 0, 0>(p.v), m.row[0]), _mm_mul_ps(detail::swizzle<1, 1, 1, 1>(p.v), m.row[1])),
+			_mm_add_ps(_mm_mul_ps(detail::swizzle<2, 2, 2, 2>(p.v), m.row[2]), m.row[3]));
+		vec3a out;
+		out.v = _mm_and_ps(r, _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0)));
+		return out;
+	}
+#endif
+	vec4 r = m.mul_vec(vec4(p.x, p.y, p.z, 1.0f));
+	return {r.x, r.y, r.z};
+}
+
+/** p * m with w = 0 */
+constexpr vec3a transform_direction(const mat4& m, const vec3a& d)
+{
+#if defined(__SSE__)
+	if (!std::is_constant_evaluated())
+	{
+		__m128 r = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(detail::swizzle<0, 0, 0, 0>(d.v), m.row[0]), _mm_mul_ps(detail::swizzle<1, 1, 1, 1>(d.v), m.row[1])),
+			_mm_mul_ps(detail::swizzle<2, 2, 2, 2>(d.v), m.row[2]));
+		vec3a out;
+		out.v = _mm_and_ps(r, _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0)));
+		return out;
+	}
+#endif
+	vec4 r = m.mul_vec(vec4(d.x, d.y, d.z, 0.0f));
+	return {r.x, r.y, r.z};
+}
+
+}
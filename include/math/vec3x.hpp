@@ -0,0 +1,320 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+
+#include "cpu.hpp"
+#include "math/vec3.hpp"
+#include "math/floatx4.hpp"
+#include "math/floatx8.hpp"
+
+namespace cu::math {
+
+namespace detail {
+
+static_assert(sizeof(vec3) == 3 * sizeof(float), "vec3 must stay tightly packed for the packet loads");
+
+#if defined(__SSE__)
+/**
+ * 4 packed vec3 (12 floats) to SoA x/y/z, 3 loads + 5 shuffles
+ * https://www.intel.com/content/dam/develop/external/us/en/documents/normvec-181650.pdf
+ */
+inline void load_xyz4(const float* p, __m128& x, __m128& y, __m128& z)
+{
+	__m128 a0 = _mm_loadu_ps(p);		// x0 y0 z0 x1
+	__m128 a1 = _mm_loadu_ps(p + 4);	// y1 z1 x2 y2
+	__m128 a2 = _mm_loadu_ps(p + 8);	// z2 x3 y3 z3
+
+	__m128 x2y2x3y3 = _mm_shuffle_ps(a1, a2, _MM_SHUFFLE(2,1,3,2));
+	__m128 y0z0y1z1 = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(1,0,2,1));
+
+	x = _mm_shuffle_ps(a0, x2y2x3y3, _MM_SHUFFLE(2,0,3,0));
+	y = _mm_shuffle_ps(y0z0y1z1, x2y2x3y3, _MM_SHUFFLE(3,1,2,0));
+	z = _mm_shuffle_ps(y0z0y1z1, a2, _MM_SHUFFLE(3,0,3,1));
+}
+
+inline void store_xyz4(float* p, __m128 x, __m128 y, __m128 z)
+{
+	__m128 xy01 = _mm_unpacklo_ps(x, y);	// x0 y0 x1 y1
+	__m128 xy23 = _mm_unpackhi_ps(x, y);	// x2 y2 x3 y3
+
+	__m128 z0x1 = _mm_shuffle_ps(z, xy01, _MM_SHUFFLE(3,2,0,0));
+	__m128 y1z1 = _mm_shuffle_ps(xy01, z, _MM_SHUFFLE(1,1,3,3));
+	__m128 z2x3 = _mm_shuffle_ps(z, xy23, _MM_SHUFFLE(2,2,2,2));
+	__m128 y3z3 = _mm_shuffle_ps(xy23, z, _MM_SHUFFLE(3,3,3,3));
+
+	_mm_storeu_ps(p,     _mm_shuffle_ps(xy01, z0x1, _MM_SHUFFLE(2,0,1,0)));
+	_mm_storeu_ps(p + 4, _mm_shuffle_ps(y1z1, xy23, _MM_SHUFFLE(1,0,2,0)));
+	_mm_storeu_ps(p + 8, _mm_shuffle_ps(z2x3, y3z3, _MM_SHUFFLE(2,0,2,0)));
+}
+#endif
+
+#if defined(__AVX2__) || CU_MULTIVERSION
+/**
+ * 8 packed vec3 (24 floats) to SoA x/y/z
+ * Every component sits at distinct positions of the 3 loads, so 2 blends
+ * gather it into one register and a single lane permute puts it in order
+ * Also built for the AVX2 kernels of baseline builds (CU_TARGET_AVX2)
+ */
+CU_TARGET_AVX2 inline void load_xyz8(const float* p, __m256& x, __m256& y, __m256& z)
+{
+	__m256 a0 = _mm256_loadu_ps(p);			// x0 y0 z0 x1 y1 z1 x2 y2
+	__m256 a1 = _mm256_loadu_ps(p + 8);		// z2 x3 y3 z3 x4 y4 z4 x5
+	__m256 a2 = _mm256_loadu_ps(p + 16);	// y5 z5 x6 y6 z6 x7 y7 z7
+
+	__m256 bx = _mm256_blend_ps(_mm256_blend_ps(a0, a1, 0x92), a2, 0x24);
+	__m256 by = _mm256_blend_ps(_mm256_blend_ps(a0, a1, 0x24), a2, 0x49);
+	__m256 bz = _mm256_blend_ps(_mm256_blend_ps(a0, a1, 0x49), a2, 0x92);
+
+	x = _mm256_permutevar8x32_ps(bx, _mm256_setr_epi32(0, 3, 6, 1, 4, 7, 2, 5));
+	y = _mm256_permutevar8x32_ps(by, _mm256_setr_epi32(1, 4, 7, 2, 5, 0, 3, 6));
+	z = _mm256_permutevar8x32_ps(bz, _mm256_setr_epi32(2, 5, 0, 3, 6, 1, 4, 7));
+}
+
+CU_TARGET_AVX2 inline void store_xyz8(float* p, __m256 x, __m256 y, __m256 z)
+{
+	__m256 bx = _mm256_permutevar8x32_ps(x, _mm256_setr_epi32(0, 3, 6, 1, 4, 7, 2, 5));
+	__m256 by = _mm256_permutevar8x32_ps(y, _mm256_setr_epi32(5, 0, 3, 6, 1, 4, 7, 2));
+	__m256 bz = _mm256_permutevar8x32_ps(z, _mm256_setr_epi32(2, 5, 0, 3, 6, 1, 4, 7));
+
+	_mm256_storeu_ps(p,      _mm256_blend_ps(_mm256_blend_ps(bx, by, 0x92), bz, 0x24));
+	_mm256_storeu_ps(p + 8,  _mm256_blend_ps(_mm256_blend_ps(bx, by, 0x24), bz, 0x49));
+	_mm256_storeu_ps(p + 16, _mm256_blend_ps(_mm256_blend_ps(bx, by, 0x49), bz, 0x92));
+}
+#endif
+
+}
+
+/**
+ * Structure-of-arrays vec3 packet: lane i of x/y/z is one vec3
+ * Mirrors the vec3 API so scalar code can be widened by swapping the type,
+ * comparisons return F::mask and branches become select()
+ *
+ * vec3x4 -> SSE, vec3x8 -> AVX (two SSE halves when AVX is not enabled)
+ */
+template <typename F>
+struct vec3xN
+{
+	using lane_type = F;
+	using mask = typename F::mask;
+	static constexpr int width = F::width;
+
+	F x, y, z;
+
+	vec3xN() {}
+	vec3xN(float n) : x(n), y(n), z(n) {}
+	vec3xN(const F& n) : x(n), y(n), z(n) {}
+	vec3xN(const F& x, const F& y, const F& z) : x(x), y(y), z(z) {}
+	vec3xN(const vec3& v) : x(v.x), y(v.y), z(v.z) {}
+
+	inline vec3xN operator+(const vec3xN& v) const { return {x + v.x, y + v.y, z + v.z}; }
+	inline vec3xN operator-(const vec3xN& v) const { return {x - v.x, y - v.y, z - v.z}; }
+	inline vec3xN operator-() const { return {-x, -y, -z}; }
+	inline vec3xN operator*(const vec3xN& v) const { return {x * v.x, y * v.y, z * v.z}; }
+	inline vec3xN operator/(const vec3xN& v) const { return {x / v.x, y / v.y, z / v.z}; }
+	inline vec3xN operator*(const F& s) const { return {x * s, y * s, z * s}; }
+	inline vec3xN operator/(const F& s) const { return *this * (F(1.0f) / s); }
+	inline vec3xN operator*(float s) const { return *this * F(s); }
+	inline vec3xN operator/(float s) const { return *this * F(1.0f / s); }
+
+	inline vec3xN& operator+=(const vec3xN& v) { x += v.x; y += v.y; z += v.z; return *this; }
+	inline vec3xN& operator-=(const vec3xN& v) { x -= v.x; y -= v.y; z -= v.z; return *this; }
+
+	inline mask operator==(const vec3xN& v) const { return (x == v.x) & (y == v.y) & (z == v.z); }
+
+	static inline F dot(const vec3xN& a, const vec3xN& b)
+	{
+		return F::fmadd(a.x, b.x, F::fmadd(a.y, b.y, a.z * b.z));
+	}
+
+	static inline vec3xN cross(const vec3xN& a, const vec3xN& b)
+	{
+		return {
+			a.y * b.z - a.z * b.y,
+			a.z * b.x - a.x * b.z,
+			a.x * b.y - a.y * b.x
+		};
+	}
+
+	/** zero-length lanes are left untouched, like vec3::normalize */
+	static inline vec3xN normalize(const vec3xN& v)
+	{
+		F l2 = dot(v, v);
+		F inv = F::select(l2 > F(0.0f), F(1.0f) / F::sqrt(l2), F(1.0f));
+		return v * inv;
+	}
+
+	/** rsqrt + one Newton step, ~22 bits of precision instead of a sqrt and a divide */
+	static inline vec3xN normalize_fast(const vec3xN& v)
+	{
+		F l2 = dot(v, v);
+		return select(l2 > F(0.0f), v * F::rsqrt(l2), v);
+	}
+
+	static inline vec3xN select(const mask& m, const vec3xN& a, const vec3xN& b)
+	{
+		return {F::select(m, a.x, b.x), F::select(m, a.y, b.y), F::select(m, a.z, b.z)};
+	}
+
+	static inline vec3xN min(const vec3xN& a, const vec3xN& b) { return {F::min(a.x, b.x), F::min(a.y, b.y), F::min(a.z, b.z)}; }
+	static inline vec3xN max(const vec3xN& a, const vec3xN& b) { return {F::max(a.x, b.x), F::max(a.y, b.y), F::max(a.z, b.z)}; }
+
+	inline F length() const { return F::sqrt(dot(*this, *this)); }
+	inline F length_sq() const { return dot(*this, *this); }
+	inline vec3xN normalized() const { return normalize(*this); }
+
+	inline vec3 get(int lane) const { return {x[lane], y[lane], z[lane]}; }
+
+	/**
+	 * Gather src[first .. first + width) into the lanes
+	 * Lanes past the end of src are zero
+	 */
+	static inline vec3xN load(std::span<const vec3> src, std::size_t first = 0)
+	{
+		std::size_t n = first < src.size() ? src.size() - first : 0;
+		const float* p = reinterpret_cast<const float*>(src.data() + first);
+
+	#if defined(__SSE__)
+		if (n >= static_cast<std::size_t>(width))
+		{
+			if constexpr (std::is_same_v<F, floatx4>)
+			{
+				vec3xN r;
+				detail::load_xyz4(p, r.x.v, r.y.v, r.z.v);
+				return r;
+			}
+			else
+			{
+			#if defined(__AVX2__)
+				vec3xN r;
+				detail::load_xyz8(p, r.x.v, r.y.v, r.z.v);
+				return r;
+			#else
+				vec3xN<floatx4> lo, hi;
+				detail::load_xyz4(p, lo.x.v, lo.y.v, lo.z.v);
+				detail::load_xyz4(p + 12, hi.x.v, hi.y.v, hi.z.v);
+				return combine(lo, hi);
+			#endif
+			}
+		}
+	#endif
+		return load_partial(p, n);
+	}
+
+	/** Gather src[idx[0]], src[idx[1]], ... (width indices) */
+	static inline vec3xN gather(std::span<const vec3> src, const std::uint32_t* idx)
+	{
+		alignas(32) float t[3][width];
+		for (int i = 0; i < width; ++i)
+		{
+			const vec3& v = src[idx[i]];
+			t[0][i] = v.x;
+			t[1][i] = v.y;
+			t[2][i] = v.z;
+		}
+		return {F::load(t[0]), F::load(t[1]), F::load(t[2])};
+	}
+
+	/**
+	 * Scatter the lanes to dst[first .. first + width)
+	 * Lanes past the end of dst are discarded
+	 */
+	inline void store(std::span<vec3> dst, std::size_t first = 0) const
+	{
+		std::size_t n = first < dst.size() ? dst.size() - first : 0;
+		float* p = reinterpret_cast<float*>(dst.data() + first);
+
+	#if defined(__SSE__)
+		if (n >= static_cast<std::size_t>(width))
+		{
+			if constexpr (std::is_same_v<F, floatx4>)
+			{
+				detail::store_xyz4(p, x.v, y.v, z.v);
+			}
+			else
+			{
+			#if defined(__AVX2__)
+				detail::store_xyz8(p, x.v, y.v, z.v);
+			#else
+				vec3xN<floatx4> lo, hi;
+				split(*this, lo, hi);
+				detail::store_xyz4(p, lo.x.v, lo.y.v, lo.z.v);
+				detail::store_xyz4(p + 12, hi.x.v, hi.y.v, hi.z.v);
+			#endif
+			}
+			return;
+		}
+	#endif
+		store_partial(p, n);
+	}
+
+private:
+	/** Tail and non-SSE path, kept out of load/store so those stay small enough to inline */
+	static vec3xN load_partial(const float* p, std::size_t n)
+	{
+		alignas(32) float t[3][width] = {};
+		for (std::size_t i = 0; i < n && i < static_cast<std::size_t>(width); ++i)
+		{
+			t[0][i] = p[i * 3 + 0];
+			t[1][i] = p[i * 3 + 1];
+			t[2][i] = p[i * 3 + 2];
+		}
+		return {F::load(t[0]), F::load(t[1]), F::load(t[2])};
+	}
+
+	void store_partial(float* p, std::size_t n) const
+	{
+		alignas(32) float t[3][width];
+		x.store(t[0]);
+		y.store(t[1]);
+		z.store(t[2]);
+		for (std::size_t i = 0; i < n && i < static_cast<std::size_t>(width); ++i)
+		{
+			p[i * 3 + 0] = t[0][i];
+			p[i * 3 + 1] = t[1][i];
+			p[i * 3 + 2] = t[2][i];
+		}
+	}
+
+	static inline F combine_lanes(const floatx4& lo, const floatx4& hi)
+	{
+	#if defined(__AVX__)
+		return F(_mm256_insertf128_ps(_mm256_castps128_ps256(lo.v), hi.v, 1));
+	#else
+		return F(lo, hi);
+	#endif
+	}
+
+	static inline void split_lanes(const F& v, floatx4& lo, floatx4& hi)
+	{
+	#if defined(__AVX__)
+		lo = floatx4(_mm256_castps256_ps128(v.v));
+		hi = floatx4(_mm256_extractf128_ps(v.v, 1));
+	#else
+		lo = v.lo;
+		hi = v.hi;
+	#endif
+	}
+
+	static inline vec3xN combine(const vec3xN<floatx4>& lo, const vec3xN<floatx4>& hi)
+	{
+		return {combine_lanes(lo.x, hi.x), combine_lanes(lo.y, hi.y), combine_lanes(lo.z, hi.z)};
+	}
+
+	static inline void split(const vec3xN& v, vec3xN<floatx4>& lo, vec3xN<floatx4>& hi)
+	{
+		split_lanes(v.x, lo.x, hi.x);
+		split_lanes(v.y, lo.y, hi.y);
+		split_lanes(v.z, lo.z, hi.z);
+	}
+};
+
+using vec3x4 = vec3xN<floatx4>;
+using vec3x8 = vec3xN<floatx8>;
+
+template <typename F>
+inline vec3xN<F> operator*(const F& s, const vec3xN<F>& v) { return v * s; }
+
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+#include "memory/arena.hpp"
+#include "memory/frame.hpp"
+#include "memory/pool.hpp"
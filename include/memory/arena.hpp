@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+namespace cu::memory {
+
+/**
+ * Bump allocator over a chain of blocks, as a std::pmr::memory_resource
+ *
+ *   cu::memory::Arena arena;
+ *   std::pmr::vector<int> v(&arena);
+ *
+ * allocate() moves a cursor, deallocate() does nothing: memory comes back all at once
+ * with rewind() to a mark(), or reset(). Both keep the blocks, which later
+ * allocations reuse, so an arena reset every frame stops calling its upstream once it
+ * has grown to the frame's peak; release() returns them. Not thread-safe, one arena
+ * per thread (see FrameAllocator)
+ */
+class Arena : public std::pmr::memory_resource
+{
+	struct Block;
+
+public:
+	/** Position to rewind() to, everything allocated after it is freed */
+	struct Marker
+	{
+		Block*	block;
+		char*	cursor;
+	};
+
+	/** Rewinds the arena to where it was at construction */
+	class Scope
+	{
+	public:
+		explicit Scope(Arena& arena) : _arena(arena), _marker(arena.mark()) {}
+		~Scope() { _arena.rewind(_marker); }
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		Arena&	_arena;
+		Marker	_marker;
+	};
+
+	static constexpr std::size_t	default_block_size = 64 << 10;
+
+	/** Blocks of block_size bytes (larger for larger allocations) from upstream */
+	explicit Arena(std::size_t block_size = default_block_size, std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+
+	/**
+	 * Starts in the caller's buffer (a stack array, say), which is never freed; the
+	 * upstream is only called once it is full
+	 */
+	Arena(void* buffer, std::size_t size, std::size_t block_size = default_block_size, std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+
+	~Arena() override;
+
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	Marker		mark() const { return {_current, _cursor}; }
+	void		rewind(Marker marker);
+	void		reset();
+	void		release();
+
+	/** Bytes handed out since the last reset(), alignment padding and unused block tails included */
+	std::size_t	used() const;
+	/** Bytes of all the blocks held */
+	std::size_t	capacity() const;
+
+	std::pmr::memory_resource*	upstream() const { return _upstream; }
+
+protected:
+	void*	do_allocate(std::size_t bytes, std::size_t alignment) override;
+	void	do_deallocate(void*, std::size_t, std::size_t) override {}
+	bool	do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+private:
+	/** Header at the start of each block, the usable bytes follow it */
+	struct Block
+	{
+		Block*		next;
+		std::size_t	size;		// usable bytes
+		bool		owned;		// from upstream, not the caller's buffer
+
+		char*	begin() { return reinterpret_cast<char*>(this + 1); }
+		char*	end() { return begin() + size; }
+	};
+
+	void*	next_block(std::size_t bytes, std::size_t alignment);
+
+	std::pmr::memory_resource*	_upstream;
+	std::size_t					_block_size;
+	Block*						_first = nullptr;
+	Block*						_current = nullptr;
+	char*						_cursor = nullptr;
+};
+
+}
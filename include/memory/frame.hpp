@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+#include "memory/arena.hpp"
+
+namespace cu::memory {
+
+/**
+ * Double-buffered arena for per-frame temporaries: flip() at the start of each frame
+ * resets the arena of two frames ago and makes it current, so what was allocated
+ * during the previous frame can still be read during this one
+ *
+ *   cu::memory::frame().flip();						// once per frame, on each thread
+ *   std::pmr::vector<Hit> hits(&cu::memory::frame());
+ *
+ * Like Arena, deallocate() does nothing and it is not thread-safe: each thread
+ * allocates from its own, frame()
+ */
+class FrameAllocator : public std::pmr::memory_resource
+{
+public:
+	explicit FrameAllocator(std::size_t block_size = Arena::default_block_size, std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+
+	/** Starts the next frame, the memory of the frame before the last one is reused */
+	void	flip()
+	{
+		_index ^= 1;
+		_arenas[_index].reset();
+	}
+
+	Arena&	current() { return _arenas[_index]; }
+	Arena&	previous() { return _arenas[_index ^ 1]; }
+
+	/** Returns the memory of both arenas to the upstream */
+	void	release();
+
+protected:
+	void*	do_allocate(std::size_t bytes, std::size_t alignment) override { return _arenas[_index].allocate(bytes, alignment); }
+	void	do_deallocate(void*, std::size_t, std::size_t) override {}
+	bool	do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+private:
+	Arena		_arenas[2];
+	unsigned	_index = 0;
+};
+
+/** The calling thread's frame allocator, freed when the thread exits */
+FrameAllocator&	frame();
+
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+
+namespace cu::memory {
+
+/**
+ * Fixed-size slots shared between threads, as a std::pmr::memory_resource
+ *
+ *   cu::memory::Pool nodes(sizeof(Node), alignof(Node));
+ *   std::pmr::list<Node> list(&nodes);
+ *
+ * allocate() and deallocate() of a slot are lock-free: freed slots form a stack,
+ * popped and pushed with one compare-and-swap on a (slot index, version) word, the
+ * version defeating ABA. Slots never handed out yet are taken with a fetch_add. Slabs
+ * of 256, 512, 1024 ... slots are allocated from upstream on demand, under a mutex,
+ * and only returned by the destructor: a slot's address is stable
+ *
+ * Larger or more aligned requests than the slot go straight to upstream
+ */
+class Pool : public std::pmr::memory_resource
+{
+public:
+	Pool(std::size_t size, std::size_t alignment = alignof(std::max_align_t), std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+	~Pool() override;
+
+	Pool(const Pool&) = delete;
+	Pool& operator=(const Pool&) = delete;
+
+	std::size_t	slot_size() const { return _slot_size; }
+	std::size_t	slot_alignment() const { return _alignment; }
+
+	/** Slots of the slabs allocated so far */
+	std::size_t	capacity() const;
+
+protected:
+	void*	do_allocate(std::size_t bytes, std::size_t alignment) override;
+	void	do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+	bool	do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+private:
+	// slab k holds first_slab << k slots, 24 slabs cover the 32 bit slot index
+	static constexpr int			first_slab_bits = 8;
+	static constexpr std::uint64_t	first_slab = std::uint64_t(1) << first_slab_bits;
+	static constexpr int			max_slabs = 32 - first_slab_bits;
+	static constexpr std::uint32_t	empty = ~0u;		// index of no slot, ends the free stack
+
+	static int				slab_of(std::uint32_t index) { return std::bit_width(std::uint64_t(index) + first_slab) - 1 - first_slab_bits; }
+
+	char*					slot(std::uint32_t index) const
+	{
+		int slab = slab_of(index);
+		return _slabs[slab].load(std::memory_order_acquire) + (std::uint64_t(index) + first_slab - (first_slab << slab)) * _slot_size;
+	}
+
+	std::uint32_t			index_of(const void* p) const;
+	char*					fresh_slot();
+
+	std::size_t					_slot_size;
+	std::size_t					_alignment;
+	std::pmr::memory_resource*	_upstream;
+
+	alignas(64) std::atomic<std::uint64_t>	_free{empty};	// version << 32 | index of the top slot
+	alignas(64) std::atomic<std::uint32_t>	_fresh{0};		// slots below it were handed out once
+	std::atomic<char*>						_slabs[max_slabs] = {};
+	std::mutex								_grow;
+};
+
+}
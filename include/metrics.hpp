@@ -0,0 +1,235 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "logger.hpp"
+
+/**
+ * Counters, gauges and latency histograms updated without locks
+ *
+ * Look a metric up by name once, keep the reference, update it from any thread:
+ *   static auto &rays = cu::metrics::counter("rays");
+ *   rays.add(n);
+ * Writers touch a cache line of their own (a shard picked by thread), readers sum the
+ * shards: reads are slower and see a value at least as recent as each shard's last
+ * update, exact once writers are quiet
+ */
+namespace cu::metrics {
+
+	namespace detail {
+
+		/** Threads with a shard of their own, later ones share one more shard */
+		inline constexpr std::size_t	max_shards = 64;
+
+		/**
+		 * The calling thread's shard. The first max_shards live threads each own one and
+		 * update it with a plain load and store, no locked instruction; a slot is handed
+		 * to a new thread when its owner exits. Any thread beyond shares the last shard
+		 * through atomic adds
+		 */
+		struct Slot
+		{
+			Slot();
+			~Slot();
+
+			Slot(const Slot &) = delete;
+			Slot &operator=(const Slot &) = delete;
+
+			std::size_t	index;		// max_shards for the shared shard
+
+			bool	owned() const { return index < max_shards; }
+		};
+
+		inline thread_local Slot	slot;
+		inline thread_local bool	slot_destroyed = false;		// set by ~Slot, the shard may belong to another thread by then
+
+		/** The calling thread's shard, the shared one once its Slot is destroyed (thread_local and static destructors) */
+		inline std::size_t	shard() { return slot_destroyed ? max_shards : slot.index; }
+
+		inline void	add(std::atomic<std::uint64_t> &v, std::uint64_t n, bool owned)
+		{
+			if (owned)
+				v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+			else
+				v.fetch_add(n, std::memory_order_relaxed);
+		}
+
+		struct alignas(64) Cell
+		{
+			std::atomic<std::uint64_t>	value{0};
+		};
+
+	}
+
+	/** Monotonic count: add() writes the thread's own cache line, value() sums the lines */
+	class Counter
+	{
+	public:
+		Counter() = default;
+
+		Counter(const Counter &) = delete;
+		Counter &operator=(const Counter &) = delete;
+
+		void	add(std::uint64_t n = 1)
+		{
+			const std::size_t i = detail::shard();
+			detail::add(_cells[i].value, n, i < detail::max_shards);
+		}
+
+		std::uint64_t	value() const;
+		void			reset();
+
+	private:
+		detail::Cell	_cells[detail::max_shards + 1];
+	};
+
+	/** Current level of something (queue depth, memory in use), last write wins */
+	class Gauge
+	{
+	public:
+		void	set(double v) { _value.store(v, std::memory_order_relaxed); }
+		void	add(double v) { _value.fetch_add(v, std::memory_order_relaxed); }
+		double	value() const { return _value.load(std::memory_order_relaxed); }
+
+	private:
+		alignas(64) std::atomic<double>	_value{0.0};
+	};
+
+	/** Merged content of a Histogram at one point in time */
+	struct HistogramSnapshot
+	{
+		std::vector<std::uint64_t>	buckets;
+		std::uint64_t	count = 0;
+		std::uint64_t	sum = 0;
+		std::uint64_t	min = 0;
+		std::uint64_t	max = 0;
+
+		double			mean() const { return count ? static_cast<double>(sum) / static_cast<double>(count) : 0.0; }
+
+		/** The value at or below which p percent of the records fall, to the bucket precision */
+		std::uint64_t	percentile(double p) const;
+	};
+
+	/**
+	 * Log-linear (HdrHistogram style) distribution of unsigned values, nanoseconds
+	 * typically: every power of two is split into 2^precision_bits linear buckets, so a
+	 * value is kept within 1 / 2^precision_bits (3 %) of itself from 0 to 2^64
+	 * http://hdrhistogram.org
+	 *
+	 * Each recording thread gets its own bucket array on first use (15 KiB); record()
+	 * is a bit scan and two increments of the thread's own array, snapshot() merges them
+	 */
+	class Histogram
+	{
+	public:
+		static constexpr unsigned		precision_bits = 5;
+		static constexpr std::size_t	sub_buckets = std::size_t(1) << precision_bits;
+		static constexpr std::size_t	bucket_count = (64 - precision_bits + 1) * sub_buckets;
+
+		Histogram() = default;
+		~Histogram();
+
+		Histogram(const Histogram &) = delete;
+		Histogram &operator=(const Histogram &) = delete;
+
+		void	record(std::uint64_t value)
+		{
+			const std::size_t	i = detail::shard();
+			Shard				*s = _shards[i].load(std::memory_order_acquire);
+			if (!s)
+				s = create(i);
+
+			bool owned = i < detail::max_shards;
+			detail::add(s->buckets[bucket(value)], 1, owned);
+			detail::add(s->sum, value, owned);
+			if (value < s->min.load(std::memory_order_relaxed))
+				lower(s->min, value, owned);
+			if (value > s->max.load(std::memory_order_relaxed))
+				raise(s->max, value, owned);
+		}
+
+		HistogramSnapshot	snapshot() const;
+		void				reset();
+
+		static std::size_t	bucket(std::uint64_t value)
+		{
+			if (value < sub_buckets)
+				return static_cast<std::size_t>(value);
+			unsigned exponent = static_cast<unsigned>(std::bit_width(value)) - 1;
+			unsigned group = exponent - precision_bits + 1;
+			return (std::size_t(group) << precision_bits) | static_cast<std::size_t>((value >> (exponent - precision_bits)) & (sub_buckets - 1));
+		}
+
+		/** Smallest and largest value of a bucket */
+		static std::uint64_t	bucket_lower(std::size_t index);
+		static std::uint64_t	bucket_upper(std::size_t index);
+
+	private:
+		struct Shard
+		{
+			std::atomic<std::uint64_t>	buckets[bucket_count] = {};
+			std::atomic<std::uint64_t>	sum{0};
+			std::atomic<std::uint64_t>	min{UINT64_MAX};
+			std::atomic<std::uint64_t>	max{0};
+		};
+
+		Shard		*create(std::size_t slot);
+		static void	lower(std::atomic<std::uint64_t> &v, std::uint64_t x, bool owned);
+		static void	raise(std::atomic<std::uint64_t> &v, std::uint64_t x, bool owned);
+
+		std::atomic<Shard *>	_shards[detail::max_shards + 1] = {};
+	};
+
+	/** Records the nanoseconds from construction to destruction */
+	class Timer
+	{
+	public:
+		explicit Timer(Histogram &h) : _histogram(h), _begin(std::chrono::steady_clock::now()) {}
+		~Timer() { _histogram.record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _begin).count())); }
+
+		Timer(const Timer &) = delete;
+		Timer &operator=(const Timer &) = delete;
+
+	private:
+		Histogram								&_histogram;
+		std::chrono::steady_clock::time_point	_begin;
+	};
+
+	/** Registered metrics, created on first lookup and alive until exit; the reference stays valid */
+	Counter		&counter(std::string_view name);
+	Gauge		&gauge(std::string_view name);
+	Histogram	&histogram(std::string_view name);
+
+	struct Snapshot
+	{
+		struct CounterValue		{ std::string name; std::uint64_t value; };
+		struct GaugeValue		{ std::string name; double value; };
+		struct HistogramValue	{ std::string name; HistogramSnapshot value; };
+
+		std::int64_t				time = 0;	// logger clock, nanoseconds
+		std::vector<CounterValue>	counters;	// sorted by name
+		std::vector<GaugeValue>		gauges;
+		std::vector<HistogramValue>	histograms;
+	};
+
+	/** Every registered metric */
+	Snapshot	snapshot();
+
+	/**
+	 * One line per metric: counters with their rate per second when a previous snapshot
+	 * is given, histograms as count / min / p50 / p90 / p99 / p99.9 / max / mean
+	 */
+	std::string	format(const Snapshot &now, const Snapshot *previous = nullptr);
+
+	/** The lines of format() through cu::logger */
+	void		log(const Snapshot &now, const Snapshot *previous = nullptr, logger::Level lvl = logger::INFO);
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace cu::parallel {
+
+inline unsigned thread_count()
+{
+	unsigned n = std::thread::hardware_concurrency();
+	return n ? n : 1;
+}
+
+/**
+ * Split [0, count) into contiguous chunks of at least min_chunk elements
+ * and call fn(begin, end) for each one, one chunk per hardware thread
+ * The calling thread runs the first chunk, returns once every chunk is done
+ */
+template <typename Fn>
+void for_chunks(std::size_t count, std::size_t min_chunk, Fn&& fn)
+{
+	if (count == 0)
+		return;
+
+	std::size_t chunks = std::min<std::size_t>(thread_count(), (count + min_chunk - 1) / std::max<std::size_t>(min_chunk, 1));
+	if (chunks <= 1)
+	{
+		fn(std::size_t(0), count);
+		return;
+	}
+
+	std::size_t step = (count + chunks - 1) / chunks;
+	std::vector<std::jthread> workers;
+	workers.reserve(chunks - 1);
+
+	for (std::size_t begin = step; begin < count; begin += step)
+		workers.emplace_back([&fn, begin, end = std::min(begin + step, count)] { fn(begin, end); });
+
+	fn(std::size_t(0), std::min(step, count));
+}
+
+/**
+ * Run a on a new thread and b on the calling one, returns once both are done
+ * Meant for recursive splits (tree builds, sorts), callers decide when a subproblem
+ * is large enough to be worth a thread
+ */
+template <typename A, typename B>
+void fork_join(A&& a, B&& b)
+{
+	std::jthread worker(std::forward<A>(a));
+	b();
+}
+
+}
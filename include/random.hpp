@@ -0,0 +1,5 @@
+#pragma once
+
+#include "random/engine.hpp"
+#include "random/sampling.hpp"
+#include "random/sequence.hpp"
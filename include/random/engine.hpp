@@ -0,0 +1,344 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include "math/floatx4.hpp"
+#include "math/floatx8.hpp"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace cu::random {
+
+/**
+ * splitmix64, seeds the other generators from a single 64 bit value
+ * https://prng.di.unimi.it/splitmix64.c
+ */
+constexpr std::uint64_t splitmix64(std::uint64_t& state)
+{
+	std::uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return z ^ (z >> 31);
+}
+
+/** Top 24 bits to [0, 1), every value exactly representable, never 1.0f */
+constexpr float to_unit_float(std::uint32_t bits)
+{
+	return static_cast<float>(bits >> 8) * 0x1p-24f;
+}
+
+/**
+ * PCG32 (XSH RR), scalar, 64 bit state and 2^63 selectable streams
+ * Meets UniformRandomBitGenerator, so it also drives the <random> distributions
+ * https://www.pcg-random.org/pdf/hmc-cs-2014-0905.pdf
+ */
+class pcg32
+{
+public:
+	using result_type = std::uint32_t;
+
+	constexpr explicit pcg32(std::uint64_t seed = 0x853c49e6748fea9bull, std::uint64_t stream = 0xda3e39cb94b95bdbull)
+		: _state(0), _inc((stream << 1) | 1u)
+	{
+		next();
+		_state += seed;
+		next();
+	}
+
+	constexpr std::uint32_t next()
+	{
+		std::uint64_t old = _state;
+		_state = old * multiplier + _inc;
+		std::uint32_t xorshifted = static_cast<std::uint32_t>(((old >> 18) ^ old) >> 27);
+		std::uint32_t rot = static_cast<std::uint32_t>(old >> 59);
+		return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+	}
+
+	constexpr std::uint32_t operator()() { return next(); }
+
+	/** [0, 1) */
+	constexpr float next_float() { return to_unit_float(next()); }
+
+	/**
+	 * Unbiased [0, range), one multiply and rarely a retry instead of a modulo
+	 * https://arxiv.org/abs/1805.10941
+	 */
+	constexpr std::uint32_t next_bounded(std::uint32_t range)
+	{
+		std::uint64_t m = std::uint64_t(next()) * range;
+		std::uint32_t low = static_cast<std::uint32_t>(m);
+		if (low < range)
+		{
+			std::uint32_t threshold = (0u - range) % range;
+			while (low < threshold)
+			{
+				m = std::uint64_t(next()) * range;
+				low = static_cast<std::uint32_t>(m);
+			}
+		}
+		return static_cast<std::uint32_t>(m >> 32);
+	}
+
+	/** Skips delta outputs in O(log delta), to split one stream between threads */
+	constexpr void advance(std::uint64_t delta)
+	{
+		std::uint64_t mul = multiplier, add = _inc;
+		std::uint64_t acc_mul = 1, acc_add = 0;
+		while (delta)
+		{
+			if (delta & 1)
+			{
+				acc_mul *= mul;
+				acc_add = acc_add * mul + add;
+			}
+			add = (mul + 1) * add;
+			mul *= mul;
+			delta >>= 1;
+		}
+		_state = acc_mul * _state + acc_add;
+	}
+
+	static constexpr std::uint32_t min() { return 0; }
+	static constexpr std::uint32_t max() { return std::numeric_limits<std::uint32_t>::max(); }
+
+private:
+	static constexpr std::uint64_t multiplier = 6364136223846793005ull;
+
+	std::uint64_t	_state;
+	std::uint64_t	_inc;
+};
+
+namespace detail {
+
+/** 4 / 8 uint32 lanes, only what the generators need: add, xor, or, shifts */
+struct alignas(16) u32x4
+{
+#if defined(__SSE2__)
+	__m128i v;
+
+	u32x4() { v = _mm_setzero_si128(); }
+	explicit u32x4(__m128i m) : v(m) {}
+
+	static inline u32x4 load(const std::uint32_t* p) { return u32x4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))); }
+	inline void store(std::uint32_t* p) const { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+
+	inline u32x4 operator+(const u32x4& o) const { return u32x4(_mm_add_epi32(v, o.v)); }
+	inline u32x4 operator^(const u32x4& o) const { return u32x4(_mm_xor_si128(v, o.v)); }
+	inline u32x4 operator|(const u32x4& o) const { return u32x4(_mm_or_si128(v, o.v)); }
+	template <int K> inline u32x4 shl() const { return u32x4(_mm_slli_epi32(v, K)); }
+	template <int K> inline u32x4 shr() const { return u32x4(_mm_srli_epi32(v, K)); }
+
+	/** to_unit_float per lane, the shifted value fits the signed conversion */
+	inline math::floatx4 to_unit() const
+	{
+		return math::floatx4(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(v, 8)), _mm_set1_ps(0x1p-24f)));
+	}
+#else
+	std::uint32_t l[4];
+
+	u32x4() : l{0, 0, 0, 0} {}
+
+	static inline u32x4 load(const std::uint32_t* p) { u32x4 r; for (int i = 0; i < 4; ++i) r.l[i] = p[i]; return r; }
+	inline void store(std::uint32_t* p) const { for (int i = 0; i < 4; ++i) p[i] = l[i]; }
+
+	inline u32x4 operator+(const u32x4& o) const { u32x4 r; for (int i = 0; i < 4; ++i) r.l[i] = l[i] + o.l[i]; return r; }
+	inline u32x4 operator^(const u32x4& o) const { u32x4 r; for (int i = 0; i < 4; ++i) r.l[i] = l[i] ^ o.l[i]; return r; }
+	inline u32x4 operator|(const u32x4& o) const { u32x4 r; for (int i = 0; i < 4; ++i) r.l[i] = l[i] | o.l[i]; return r; }
+	template <int K> inline u32x4 shl() const { u32x4 r; for (int i = 0; i < 4; ++i) r.l[i] = l[i] << K; return r; }
+	template <int K> inline u32x4 shr() const { u32x4 r; for (int i = 0; i < 4; ++i) r.l[i] = l[i] >> K; return r; }
+
+	inline math::floatx4 to_unit() const
+	{
+		return {to_unit_float(l[0]), to_unit_float(l[1]), to_unit_float(l[2]), to_unit_float(l[3])};
+	}
+#endif
+
+	template <int K> inline u32x4 rotl() const { return shl<K>() | shr<32 - K>(); }
+};
+
+struct alignas(32) u32x8
+{
+#if defined(__AVX2__)
+	__m256i v;
+
+	u32x8() { v = _mm256_setzero_si256(); }
+	explicit u32x8(__m256i m) : v(m) {}
+
+	static inline u32x8 load(const std::uint32_t* p) { return u32x8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))); }
+	inline void store(std::uint32_t* p) const { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+
+	inline u32x8 operator+(const u32x8& o) const { return u32x8(_mm256_add_epi32(v, o.v)); }
+	inline u32x8 operator^(const u32x8& o) const { return u32x8(_mm256_xor_si256(v, o.v)); }
+	inline u32x8 operator|(const u32x8& o) const { return u32x8(_mm256_or_si256(v, o.v)); }
+	template <int K> inline u32x8 shl() const { return u32x8(_mm256_slli_epi32(v, K)); }
+	template <int K> inline u32x8 shr() const { return u32x8(_mm256_srli_epi32(v, K)); }
+
+	inline math::floatx8 to_unit() const
+	{
+		return math::floatx8(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(v, 8)), _mm256_set1_ps(0x1p-24f)));
+	}
+#else
+	u32x4 lo, hi;
+
+	u32x8() {}
+	u32x8(const u32x4& lo, const u32x4& hi) : lo(lo), hi(hi) {}
+
+	static inline u32x8 load(const std::uint32_t* p) { return {u32x4::load(p), u32x4::load(p + 4)}; }
+	inline void store(std::uint32_t* p) const { lo.store(p); hi.store(p + 4); }
+
+	inline u32x8 operator+(const u32x8& o) const { return {lo + o.lo, hi + o.hi}; }
+	inline u32x8 operator^(const u32x8& o) const { return {lo ^ o.lo, hi ^ o.hi}; }
+	inline u32x8 operator|(const u32x8& o) const { return {lo | o.lo, hi | o.hi}; }
+	template <int K> inline u32x8 shl() const { return {lo.template shl<K>(), hi.template shl<K>()}; }
+	template <int K> inline u32x8 shr() const { return {lo.template shr<K>(), hi.template shr<K>()}; }
+
+	inline math::floatx8 to_unit() const
+	{
+	#if defined(__AVX__)
+		return math::floatx8(_mm256_set_m128(hi.to_unit().v, lo.to_unit().v));
+	#else
+		return {lo.to_unit(), hi.to_unit()};
+	#endif
+	}
+#endif
+
+	template <int K> inline u32x8 rotl() const { return shl<K>() | shr<32 - K>(); }
+};
+
+template <typename F>
+using u32_lanes = std::conditional_t<F::width == 4, u32x4, u32x8>;
+
+}
+
+/**
+ * xoshiro128+ run in F::width independent lanes (F = floatx4 / floatx8), one packet of
+ * uniform floats per call. The + scrambler leaves the lowest bits weak, which the float
+ * conversion drops; use pcg32 or philox where raw integers matter
+ * https://prng.di.unimi.it/xoshiro128plus.c
+ *
+ * Lanes are seeded from consecutive splitmix64 outputs. Give each thread its own seed
+ */
+template <typename F>
+class xoshiro128plus
+{
+public:
+	using lane_type = F;
+	using bits_type = detail::u32_lanes<F>;
+	static constexpr int width = F::width;
+
+	explicit xoshiro128plus(std::uint64_t seed = 0)
+	{
+		alignas(32) std::uint32_t s[4][width];
+		for (int lane = 0; lane < width; ++lane)
+			for (int w = 0; w < 4; w += 2)
+			{
+				std::uint64_t r = splitmix64(seed);
+				s[w][lane] = static_cast<std::uint32_t>(r);
+				s[w + 1][lane] = static_cast<std::uint32_t>(r >> 32);
+			}
+		for (int w = 0; w < 4; ++w)
+			_s[w] = bits_type::load(s[w]);
+	}
+
+	inline bits_type next_bits()
+	{
+		const bits_type result = _s[0] + _s[3];
+		const bits_type t = _s[1].template shl<9>();
+
+		_s[2] = _s[2] ^ _s[0];
+		_s[3] = _s[3] ^ _s[1];
+		_s[1] = _s[1] ^ _s[2];
+		_s[0] = _s[0] ^ _s[3];
+		_s[2] = _s[2] ^ t;
+		_s[3] = _s[3].template rotl<11>();
+
+		return result;
+	}
+
+	/** [0, 1) in every lane */
+	inline F next_float() { return next_bits().to_unit(); }
+
+	/** width raw outputs */
+	inline void next(std::uint32_t* out) { next_bits().store(out); }
+
+private:
+	bits_type	_s[4];
+};
+
+using xoshiro128plus_x4 = xoshiro128plus<math::floatx4>;
+using xoshiro128plus_x8 = xoshiro128plus<math::floatx8>;
+
+/**
+ * Philox4x32-10, counter based: the 4 outputs are a pure function of a 128 bit counter
+ * and a 64 bit key, so a sample can be addressed directly, e.g. counter = {sample,
+ * dimension, pixel x, pixel y}, with no state to store or advance per pixel
+ * https://www.thesalmons.org/john/random123/papers/random123sc11.pdf
+ */
+constexpr std::array<std::uint32_t, 4> philox4x32(std::array<std::uint32_t, 4> counter, std::array<std::uint32_t, 2> key)
+{
+	constexpr std::uint32_t m0 = 0xD2511F53u, m1 = 0xCD9E8D57u;
+	constexpr std::uint32_t w0 = 0x9E3779B9u, w1 = 0xBB67AE85u;
+
+	for (int round = 0; round < 10; ++round)
+	{
+		if (round)
+		{
+			key[0] += w0;
+			key[1] += w1;
+		}
+		const std::uint64_t p0 = std::uint64_t(m0) * counter[0];
+		const std::uint64_t p1 = std::uint64_t(m1) * counter[2];
+		counter = {
+			static_cast<std::uint32_t>(p1 >> 32) ^ counter[1] ^ key[0],
+			static_cast<std::uint32_t>(p1),
+			static_cast<std::uint32_t>(p0 >> 32) ^ counter[3] ^ key[1],
+			static_cast<std::uint32_t>(p0)
+		};
+	}
+	return counter;
+}
+
+/** Philox as a stream: a 64 bit counter per call, the stream in the upper counter half */
+class philox
+{
+public:
+	constexpr explicit philox(std::uint64_t key = 0, std::uint64_t stream = 0)
+		: _key{static_cast<std::uint32_t>(key), static_cast<std::uint32_t>(key >> 32)}
+		, _stream{static_cast<std::uint32_t>(stream), static_cast<std::uint32_t>(stream >> 32)}
+	{}
+
+	constexpr std::array<std::uint32_t, 4> next()
+	{
+		std::array<std::uint32_t, 4> r = philox4x32({static_cast<std::uint32_t>(_counter), static_cast<std::uint32_t>(_counter >> 32), _stream[0], _stream[1]}, _key);
+		++_counter;
+		return r;
+	}
+
+	/** F::width floats in [0, 1), floatx8 takes two blocks */
+	template <typename F = math::floatx4>
+	inline F next_float()
+	{
+		alignas(32) std::uint32_t bits[F::width];
+		for (int i = 0; i < F::width; i += 4)
+		{
+			std::array<std::uint32_t, 4> r = next();
+			for (int j = 0; j < 4; ++j)
+				bits[i + j] = r[j];
+		}
+		return detail::u32_lanes<F>::load(bits).to_unit();
+	}
+
+	constexpr void seek(std::uint64_t counter) { _counter = counter; }
+
+private:
+	std::array<std::uint32_t, 2>	_key;
+	std::array<std::uint32_t, 2>	_stream;
+	std::uint64_t					_counter = 0;
+};
+
+}
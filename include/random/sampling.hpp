@@ -0,0 +1,157 @@
+#pragma once
+
+#include <type_traits>
+
+#include "math/fast.hpp"
+#include "math/vec3.hpp"
+#include "math/vec3x.hpp"
+
+namespace cu::random {
+
+/**
+ * Warps of uniform [0, 1)^2 samples to the domains a path tracer integrates over
+ * Every function takes F = float, floatx4 or floatx8 (one sample per lane) and returns
+ * vec3 / vec3x4 / vec3x8. Directions are in the local frame with +z as the normal,
+ * to_world() moves them around a surface normal
+ *
+ * The maps are continuous and area preserving where possible, so stratified and
+ * low-discrepancy inputs (sequence.hpp) keep their structure after the warp
+ * https://pbr-book.org/4ed/Sampling_Algorithms/Sampling_Multidimensional_Functions
+ */
+template <typename F>
+using vec3_type = std::conditional_t<std::is_same_v<F, float>, math::vec3, math::vec3xN<F>>;
+
+inline constexpr float inv_pi = 0.31830988618379067154f;
+inline constexpr float inv_two_pi = 0.15915494309189533577f;
+inline constexpr float inv_four_pi = 0.07957747154594766788f;
+
+/**
+ * Shirley-Chiu concentric map of the square to the unit disk, x / y out
+ * https://www.psgraphics.net/papers/concentric.pdf
+ */
+template <math::fast::lane_type F>
+inline void sample_disk(const F& u0, const F& u1, F& x, F& y)
+{
+	namespace ops = math::fast::detail;
+	constexpr float quarter_pi = 0.78539816339744830962f;
+
+	const F a = u0 * F(2.0f) - F(1.0f);
+	const F b = u1 * F(2.0f) - F(1.0f);
+
+	// the centre (a = b = 0) takes the second branch with r = 0
+	const auto outer_ab = ops::abs(a) > ops::abs(b);
+	const F r = ops::select(outer_ab, a, b);
+	const F other = ops::select(outer_ab, b, a);
+	const F t = other / ops::select(r == F(0.0f), F(1.0f), r) * F(quarter_pi);
+	const F phi = ops::select(outer_ab, t, F(2.0f * quarter_pi) - t);
+
+	F s, c;
+	math::fast::sincos(phi, s, c);
+	x = r * c;
+	y = r * s;
+}
+
+inline math::vec2 sample_disk(const math::vec2& u)
+{
+	float x, y;
+	sample_disk(u.x, u.y, x, y);
+	return {x, y};
+}
+
+/** Malley's method, disk lifted to the hemisphere. pdf = cos(theta) / pi */
+template <math::fast::lane_type F>
+inline vec3_type<F> sample_cosine_hemisphere(const F& u0, const F& u1)
+{
+	namespace ops = math::fast::detail;
+
+	F x, y;
+	sample_disk(u0, u1, x, y);
+	F z = ops::sqrt(ops::max(F(0.0f), F(1.0f) - x * x - y * y));
+	return {x, y, z};
+}
+
+inline math::vec3 sample_cosine_hemisphere(const math::vec2& u) { return sample_cosine_hemisphere(u.x, u.y); }
+
+template <math::fast::lane_type F>
+inline F cosine_hemisphere_pdf(const F& cos_theta) { return cos_theta * F(inv_pi); }
+
+/** Archimedes' projection, z uniform in [-1, 1]. pdf = 1 / (4 pi) */
+template <math::fast::lane_type F>
+inline vec3_type<F> sample_uniform_sphere(const F& u0, const F& u1)
+{
+	namespace ops = math::fast::detail;
+	constexpr float two_pi = 6.28318530717958647692f;
+
+	F z = F(1.0f) - u0 * F(2.0f);
+	F r = ops::sqrt(ops::max(F(0.0f), F(1.0f) - z * z));
+	F s, c;
+	math::fast::sincos(u1 * F(two_pi), s, c);
+	return {r * c, r * s, z};
+}
+
+inline math::vec3 sample_uniform_sphere(const math::vec2& u) { return sample_uniform_sphere(u.x, u.y); }
+
+/** Upper half of sample_uniform_sphere. pdf = 1 / (2 pi) */
+template <math::fast::lane_type F>
+inline vec3_type<F> sample_uniform_hemisphere(const F& u0, const F& u1)
+{
+	namespace ops = math::fast::detail;
+	constexpr float two_pi = 6.28318530717958647692f;
+
+	F z = u0;
+	F r = ops::sqrt(ops::max(F(0.0f), F(1.0f) - z * z));
+	F s, c;
+	math::fast::sincos(u1 * F(two_pi), s, c);
+	return {r * c, r * s, z};
+}
+
+inline math::vec3 sample_uniform_hemisphere(const math::vec2& u) { return sample_uniform_hemisphere(u.x, u.y); }
+
+/**
+ * Uniform barycentrics (b0, b1, b2) over a triangle, p = b0 * p0 + b1 * p1 + b2 * p2
+ * Heitz's low-distortion map: no sqrt, and nearby samples stay nearby
+ * https://hal.science/hal-02073696v2/document
+ */
+template <math::fast::lane_type F>
+inline vec3_type<F> sample_triangle(const F& u0, const F& u1)
+{
+	namespace ops = math::fast::detail;
+
+	const auto upper = u1 > u0;
+	const F b0 = ops::select(upper, u0 * F(0.5f), u0 - u1 * F(0.5f));
+	const F b1 = ops::select(upper, u1 - u0 * F(0.5f), u1 * F(0.5f));
+	return {b0, b1, F(1.0f) - b0 - b1};
+}
+
+inline math::vec3 sample_triangle(const math::vec2& u) { return sample_triangle(u.x, u.y); }
+
+/**
+ * Local direction (z along n) to world space, n must be unit length
+ * Branchless orthonormal basis of Duff et al., continuous except at n.z = 0 -> -0
+ * https://jcgt.org/published/0006/01/01/paper.pdf
+ */
+template <math::fast::lane_type F>
+inline vec3_type<F> to_world(const vec3_type<F>& n, const vec3_type<F>& v)
+{
+	namespace ops = math::fast::detail;
+
+	const F sign = ops::xorsign(F(1.0f), n.z);
+	const F a = F(-1.0f) / (sign + n.z);
+	const F b = n.x * n.y * a;
+
+	// tangent (1 + sign x^2 a, sign b, -sign x), bitangent (b, sign + y^2 a, -y)
+	const F tx = F(1.0f) + sign * n.x * n.x * a;
+	const F ty = sign * b;
+	const F tz = -(sign * n.x);
+	const F by = sign + n.y * n.y * a;
+
+	return {
+		tx * v.x + b * v.y + n.x * v.z,
+		ty * v.x + by * v.y + n.y * v.z,
+		tz * v.x - n.y * v.y + n.z * v.z
+	};
+}
+
+inline math::vec3 to_world(const math::vec3& n, const math::vec3& v) { return to_world<float>(n, v); }
+
+}
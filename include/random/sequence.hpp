@@ -0,0 +1,181 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "math/vec.hpp"
+#include "random/engine.hpp"
+
+namespace cu::random {
+
+namespace detail {
+
+/**
+ * Generator matrices of the first sobol_dimensions Sobol dimensions, one column per
+ * index bit, built from the Joe-Kuo primitive polynomials and initial direction numbers
+ * https://web.maths.unsw.edu.au/~fkuo/sobol/joe-kuo-notes.pdf
+ */
+struct sobol_polynomial { int degree; std::uint32_t a; std::array<std::uint32_t, 3> m; };
+
+inline constexpr sobol_polynomial sobol_polynomials[] = {
+	{0, 0, {}},				// van der Corput
+	{1, 0, {1}},
+	{2, 1, {1, 3}},
+	{3, 1, {1, 3, 1}},
+};
+
+constexpr std::array<std::uint32_t, 32> sobol_matrix(const sobol_polynomial& p)
+{
+	std::array<std::uint32_t, 32> v{};
+	if (p.degree == 0)
+	{
+		for (int i = 0; i < 32; ++i)
+			v[i] = 1u << (31 - i);
+		return v;
+	}
+	for (int i = 0; i < 32; ++i)
+	{
+		if (i < p.degree)
+		{
+			v[i] = p.m[i] << (31 - i);
+			continue;
+		}
+		v[i] = v[i - p.degree] ^ (v[i - p.degree] >> p.degree);
+		for (int k = 1; k < p.degree; ++k)
+			v[i] ^= ((p.a >> (p.degree - 1 - k)) & 1u) * v[i - k];
+	}
+	return v;
+}
+
+/** XOR of the matrix columns for every value of each index byte, 4 lookups per point */
+using sobol_table = std::array<std::array<std::uint32_t, 256>, 4>;
+
+constexpr sobol_table sobol_bytes(const sobol_polynomial& p)
+{
+	const std::array<std::uint32_t, 32> v = sobol_matrix(p);
+	sobol_table t{};
+	for (int byte = 0; byte < 4; ++byte)
+		for (std::uint32_t b = 0; b < 256; ++b)
+			for (int bit = 0; bit < 8; ++bit)
+				t[byte][b] ^= ((b >> bit) & 1u) * v[8 * byte + bit];
+	return t;
+}
+
+inline constexpr std::array<sobol_table, 4> sobol_tables = {
+	sobol_bytes(sobol_polynomials[0]),
+	sobol_bytes(sobol_polynomials[1]),
+	sobol_bytes(sobol_polynomials[2]),
+	sobol_bytes(sobol_polynomials[3]),
+};
+
+constexpr std::uint32_t reverse_bits(std::uint32_t x)
+{
+	x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+	x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+	x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+	x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+	return (x >> 16) | (x << 16);
+}
+
+/** Hash that only propagates bits upwards, an Owen scramble of the reversed value */
+constexpr std::uint32_t laine_karras_permutation(std::uint32_t x, std::uint32_t seed)
+{
+	x += seed;
+	x ^= x * 0x6c50b47cu;
+	x ^= x * 0xb82f1e52u;
+	x ^= x * 0xc7afe638u;
+	x ^= x * 0x8d22f6e6u;
+	return x;
+}
+
+}
+
+/**
+ * 32 bit integer hash (lowbias32), full avalanche, for seeds from pixel coordinates
+ * https://nullprogram.com/blog/2018/07/31/
+ */
+constexpr std::uint32_t hash(std::uint32_t x)
+{
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+	return x;
+}
+
+constexpr std::uint32_t hash_combine(std::uint32_t seed, std::uint32_t v)
+{
+	return seed ^ (hash(v) + 0x9e3779b9u + (seed << 6) + (seed >> 2));
+}
+
+/** Decorrelating seed per pixel (and frame, for progressive rendering) */
+constexpr std::uint32_t pixel_seed(std::uint32_t x, std::uint32_t y, std::uint32_t frame = 0)
+{
+	return hash_combine(hash_combine(hash(x), y), frame);
+}
+
+/**
+ * Sobol (0, 2)-sequence points with hash based Owen scrambling: the point set of
+ * each seed is a fresh randomization that keeps the stratification in every
+ * elementary interval, so neighbouring pixels (pixel_seed) decorrelate into blue-ish
+ * noise instead of repeating one pattern
+ * https://jcgt.org/published/0009/04/01/paper.pdf
+ *
+ * Only dimensions 0 and 1 together form a (0, 2)-sequence. Dimensions 0 .. 3 share
+ * one shuffled index; past that, or for more 2D pairs, pad: each group gets its own
+ * seed, hash_combine(seed, group), which also shuffles its index independently
+ */
+inline constexpr int sobol_dimensions = 4;
+
+constexpr std::uint32_t sobol(std::uint32_t index, int dimension)
+{
+	const detail::sobol_table& t = detail::sobol_tables[dimension];
+	return t[0][index & 0xff] ^ t[1][(index >> 8) & 0xff] ^ t[2][(index >> 16) & 0xff] ^ t[3][index >> 24];
+}
+
+constexpr std::uint32_t nested_uniform_scramble(std::uint32_t x, std::uint32_t seed)
+{
+	return detail::reverse_bits(detail::laine_karras_permutation(detail::reverse_bits(x), seed));
+}
+
+/** Sample index of a pixel in [0, 1), dimension < sobol_dimensions */
+constexpr float sobol_owen(std::uint32_t index, int dimension, std::uint32_t seed)
+{
+	index = nested_uniform_scramble(index, seed);
+	return to_unit_float(nested_uniform_scramble(sobol(index, dimension), hash_combine(seed, static_cast<std::uint32_t>(dimension))));
+}
+
+/**
+ * One stratified 2D point per sampling decision, e.g. the lens (pair 0) and the
+ * light (pair 1): dimensions 0 and 1 padded with a seed per pair
+ */
+constexpr math::vec2 sobol_owen_2d(std::uint32_t index, std::uint32_t pair, std::uint32_t seed)
+{
+	seed = hash_combine(seed, pair);
+	index = nested_uniform_scramble(index, seed);
+	return {
+		to_unit_float(nested_uniform_scramble(sobol(index, 0), hash_combine(seed, 0u))),
+		to_unit_float(nested_uniform_scramble(sobol(index, 1), hash_combine(seed, 1u)))
+	};
+}
+
+/**
+ * Roberts' R2 sequence, additive recurrence on the plastic number with a per-pixel
+ * toroidal shift (Cranley-Patterson rotation). Nearly as uniform as Sobol for
+ * 2D, a couple of adds per point, and any number of samples
+ * https://extremelearning.com.au/unreasonable-effectiveness-of-quasirandom-sequences/
+ *
+ * Kept in 32 bit fixed point, so it does not lose precision as the index grows
+ */
+constexpr math::vec2 r2(std::uint32_t index, std::uint32_t seed = 0)
+{
+	constexpr std::uint32_t alpha0 = 0xC13FA9A9u;	// 2^32 / g
+	constexpr std::uint32_t alpha1 = 0x91E10DA6u;	// 2^32 / g^2
+
+	const std::uint32_t shift0 = seed ? hash(seed) : 0u;
+	const std::uint32_t shift1 = seed ? hash(seed ^ 0x5bd1e995u) : 0u;
+	return {to_unit_float(shift0 + index * alpha0), to_unit_float(shift1 + index * alpha1)};
+}
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "math.hpp"
+#include "return.hpp"
+
+namespace cu::scene {
+
+/**
+ * Triangle mesh as one contiguous array per attribute, ready for BVH::build(positions,
+ * indices) or a GPU upload
+ *
+ * Indices follow the OBJ model, one index stream per attribute: triangle t uses
+ * positions[indices[3t + k]], and texcoords[texcoord_indices[3t + k]] /
+ * normals[normal_indices[3t + k]] when the file has them. A corner without a texcoord
+ * or normal in a file that has some elsewhere gets no_index
+ */
+struct Mesh
+{
+	static constexpr std::uint32_t no_index = ~0u;
+
+	std::vector<math::vec3>		positions;
+	std::vector<math::vec3>		normals;
+	std::vector<math::vec2>		texcoords;
+	std::vector<std::uint32_t>	indices;
+	std::vector<std::uint32_t>	texcoord_indices;	// empty, or one per entry of indices
+	std::vector<std::uint32_t>	normal_indices;		// empty, or one per entry of indices
+
+	std::size_t	triangle_count() const { return indices.size() / 3; }
+	void		clear();
+};
+
+struct ObjOptions
+{
+	bool		parallel = true;		// parse chunks on every hardware thread
+	std::size_t	chunk_size = 1 << 20;	// bytes per chunk, cut at the next newline
+};
+
+/**
+ * Wavefront OBJ geometry: v, vt, vn and f (polygons are fanned into triangles,
+ * negative indices are relative); other statements (o, g, s, usemtl, ...) are skipped
+ * https://paulbourke.net/dataformats/obj/
+ *
+ * The text is cut into newline-aligned chunks, parsed in parallel with std::from_chars
+ * into per-chunk arrays, then copied in order into the mesh. Errors name the line
+ */
+Result	parse_obj(std::string_view text, Mesh& out, const ObjOptions& options = {});
+
+/** parse_obj() on the memory-mapped file */
+Result	load_obj(const std::string& path, Mesh& out, const ObjOptions& options = {});
+
+}
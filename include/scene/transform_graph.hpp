@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "math.hpp"
+#include "return.hpp"
+
+namespace cu::scene {
+
+/**
+ * Transform hierarchy with local TRS per node and cached world matrices
+ *
+ * Nodes live in flat SoA arrays sorted by depth, every level sorted by parent, so a
+ * parent always comes before its children and the descendants of a node form one
+ * contiguous range per level. update() only walks the ranges below the nodes changed
+ * since the last call, levels wider than a few thousand nodes are split across threads.
+ *
+ * Matrices follow mat4::mul_vec like transform_points(), BVH::refit() and frustum: row
+ * vectors, translation in m[3], world = S * R * T * parent world. transpose() gives the
+ * translate() / quat::toMatrix() layout (column vectors, translation in m[i][3])
+ *
+ * Node handles stay valid until the node is removed, removed handles are reused.
+ * Structural changes (add, remove, set_parent) re-sort the arrays on the next update,
+ * which is O(node count) index work but only the changed nodes get new matrices
+ */
+class TransformGraph
+{
+public:
+	using node = std::uint32_t;
+	static constexpr node invalid = ~0u;
+
+	TransformGraph() = default;
+
+	/** Returns invalid when parent is neither invalid (new root) nor a live node */
+	node	add(node parent = invalid, const math::vec3& translation = math::vec3(0.0f), const math::quat& rotation = math::quat(), const math::vec3& scale = math::vec3(1.0f));
+
+	/** Removes n and its whole subtree */
+	Result	remove(node n);
+
+	/** parent = invalid makes n a root, moving a node under its own subtree is rejected */
+	Result	set_parent(node n, node parent);
+
+	void	set_translation(node n, const math::vec3& translation);
+	void	set_rotation(node n, const math::quat& rotation);
+	void	set_scale(node n, const math::vec3& scale);
+	void	set_local(node n, const math::vec3& translation, const math::quat& rotation, const math::vec3& scale);
+
+	/** Recomputes the world matrices below every node changed since the last call, returns how many were recomputed */
+	std::size_t	update(bool parallel = true);
+
+	inline bool	contains(node n) const { return n < _slot_of.size() && _slot_of[n] != invalid; }
+	inline std::size_t	size() const { return _slot_of.size() - _free.size(); }
+
+	inline node	parent(node n) const { std::uint32_t p = _parent[_slot_of[n]]; return p == invalid ? invalid : _id[p]; }
+	inline const math::vec3&	translation(node n) const { return _translation[_slot_of[n]]; }
+	inline const math::quat&	rotation(node n) const { return _rotation[_slot_of[n]]; }
+	inline const math::vec3&	scale(node n) const { return _scale[_slot_of[n]]; }
+
+	/** As of the last update(), identity for nodes added since */
+	inline const math::mat4&	world(node n) const { return _world[_slot_of[n]]; }
+
+	/** Every world matrix in storage order, for uploads; node_at() maps an index back to its handle */
+	inline std::span<const math::mat4>	worlds() const { return _world; }
+	inline node	node_at(std::size_t index) const { return _id[index]; }
+
+private:
+	void	mark_dirty(std::uint32_t slot);
+	void	rebuild_layout();
+	void	update_range(std::uint32_t first, std::uint32_t last);
+
+	// per slot, in level order once the layout is up to date
+	std::vector<math::vec3>		_translation;
+	std::vector<math::quat>		_rotation;
+	std::vector<math::vec3>		_scale;
+	std::vector<math::mat4>		_world;
+	std::vector<std::uint32_t>	_parent;		// slot of the parent, invalid for roots
+	std::vector<node>			_id;			// handle of the node in this slot, invalid once removed
+	std::vector<std::uint8_t>	_dirty;
+
+	// children of slot s are the slots [_child_begin[s], _child_begin[s + 1])
+	std::vector<std::uint32_t>	_child_begin;
+	std::vector<std::uint32_t>	_level_begin;
+
+	std::vector<std::uint32_t>	_slot_of;		// handle -> slot
+	std::vector<node>			_free;
+	std::vector<node>			_dirty_nodes;	// handles, slots move when the layout is rebuilt
+	bool						_layout_dirty = false;
+};
+
+}
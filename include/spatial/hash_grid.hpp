@@ -0,0 +1,152 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "math.hpp"
+
+namespace cu::spatial {
+
+/**
+ * Uniform grid over unbounded space, cells hashed into a table of about 2x the point
+ * count and stored as one sorted array (no per-cell allocation)
+ * https://matthias-research.github.io/pages/publications/tetraederCollision.pdf
+ *
+ * Points are copied in bucket order, so the points of a cell are contiguous and a query
+ * streams through a few short ranges. Cell size should be about the query radius: a
+ * query visits the 2^3 .. 3^3 cells its sphere overlaps
+ *
+ * build() again after points move, the grid holds no reference to the input
+ */
+class HashGrid
+{
+public:
+	HashGrid() = default;
+
+	void	build(std::span<const math::vec3> points, float cell_size, bool parallel = true);
+
+	/**
+	 * Every point with distance(p, center) <= radius
+	 * fn(std::uint32_t index, float distance_sq), index into the points given to build()
+	 */
+	template <typename Fn>
+	void	query(const math::vec3& center, float radius, Fn&& fn) const;
+
+	/** Appends the indices of the points within radius of center, returns how many */
+	std::size_t	query(const math::vec3& center, float radius, std::vector<std::uint32_t>& out) const;
+
+	inline std::size_t	size() const { return _points.size(); }
+	inline bool	empty() const { return _points.empty(); }
+	inline float	cell_size() const { return _cell_size; }
+
+private:
+	struct cell { std::int32_t x, y, z; };
+
+	/**
+	 * Clamped to the floats that convert to int32 (the cast is undefined past them),
+	 * NaN goes to the lowest cell; far away points share the edge cells
+	 */
+	static inline std::int32_t	coordinate(float v)
+	{
+		constexpr float lowest = -2147483648.0f;	// -2^31
+		constexpr float highest = 2147483520.0f;	// largest float below 2^31
+		float c = std::floor(v);
+		if (!(c >= lowest))
+			return std::numeric_limits<std::int32_t>::min();
+		if (c > highest)
+			return static_cast<std::int32_t>(highest);
+		return static_cast<std::int32_t>(c);
+	}
+
+	inline cell	cell_of(const math::vec3& p) const
+	{
+		return {coordinate(p.x * _inv_cell_size), coordinate(p.y * _inv_cell_size), coordinate(p.z * _inv_cell_size)};
+	}
+
+	/** Teschner et al. primes, the table size is a power of two; cell coordinates as int64 for the query loops */
+	inline std::uint32_t	bucket(std::int64_t x, std::int64_t y, std::int64_t z) const
+	{
+		return ((static_cast<std::uint32_t>(x) * 73856093u) ^ (static_cast<std::uint32_t>(y) * 19349663u) ^ (static_cast<std::uint32_t>(z) * 83492791u)) & _mask;
+	}
+
+	inline void	scan(std::uint32_t b, const math::vec3& center, float radius_sq, auto& fn) const
+	{
+		for (std::uint32_t i = _bucket_begin[b]; i < _bucket_begin[b + 1]; ++i)
+		{
+			float d2 = (_points[i] - center).length_sq();
+			if (d2 <= radius_sq)
+				fn(_indices[i], d2);
+		}
+	}
+
+	std::vector<std::uint32_t>	_bucket_begin;	// points of bucket b are [_bucket_begin[b], _bucket_begin[b + 1])
+	std::vector<math::vec3>		_points;		// in bucket order
+	std::vector<std::uint32_t>	_indices;		// bucket order -> build() index
+	float						_cell_size = 1.0f;
+	float						_inv_cell_size = 1.0f;
+	std::uint32_t				_mask = 0;
+};
+
+/**
+ * Distinct cells can hash to the same bucket, every bucket is scanned once:
+ * small queries dedupe in a fixed array, larger ones sort the bucket list
+ */
+template <typename Fn>
+void HashGrid::query(const math::vec3& center, float radius, Fn&& fn) const
+{
+	if (_points.empty() || !(radius >= 0.0f))
+		return;
+
+	const cell lo = cell_of(center - math::vec3(radius));
+	const cell hi = cell_of(center + math::vec3(radius));
+	const float radius_sq = radius * radius;
+
+	// in 64 bits: a side spans up to 2^32 cells, the product is only formed while it stays below the table size
+	const std::uint64_t nx = std::uint64_t(std::int64_t(hi.x) - lo.x + 1);
+	const std::uint64_t ny = std::uint64_t(std::int64_t(hi.y) - lo.y + 1);
+	const std::uint64_t nz = std::uint64_t(std::int64_t(hi.z) - lo.z + 1);
+
+	if (nx > _mask || ny > _mask || nz > _mask || nx * ny > _mask || nx * ny * nz > _mask)
+	{
+		// the query covers more cells than there are buckets
+		for (std::uint32_t b = 0; b <= _mask; ++b)
+			scan(b, center, radius_sq, fn);
+		return;
+	}
+
+	const std::size_t cells = static_cast<std::size_t>(nx * ny * nz);
+	constexpr std::size_t small = 64;
+	if (cells <= small)
+	{
+		std::uint32_t seen[small];
+		std::size_t count = 0;
+		for (std::int64_t z = lo.z; z <= hi.z; ++z)
+			for (std::int64_t y = lo.y; y <= hi.y; ++y)
+				for (std::int64_t x = lo.x; x <= hi.x; ++x)
+				{
+					std::uint32_t b = bucket(x, y, z);
+					if (std::find(seen, seen + count, b) != seen + count)
+						continue;
+					seen[count++] = b;
+					scan(b, center, radius_sq, fn);
+				}
+		return;
+	}
+
+	std::vector<std::uint32_t> buckets;
+	buckets.reserve(cells);
+	for (std::int64_t z = lo.z; z <= hi.z; ++z)
+		for (std::int64_t y = lo.y; y <= hi.y; ++y)
+			for (std::int64_t x = lo.x; x <= hi.x; ++x)
+				buckets.push_back(bucket(x, y, z));
+	std::sort(buckets.begin(), buckets.end());
+	buckets.erase(std::unique(buckets.begin(), buckets.end()), buckets.end());
+	for (std::uint32_t b : buckets)
+		scan(b, center, radius_sq, fn);
+}
+
+}
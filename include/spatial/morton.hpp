@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "math.hpp"
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+namespace cu::spatial {
+
+namespace detail {
+
+inline constexpr std::uint32_t morton30_mask = 0x09249249u;
+inline constexpr std::uint64_t morton63_mask = 0x1249249249249249ull;
+
+constexpr std::uint32_t expand_bits10(std::uint32_t v)
+{
+	v &= 0x3ffu;
+	v = (v | (v << 16)) & 0x030000ffu;
+	v = (v | (v << 8)) & 0x0300f00fu;
+	v = (v | (v << 4)) & 0x030c30c3u;
+	v = (v | (v << 2)) & 0x09249249u;
+	return v;
+}
+
+constexpr std::uint32_t compact_bits10(std::uint32_t v)
+{
+	v &= 0x09249249u;
+	v = (v ^ (v >> 2)) & 0x030c30c3u;
+	v = (v ^ (v >> 4)) & 0x0300f00fu;
+	v = (v ^ (v >> 8)) & 0x030000ffu;
+	v = (v ^ (v >> 16)) & 0x000003ffu;
+	return v;
+}
+
+constexpr std::uint64_t expand_bits21(std::uint64_t v)
+{
+	v &= 0x1fffffull;
+	v = (v | (v << 32)) & 0x001f00000000ffffull;
+	v = (v | (v << 16)) & 0x001f0000ff0000ffull;
+	v = (v | (v << 8)) & 0x100f00f00f00f00full;
+	v = (v | (v << 4)) & 0x10c30c30c30c30c3ull;
+	v = (v | (v << 2)) & 0x1249249249249249ull;
+	return v;
+}
+
+constexpr std::uint64_t compact_bits21(std::uint64_t v)
+{
+	v &= 0x1249249249249249ull;
+	v = (v ^ (v >> 2)) & 0x10c30c30c30c30c3ull;
+	v = (v ^ (v >> 4)) & 0x100f00f00f00f00full;
+	v = (v ^ (v >> 8)) & 0x001f0000ff0000ffull;
+	v = (v ^ (v >> 16)) & 0x001f00000000ffffull;
+	v = (v ^ (v >> 32)) & 0x00000000001fffffull;
+	return v;
+}
+
+}
+
+/**
+ * 3D Morton (Z-order) codes: the bits of x, y, z interleaved as ... z1 y1 x1 z0 y0 x0
+ * 30-bit keys take 10 bits per axis, 63-bit keys 21 bits per axis
+ *
+ * pdep / pext when compiled for BMI2, "magic bits" shifts and masks otherwise
+ * https://www.forceflow.be/2013/10/07/morton-encodingdecoding-through-bit-interleaving-implementations/
+ *
+ * x, y, z must be < 1024, higher bits are dropped
+ */
+constexpr std::uint32_t morton30(std::uint32_t x, std::uint32_t y, std::uint32_t z)
+{
+#if defined(__BMI2__)
+	if (!std::is_constant_evaluated())
+		return _pdep_u32(x, detail::morton30_mask) | _pdep_u32(y, detail::morton30_mask << 1) | _pdep_u32(z, detail::morton30_mask << 2);
+#endif
+	return detail::expand_bits10(x) | (detail::expand_bits10(y) << 1) | (detail::expand_bits10(z) << 2);
+}
+
+/** x, y, z must be < 2^21, higher bits are dropped */
+constexpr std::uint64_t morton63(std::uint32_t x, std::uint32_t y, std::uint32_t z)
+{
+#if defined(__BMI2__) && defined(__x86_64__)
+	if (!std::is_constant_evaluated())
+		return _pdep_u64(x, detail::morton63_mask) | _pdep_u64(y, detail::morton63_mask << 1) | _pdep_u64(z, detail::morton63_mask << 2);
+#endif
+	return detail::expand_bits21(x) | (detail::expand_bits21(y) << 1) | (detail::expand_bits21(z) << 2);
+}
+
+constexpr void morton30_decode(std::uint32_t key, std::uint32_t& x, std::uint32_t& y, std::uint32_t& z)
+{
+#if defined(__BMI2__)
+	if (!std::is_constant_evaluated())
+	{
+		x = _pext_u32(key, detail::morton30_mask);
+		y = _pext_u32(key, detail::morton30_mask << 1);
+		z = _pext_u32(key, detail::morton30_mask << 2);
+		return;
+	}
+#endif
+	x = detail::compact_bits10(key);
+	y = detail::compact_bits10(key >> 1);
+	z = detail::compact_bits10(key >> 2);
+}
+
+constexpr void morton63_decode(std::uint64_t key, std::uint32_t& x, std::uint32_t& y, std::uint32_t& z)
+{
+#if defined(__BMI2__) && defined(__x86_64__)
+	if (!std::is_constant_evaluated())
+	{
+		x = static_cast<std::uint32_t>(_pext_u64(key, detail::morton63_mask));
+		y = static_cast<std::uint32_t>(_pext_u64(key, detail::morton63_mask << 1));
+		z = static_cast<std::uint32_t>(_pext_u64(key, detail::morton63_mask << 2));
+		return;
+	}
+#endif
+	x = static_cast<std::uint32_t>(detail::compact_bits21(key));
+	y = static_cast<std::uint32_t>(detail::compact_bits21(key >> 1));
+	z = static_cast<std::uint32_t>(detail::compact_bits21(key >> 2));
+}
+
+/**
+ * Morton keys of points quantized on a 2^10 (Key = uint32_t) or 2^21 (Key = uint64_t)
+ * grid over bounds, points outside bounds are clamped to its faces
+ * Baseline builds use pdep at runtime on CPUs where it is fast (cpu.hpp)
+ * keys must have the size of points
+ */
+template <typename Key>
+void morton_keys(std::span<const math::vec3> points, const math::aabb& bounds, std::span<Key> keys, bool parallel = true);
+
+/**
+ * Permutation that sorts points along the Z-order curve over their bounds:
+ * points[order[0]], points[order[1]], ... Equal keys keep their input order
+ */
+template <typename Key = std::uint32_t>
+std::vector<std::uint32_t> morton_order(std::span<const math::vec3> points, bool parallel = true);
+
+template <typename Key = std::uint32_t>
+std::vector<std::uint32_t> morton_order(std::span<const math::vec3> points, const math::aabb& bounds, bool parallel = true);
+
+}
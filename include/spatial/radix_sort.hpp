@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+namespace cu::spatial {
+
+/**
+ * Stable LSD radix sort of keys, values are permuted alongside (usually indices)
+ * 8-bit digits, digits where every key is the same are skipped, so 30-bit Morton keys
+ * take at most 4 passes and clustered keys fewer
+ *
+ * With parallel, every pass counts and scatters per chunk on all hardware threads:
+ * chunk c of digit d is written after chunks < c of the same digit, so the result is
+ * the same as the serial sort
+ * https://gpuopen.com/download/publications/Introduction_to_GPU_Radix_Sort.pdf
+ *
+ * Key is std::uint32_t or std::uint64_t, keys and values must have the same size
+ */
+template <typename Key>
+void radix_sort(std::span<Key> keys, std::span<std::uint32_t> values, bool parallel = true);
+
+}
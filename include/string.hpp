@@ -0,0 +1,6 @@
+#pragma once
+
+#include "string/interner.hpp"
+#include "string/numeric.hpp"
+#include "string/split.hpp"
+#include "string/tokenizer.hpp"
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+namespace cu::string
+{
+
+/**
+ * 32 bit handle of an interned string: two symbols of one Interner are equal exactly
+ * when their strings are, so comparing and hashing them is comparing integers
+ * Ids are dense from 0 in interning order, usable as indices into side tables
+ */
+struct Symbol
+{
+	static constexpr std::uint32_t	none = ~0u;
+
+	std::uint32_t	id = none;
+
+	constexpr explicit operator bool() const { return id != none; }
+
+	friend constexpr bool operator==(Symbol, Symbol) = default;
+	friend constexpr auto operator<=>(Symbol, Symbol) = default;
+};
+
+/**
+ * Pool of unique strings, each mapped to a Symbol
+ *
+ *   static const Symbol diffuse = Interner::global().intern("diffuse");
+ *   if (interner.intern(token) == diffuse)
+ *
+ * The strings are copied once into append-only blocks, so name() views stay valid
+ * (and NUL-terminated) for the life of the interner. Lookups are lock-free: the hash
+ * table is split into shards by hash, a miss takes the mutex of one shard to insert.
+ * Tables grow by copy, the old ones are kept until destruction for readers still in
+ * them. Up to 2^32 - 1 strings
+ */
+class Interner
+{
+public:
+	Interner();
+	~Interner();
+
+	Interner(const Interner&) = delete;
+	Interner& operator=(const Interner&) = delete;
+
+	/** Symbol of str, added on first sight */
+	Symbol				intern(std::string_view str);
+
+	/** Symbol of str if it was interned, an empty Symbol otherwise; never allocates */
+	Symbol				find(std::string_view str) const;
+
+	/** The string of a symbol of this interner */
+	std::string_view	name(Symbol symbol) const
+	{
+		std::uint64_t	n = std::uint64_t(symbol.id) + first_page_size;
+		int				page = std::bit_width(n) - 1 - first_page_bits;
+		return _pages[page].load(std::memory_order_acquire)[n - (first_page_size << page)];
+	}
+
+	/** Strings interned so far */
+	std::size_t			size() const { return _count.load(std::memory_order_relaxed); }
+
+	/** Process-wide interner, for names shared across modules */
+	static Interner&	global();
+
+private:
+	struct Shard;
+
+	// id -> name in pages of 1024, 2048, 4096 ... entries, allocated on demand and never moved
+	static constexpr int			first_page_bits = 10;
+	static constexpr std::uint64_t	first_page_size = std::uint64_t(1) << first_page_bits;
+	static constexpr int			max_pages = 33 - first_page_bits;
+
+	Symbol	insert(Shard& shard, std::uint64_t hash, std::string_view str);
+	void	set_name(std::uint32_t id, std::string_view str);
+
+	Shard*									_shards;
+	std::atomic<std::string_view*>			_pages[max_pages] = {};
+	std::atomic<std::uint32_t>				_count{0};
+};
+
+}
+
+template <>
+struct std::hash<cu::string::Symbol>
+{
+	std::size_t	operator()(cu::string::Symbol s) const noexcept { return std::hash<std::uint32_t>()(s.id); }
+};
@@ -0,0 +1,266 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+#include "math/mat4.hpp"
+#include "math/quat.hpp"
+#include "math/vec.hpp"
+
+/**
+ * Text form of the math types: numbers separated by ", " in parentheses, matrices
+ * row by row, quaternions in member order (w, x, y, z)
+ *
+ *   (1, 0.5, -3)
+ *   ((1, 0, 0, 0), (0, 1, 0, 0), (0, 0, 1, 0), (0, 0, 0, 1))
+ *
+ * Parsing is looser: the numbers may be separated by commas and/or whitespace and
+ * the brackets, ( ) or [ ], are optional, so "1 0.5 -3" and "[1,0.5,-3]" read the same
+ *
+ * Both directions go through std::from_chars / std::to_chars: no locale, no
+ * allocation, and floats print as the shortest text that reads back to the same value
+ */
+
+namespace cu::math
+{
+
+namespace detail {
+
+template <typename T>
+inline constexpr std::size_t scalar_chars = std::is_floating_point_v<T>
+	? 8 + std::numeric_limits<T>::max_digits10		// sign, point, exponent
+	: 2 + std::numeric_limits<T>::digits10;
+
+inline bool is_space(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+/** Skips what may precede a number: whitespace, commas, brackets (closing ones too when inside) */
+inline const char* skip_separators(const char* p, const char* last, bool closing)
+{
+	for (; p < last; ++p)
+	{
+		char c = *p;
+		if (!(is_space(c) || c == ',' || c == '(' || c == '[' || (closing && (c == ')' || c == ']'))))
+			break;
+	}
+	return p;
+}
+
+/** Closing brackets right after the last number, with the whitespace between them */
+inline const char* skip_closing(const char* p, const char* last)
+{
+	for (const char* q = p; q < last; ++q)
+	{
+		if (*q == ')' || *q == ']')
+			p = q + 1;
+		else if (!is_space(*q))
+			break;
+	}
+	return p;
+}
+
+template <typename T>
+inline std::from_chars_result read_numbers(const char* first, const char* last, T* values, int count)
+{
+	const char* p = first;
+	for (int i = 0; i < count; ++i)
+	{
+		p = skip_separators(p, last, i > 0);
+		if (p < last && *p == '+')
+			++p;
+		auto r = std::from_chars(p, last, values[i]);
+		if (r.ec != std::errc())
+			return {first, r.ec};
+		p = r.ptr;
+	}
+	return {skip_closing(p, last), std::errc()};
+}
+
+/** "(a, b, ...)" */
+template <typename T>
+inline std::to_chars_result write_tuple(char* first, char* last, const T* values, int count)
+{
+	char* p = first;
+	if (p == last)
+		return {last, std::errc::value_too_large};
+	*p++ = '(';
+	for (int i = 0; i < count; ++i)
+	{
+		if (i > 0)
+		{
+			if (last - p < 2)
+				return {last, std::errc::value_too_large};
+			*p++ = ',';
+			*p++ = ' ';
+		}
+		auto r = std::to_chars(p, last, values[i]);
+		if (r.ec != std::errc())
+			return r;
+		p = r.ptr;
+	}
+	if (p == last)
+		return {last, std::errc::value_too_large};
+	*p++ = ')';
+	return {p, std::errc()};
+}
+
+}
+
+/**
+ * from_chars / to_chars overloads next to the types so that they are found by
+ * argument-dependent lookup, like the std ones for arithmetic types: generic code
+ * and the logger's own formatter call to_chars(first, last, v) unqualified (where
+ * the logger goes through std::format, pass to_string(v) instead)
+ */
+template <typename T, int N>
+	requires (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>)
+inline std::from_chars_result from_chars(const char* first, const char* last, vec<T, N>& v)
+{
+	T values[N];
+	auto r = detail::read_numbers(first, last, values, N);
+	if (r.ec == std::errc())
+		for (int i = 0; i < N; ++i)
+			v[i] = values[i];
+	return r;
+}
+
+template <typename T, int R, int C>
+	requires (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>)
+inline std::from_chars_result from_chars(const char* first, const char* last, mat<T, R, C>& m)
+{
+	T values[R * C];
+	auto r = detail::read_numbers(first, last, values, R * C);
+	if (r.ec == std::errc())
+		for (int i = 0; i < R; ++i)
+			for (int j = 0; j < C; ++j)
+				m.m[i][j] = values[i * C + j];
+	return r;
+}
+
+inline std::from_chars_result from_chars(const char* first, const char* last, quat& q)
+{
+	float values[4];
+	auto r = detail::read_numbers(first, last, values, 4);
+	if (r.ec == std::errc())
+		q = quat(values[0], values[1], values[2], values[3]);
+	return r;
+}
+
+template <typename T, int N>
+	requires (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>)
+inline std::to_chars_result to_chars(char* first, char* last, const vec<T, N>& v)
+{
+	T values[N];
+	for (int i = 0; i < N; ++i)
+		values[i] = v[i];
+	return detail::write_tuple(first, last, values, N);
+}
+
+template <typename T, int R, int C>
+	requires (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>)
+inline std::to_chars_result to_chars(char* first, char* last, const mat<T, R, C>& m)
+{
+	char* p = first;
+	if (p == last)
+		return {last, std::errc::value_too_large};
+	*p++ = '(';
+	for (int i = 0; i < R; ++i)
+	{
+		if (i > 0)
+		{
+			if (last - p < 2)
+				return {last, std::errc::value_too_large};
+			*p++ = ',';
+			*p++ = ' ';
+		}
+		auto r = detail::write_tuple(p, last, m.m[i], C);
+		if (r.ec != std::errc())
+			return r;
+		p = r.ptr;
+	}
+	if (p == last)
+		return {last, std::errc::value_too_large};
+	*p++ = ')';
+	return {p, std::errc()};
+}
+
+inline std::to_chars_result to_chars(char* first, char* last, const quat& q)
+{
+	const float values[4] = {q.w, q.x, q.y, q.z};
+	return detail::write_tuple(first, last, values, 4);
+}
+
+}
+
+namespace cu::string
+{
+
+using math::from_chars;
+using math::to_chars;
+
+/** Buffer size that always holds to_chars(v) for a T */
+template <typename T>
+inline constexpr std::size_t max_chars = math::detail::scalar_chars<T>;
+
+template <typename T, int N>
+inline constexpr std::size_t max_chars<math::vec<T, N>> = 2 + N * (2 + math::detail::scalar_chars<T>);
+
+template <typename T, int R, int C>
+inline constexpr std::size_t max_chars<math::mat<T, R, C>> = 2 + R * (2 + max_chars<math::vec<T, C>>);
+
+template <>
+inline constexpr std::size_t max_chars<math::quat> = max_chars<math::vec4>;
+
+/**
+ * The whole of str as a T (arithmetic or math type), surrounding whitespace allowed;
+ * nullopt when it is not one, or has anything after it
+ *
+ *   std::optional<vec3> p = cu::string::parse<vec3>("1.5 2 -3");
+ */
+template <typename T>
+std::optional<T> parse(std::string_view str)
+{
+	const char* p = str.data();
+	const char* last = p + str.size();
+	T value{};
+
+	std::from_chars_result r;
+	if constexpr (std::is_arithmetic_v<T>)
+	{
+		while (p < last && math::detail::is_space(*p))
+			++p;
+		if (p < last && *p == '+')
+			++p;
+		r = std::from_chars(p, last, value);
+	}
+	else
+		r = math::from_chars(p, last, value);
+	if (r.ec != std::errc())
+		return std::nullopt;
+
+	for (p = r.ptr; p < last && math::detail::is_space(*p); ++p)
+		;
+	if (p != last)
+		return std::nullopt;
+	return value;
+}
+
+/** to_chars(v) as a string, when an allocation does not matter */
+template <typename T>
+std::string to_string(const T& v)
+{
+	char buffer[max_chars<T>];
+	std::to_chars_result r;
+	if constexpr (std::is_arithmetic_v<T>)
+		r = std::to_chars(buffer, buffer + sizeof(buffer), v);
+	else
+		r = math::to_chars(buffer, buffer + sizeof(buffer), v);
+	return std::string(buffer, r.ptr);
+}
+
+}
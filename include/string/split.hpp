@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <memory_resource>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cu::string
+{
+
+/**
+ * Tokens of str between occurrences of sep, empty tokens skipped, as a lazy forward
+ * range of std::string_view into str: nothing is copied or allocated, each step is
+ * a memchr for the next separator
+ *
+ *   for (std::string_view token : cu::string::split_view(line, ' '))
+ *
+ * The tokens point into str, which must outlive them (not the view)
+ */
+class split_view : public std::ranges::view_interface<split_view>
+{
+public:
+	class iterator
+	{
+	public:
+		using value_type = std::string_view;
+		using difference_type = std::ptrdiff_t;
+		using iterator_concept = std::forward_iterator_tag;
+
+		iterator() = default;
+		iterator(std::string_view str, char sep) : _rest(str), _sep(sep) { next(); }
+
+		std::string_view	operator*() const { return _token; }
+
+		iterator	&operator++() { next(); return *this; }
+		iterator	operator++(int) { iterator it = *this; next(); return it; }
+
+		bool	operator==(const iterator& other) const { return _token.data() == other._token.data(); }
+		bool	operator==(std::default_sentinel_t) const { return _token.data() == nullptr; }
+
+	private:
+		void	next()
+		{
+			while (!_rest.empty() && _rest.front() == _sep)
+				_rest.remove_prefix(1);
+			if (_rest.empty())
+			{
+				_token = {};
+				return;
+			}
+
+			const void *found = std::memchr(_rest.data(), _sep, _rest.size());
+			std::size_t length = found ? static_cast<std::size_t>(static_cast<const char *>(found) - _rest.data()) : _rest.size();
+			_token = _rest.substr(0, length);
+			_rest.remove_prefix(length);
+		}
+
+		std::string_view	_rest;
+		std::string_view	_token;
+		char				_sep = 0;
+	};
+
+	split_view() = default;
+	split_view(std::string_view str, char sep) : _str(str), _sep(sep) {}
+
+	iterator				begin() const { return iterator(_str, _sep); }
+	std::default_sentinel_t	end() const { return std::default_sentinel; }
+
+private:
+	std::string_view	_str;
+	char				_sep = 0;
+};
+
+/**
+ * Same tokens into a buffer the caller keeps between calls: out is cleared, not
+ * shrunk, so once it has grown splitting allocates nothing. Returns the token count
+ */
+std::size_t split(std::string_view str, char sep, std::vector<std::string_view>& out);
+
+std::size_t split(std::string_view str, char sep, std::pmr::vector<std::string_view>& out);
+
+/** Same tokens as owned strings */
+std::vector<std::string> split(const std::string& str, char sep);
+
+/**
+ * Same tokens as strings, the vector and the strings allocated from resource: with a
+ * cu::memory::Arena or the frame allocator, splitting does not touch the global heap
+ */
+std::pmr::vector<std::pmr::string> split(std::string_view str, char sep, std::pmr::memory_resource* resource);
+
+}
+
+template <>
+inline constexpr bool std::ranges::enable_borrowed_range<cu::string::split_view> = true;
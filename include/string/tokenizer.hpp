@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace cu::string
+{
+
+/**
+ * Set of delimiter bytes. Scans compare 16 / 32 bytes at once against each byte of
+ * the set (SSE2, AVX2 when the CPU has it, see cpu.hpp), so small sets are the fast
+ * case: up to max_simd bytes, larger sets fall back to a table lookup per byte
+ */
+class Delimiters
+{
+public:
+	static constexpr std::size_t	max_simd = 8;
+
+	constexpr Delimiters(std::string_view chars)
+	{
+		for (char c : chars)
+		{
+			if (_table[static_cast<unsigned char>(c)])
+				continue;
+			_table[static_cast<unsigned char>(c)] = true;
+			if (_count < max_simd)
+				_chars[_count] = c;
+			++_count;
+		}
+	}
+
+	constexpr bool			contains(char c) const { return _table[static_cast<unsigned char>(c)]; }
+	constexpr std::size_t	size() const { return _count; }
+	constexpr const char	*chars() const { return _chars; }	// the first min(size(), max_simd)
+
+private:
+	bool		_table[256] = {};
+	char		_chars[max_simd] = {};
+	std::size_t	_count = 0;
+};
+
+inline constexpr Delimiters	whitespace{" \t\r\n\f\v"};
+
+/** Byte range [begin, end) of a token in the scanned string */
+struct Token
+{
+	std::size_t	begin;
+	std::size_t	end;
+
+	std::size_t			size() const { return end - begin; }
+	std::string_view	in(std::string_view str) const { return str.substr(begin, end - begin); }
+};
+
+/** Position of the first delimiter at or after pos, std::string_view::npos if none */
+std::size_t	find_first_of(std::string_view str, const Delimiters& delimiters, std::size_t pos = 0);
+
+/**
+ * Maximal runs of non-delimiter bytes, as offsets into str (empty tokens never appear,
+ * like split()). out is cleared, not shrunk: a buffer kept across calls stops
+ * allocating. Returns the token count
+ *
+ * The delimiter positions of each 64 KiB of input are found first, as one bit per byte,
+ * then token boundaries are the 0 -> 1 and 1 -> 0 transitions of that bitmap
+ */
+std::size_t	tokenize(std::string_view str, const Delimiters& delimiters, std::vector<Token>& out);
+
+/** str without the delimiters at either end */
+std::string_view	trim(std::string_view str, const Delimiters& delimiters = whitespace);
+
+/**
+ * Lines of str, without their "\n" or "\r\n" (a lone '\r' is kept); empty lines are
+ * kept so indices are line numbers - 1, a final newline does not start another line
+ * trim_whitespace also strips whitespace from both ends of each line
+ */
+std::size_t	split_lines(std::string_view str, std::vector<Token>& out, bool trim_whitespace = false);
+
+}
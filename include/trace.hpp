@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "return.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+# if defined(_MSC_VER)
+#  include <intrin.h>
+# else
+#  include <x86intrin.h>
+# endif
+# define CU_TRACE_TSC 1
+#else
+# define CU_TRACE_TSC 0
+#endif
+
+/** 0 compiles every TRACE_* macro to nothing, the arguments are not evaluated */
+#ifndef CU_TRACE
+# define CU_TRACE 1
+#endif
+
+/**
+ * Instrumentation spans and counters, written as Chrome trace events
+ * https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU
+ * Open the file in https://ui.perfetto.dev or chrome://tracing
+ *
+ * A span records its begin and end ticks (rdtsc on x86, steady_clock elsewhere) into a
+ * buffer owned by the calling thread, no lock and no syscall; ticks become microseconds
+ * only when the events are written. In async logging mode the logger's writer thread
+ * streams the buffers to the file every flush interval, otherwise they grow in memory
+ * until stop(). When no capture runs a span costs one relaxed load
+ *
+ * Names must outlive the capture, string literals in practice: only the pointer is stored
+ */
+namespace cu::trace {
+
+	namespace detail {
+
+		inline std::atomic<bool>	active{false};
+
+		inline std::uint64_t	ticks()
+		{
+		#if CU_TRACE_TSC
+			return __rdtsc();
+		#else
+			return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+		#endif
+		}
+
+		void	complete(const char *name, std::uint64_t begin, std::uint64_t end);
+		void	counter(const char *name, double value, std::uint64_t time);
+		void	instant(const char *name, std::uint64_t time);
+
+	}
+
+	struct Options
+	{
+		std::string		path;					// the JSON file, overwritten
+		std::size_t		block_events = 4096;	// events per buffer block, each thread allocates a block at a time
+	};
+
+	/** Opens the file and starts recording on every thread; fails if a capture already runs */
+	Result	start(const Options &options);
+
+	/** Writes what is left and closes the file; also runs at exit */
+	Result	stop();
+
+	inline bool	enabled() { return detail::active.load(std::memory_order_relaxed); }
+
+	/** Label of the calling thread in the viewer */
+	void	thread_name(std::string name);
+
+	/** A span from construction to destruction, see TRACE_SCOPE */
+	class Scope
+	{
+	public:
+		explicit Scope(const char *name)
+		{
+			if (enabled())
+			{
+				_name = name;
+				_begin = detail::ticks();
+			}
+		}
+
+		~Scope()
+		{
+			if (_name)
+				detail::complete(_name, _begin, detail::ticks());
+		}
+
+		Scope(const Scope &) = delete;
+		Scope &operator=(const Scope &) = delete;
+
+	private:
+		const char		*_name = nullptr;
+		std::uint64_t	_begin = 0;
+	};
+
+	/** A value over time (queue depth, rays in flight), one track per name */
+	inline void	counter(const char *name, double value)
+	{
+		if (enabled())
+			detail::counter(name, value, detail::ticks());
+	}
+
+	/** A point in time on the calling thread's track */
+	inline void	instant(const char *name)
+	{
+		if (enabled())
+			detail::instant(name, detail::ticks());
+	}
+
+}
+
+#define CU_TRACE_CONCAT_(a, b) a##b
+#define CU_TRACE_CONCAT(a, b) CU_TRACE_CONCAT_(a, b)
+
+#if CU_TRACE
+# define TRACE_SCOPE(name)			::cu::trace::Scope CU_TRACE_CONCAT(cu_trace_scope_, __LINE__)(name)
+# define TRACE_COUNTER(name, value)	do { if (::cu::trace::enabled()) ::cu::trace::counter(name, value); } while (0)
+# define TRACE_INSTANT(name)		::cu::trace::instant(name)
+#else
+# define TRACE_SCOPE(name)			((void)0)
+# define TRACE_COUNTER(name, value)	((void)0)
+# define TRACE_INSTANT(name)		((void)0)
+#endif
@@ -0,0 +1,500 @@
+#include "accel/bvh.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+
+namespace cu::accel {
+
+using math::aabb;
+using math::vec3;
+
+namespace {
+
+constexpr std::uint32_t invalid_child = ~0u;
+constexpr std::uint32_t parallel_min_prims = 4096;
+constexpr std::size_t parallel_min_chunk = 16384;
+constexpr int max_bins = 64;
+
+struct Bin
+{
+	aabb			bounds;
+	std::uint32_t	count = 0;
+};
+
+/**
+ * Top-down binned SAH, subtrees larger than parallel_min_prims are built on their
+ * own thread until every hardware thread has work
+ * Node pairs are allocated from an atomic counter, children always get a higher index
+ * than their parent so refit can run as a single reverse sweep
+ */
+struct Builder
+{
+	std::span<const aabb>		boxes;
+	std::vector<vec3>			centroids;
+	std::span<std::uint32_t>	prims;
+	std::span<BVHNode>			nodes;
+	std::atomic<std::uint32_t>	next_node{1};
+	BuildOptions				options;
+	int							fork_depth = 0;
+
+	void build(std::uint32_t index, std::uint32_t first, std::uint32_t count, int depth)
+	{
+		BVHNode& node = nodes[index];
+
+		aabb bounds, cbounds;
+		for (std::uint32_t i = first; i < first + count; ++i)
+		{
+			bounds.expand(boxes[prims[i]]);
+			cbounds.expand(centroids[prims[i]]);
+		}
+		node.min = bounds.min;
+		node.max = bounds.max;
+
+		std::uint32_t mid = split(bounds, cbounds, first, count, depth);
+		if (mid == first)
+		{
+			node.left_first = first;
+			node.count = count;
+			return;
+		}
+
+		std::uint32_t left = next_node.fetch_add(2, std::memory_order_relaxed);
+		node.left_first = left;
+		node.count = 0;
+
+		auto build_left = [=, this] { build(left, first, mid - first, depth + 1); };
+		auto build_right = [=, this] { build(left + 1, mid, first + count - mid, depth + 1); };
+
+		if (options.parallel && depth < fork_depth && count >= parallel_min_prims)
+			cu::parallel::fork_join(build_left, build_right);
+		else
+		{
+			build_left();
+			build_right();
+		}
+	}
+
+	/** Partitions the range and returns the split point, first when the node stays a leaf */
+	std::uint32_t split(const aabb& bounds, const aabb& cbounds, std::uint32_t first, std::uint32_t count, int depth)
+	{
+		if (count <= 1)
+			return first;
+
+		auto begin = prims.begin() + first;
+		auto end = begin + count;
+
+		// past half the depth budget, object median splits bound the remaining depth to log2(n)
+		if (depth >= BVH::max_depth / 2)
+			return median_split(cbounds, first, count);
+
+		const int nbins = std::clamp(options.bins, 2, max_bins);
+		Bin bins[3][max_bins];
+		float right_area[max_bins];
+
+		// one pass over the primitives fills the bins of all three axes
+		float lo[3], scale[3];
+		for (int k = 0; k < 3; ++k)
+		{
+			lo[k] = cbounds.min[k];
+			float extent = cbounds.max[k] - lo[k];
+			scale[k] = extent > 0.0f ? nbins / extent : 0.0f;
+		}
+
+		for (std::uint32_t i = first; i < first + count; ++i)
+		{
+			std::uint32_t p = prims[i];
+			const vec3& c = centroids[p];
+			const aabb& box = boxes[p];
+			int bx = std::min(nbins - 1, static_cast<int>((c.x - lo[0]) * scale[0]));
+			int by = std::min(nbins - 1, static_cast<int>((c.y - lo[1]) * scale[1]));
+			int bz = std::min(nbins - 1, static_cast<int>((c.z - lo[2]) * scale[2]));
+			bins[0][bx].bounds.expand(box);
+			bins[0][bx].count++;
+			bins[1][by].bounds.expand(box);
+			bins[1][by].count++;
+			bins[2][bz].bounds.expand(box);
+			bins[2][bz].count++;
+		}
+
+		float best_cost = std::numeric_limits<float>::infinity();
+		int best_axis = -1;
+		int best_bin = 0;
+
+		for (int k = 0; k < 3; ++k)
+		{
+			if (scale[k] == 0.0f)
+				continue;
+
+			aabb acc;
+			for (int b = nbins - 1; b > 0; --b)
+			{
+				acc.expand(bins[k][b].bounds);
+				right_area[b] = acc.surface_area();
+			}
+
+			acc = aabb();
+			std::uint32_t left_count = 0;
+			for (int b = 1; b < nbins; ++b)
+			{
+				acc.expand(bins[k][b - 1].bounds);
+				left_count += bins[k][b - 1].count;
+				float cost = acc.surface_area() * left_count + right_area[b] * (count - left_count);
+				if (cost < best_cost)
+				{
+					best_cost = cost;
+					best_axis = k;
+					best_bin = b;
+				}
+			}
+		}
+
+		bool too_big = count > static_cast<std::uint32_t>(options.max_leaf_size);
+
+		if (best_axis < 0)
+			return too_big ? median_split(cbounds, first, count) : first;
+
+		float area = bounds.surface_area();
+		float split_cost = options.traversal_cost + (area > 0.0f ? best_cost / area : 0.0f);
+		if (!too_big && split_cost >= static_cast<float>(count))
+			return first;
+
+		auto mid = std::partition(begin, end, [&](std::uint32_t p) {
+			return std::min(nbins - 1, static_cast<int>((centroids[p][best_axis] - lo[best_axis]) * scale[best_axis])) < best_bin;
+		});
+
+		if (mid == begin || mid == end)
+			return median_split(cbounds, first, count);
+		return static_cast<std::uint32_t>(mid - prims.begin());
+	}
+
+	std::uint32_t median_split(const aabb& cbounds, std::uint32_t first, std::uint32_t count)
+	{
+		int k = cbounds.largest_axis();
+		auto begin = prims.begin() + first;
+		auto mid = begin + count / 2;
+		std::nth_element(begin, mid, begin + count, [&](std::uint32_t a, std::uint32_t b) {
+			return centroids[a][k] < centroids[b][k];
+		});
+		return first + count / 2;
+	}
+};
+
+inline aabb triangle_bounds(const vec3& a, const vec3& b, const vec3& c)
+{
+	aabb r;
+	return r.expand(a).expand(b).expand(c);
+}
+
+}
+
+void BVH::build_nodes(std::span<const aabb> boxes, const BuildOptions& options)
+{
+	std::uint32_t n = static_cast<std::uint32_t>(boxes.size());
+
+	_prims.resize(n);
+	for (std::uint32_t i = 0; i < n; ++i)
+		_prims[i] = i;
+
+	_nodes.assign(std::max<std::size_t>(2 * static_cast<std::size_t>(n), 1), BVHNode{});
+	_nodes4.clear();
+	_nodes4_source.clear();
+
+	Builder builder;
+	builder.boxes = boxes;
+	builder.prims = _prims;
+	builder.nodes = _nodes;
+	builder.options = options;
+	// about two subtrees per hardware thread
+	unsigned threads = cu::parallel::thread_count();
+	while (threads > 1 && (1u << builder.fork_depth) < 2 * threads)
+		builder.fork_depth++;
+
+	builder.centroids.resize(n);
+	cu::parallel::for_chunks(n, options.parallel ? parallel_min_chunk : n, [&](std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i)
+			builder.centroids[i] = boxes[i].center();
+	});
+
+	if (n == 0)
+	{
+		_nodes.clear();
+		return;
+	}
+
+	builder.build(0, 0, n, 0);
+	_nodes.resize(builder.next_node.load());
+
+	if (options.bvh4)
+		collapse();
+}
+
+Result BVH::build(std::span<const aabb> boxes, const BuildOptions& options)
+{
+	_indices.clear();
+	_v0.clear();
+	_v1.clear();
+	_v2.clear();
+
+	build_nodes(boxes, options);
+	return Result::ok();
+}
+
+Result BVH::build(std::span<const vec3> vertices, std::span<const std::uint32_t> indices, const BuildOptions& options)
+{
+	if (indices.size() % 3 != 0)
+		return Result::error("BVH: index count " + std::to_string(indices.size()) + " is not a multiple of 3");
+
+	for (std::uint32_t i : indices)
+		if (i >= vertices.size())
+			return Result::error("BVH: index " + std::to_string(i) + " out of range (" + std::to_string(vertices.size()) + " vertices)");
+
+	std::size_t n = indices.size() / 3;
+	std::vector<aabb> boxes(n);
+	cu::parallel::for_chunks(n, options.parallel ? parallel_min_chunk : n, [&](std::size_t begin, std::size_t end) {
+		for (std::size_t t = begin; t < end; ++t)
+			boxes[t] = triangle_bounds(vertices[indices[3 * t]], vertices[indices[3 * t + 1]], vertices[indices[3 * t + 2]]);
+	});
+
+	build_nodes(boxes, options);
+
+	_indices.assign(indices.begin(), indices.end());
+	gather_triangles(vertices);
+	return Result::ok();
+}
+
+void BVH::gather_triangles(std::span<const vec3> vertices)
+{
+	std::size_t n = _prims.size();
+	_v0.resize(n);
+	_v1.resize(n);
+	_v2.resize(n);
+
+	cu::parallel::for_chunks(n, parallel_min_chunk, [&](std::size_t begin, std::size_t end) {
+		for (std::size_t k = begin; k < end; ++k)
+		{
+			const std::uint32_t* tri = &_indices[3 * static_cast<std::size_t>(_prims[k])];
+			_v0[k] = vertices[tri[0]];
+			_v1[k] = vertices[tri[1]];
+			_v2[k] = vertices[tri[2]];
+		}
+	});
+}
+
+template <typename BoxOf>
+void BVH::refit_nodes(BoxOf&& box_of)
+{
+	for (std::size_t i = _nodes.size(); i-- > 0;)
+	{
+		BVHNode& n = _nodes[i];
+		aabb b;
+		if (n.is_leaf())
+		{
+			for (std::uint32_t p = n.left_first; p < n.left_first + n.count; ++p)
+				b.expand(box_of(p));
+		}
+		else
+		{
+			const BVHNode& l = _nodes[n.left_first];
+			const BVHNode& r = _nodes[n.left_first + 1];
+			b = aabb(l.min, l.max);
+			b.expand(aabb(r.min, r.max));
+		}
+		n.min = b.min;
+		n.max = b.max;
+	}
+
+	// the 4-wide nodes keep their shape, each child slot takes the box of the BVH2 node it came from
+	for (std::size_t i = 0; i < _nodes4.size(); ++i)
+	{
+		BVH4Node& n = _nodes4[i];
+		for (int k = 0; k < 4; ++k)
+		{
+			std::uint32_t source = _nodes4_source[4 * i + k];
+			if (source == invalid_child)
+				continue;
+			const BVHNode& c = _nodes[source];
+			n.min[0][k] = c.min.x; n.min[1][k] = c.min.y; n.min[2][k] = c.min.z;
+			n.max[0][k] = c.max.x; n.max[1][k] = c.max.y; n.max[2][k] = c.max.z;
+		}
+	}
+}
+
+Result BVH::refit(std::span<const vec3> vertices)
+{
+	if (_indices.empty() && !_prims.empty())
+		return Result::error("BVH: refit with vertices on a tree built from boxes");
+
+	for (std::uint32_t i : _indices)
+		if (i >= vertices.size())
+			return Result::error("BVH: refit with " + std::to_string(vertices.size()) + " vertices, index " + std::to_string(i) + " out of range");
+
+	gather_triangles(vertices);
+	refit_nodes([this](std::uint32_t k) { return triangle_bounds(_v0[k], _v1[k], _v2[k]); });
+	return Result::ok();
+}
+
+Result BVH::refit(const math::mat4& transform, std::span<const vec3> vertices)
+{
+	std::vector<vec3> moved(vertices.size());
+	math::transform_points(transform, vertices, moved, true);
+	return refit(moved);
+}
+
+Result BVH::refit(std::span<const aabb> boxes)
+{
+	if (boxes.size() != _prims.size())
+		return Result::error("BVH: refit with " + std::to_string(boxes.size()) + " boxes, built with " + std::to_string(_prims.size()));
+
+	refit_nodes([&](std::uint32_t k) { return boxes[_prims[k]]; });
+	return Result::ok();
+}
+
+/**
+ * Each 4-wide node pulls up the largest interior grandchildren of a BVH2 node
+ * until it has 4 children
+ * https://www.embree.org/papers/2008-BVH4-Dammertz.pdf
+ */
+void BVH::collapse()
+{
+	_nodes4.clear();
+	_nodes4_source.clear();
+	if (_nodes.empty())
+		return;
+	_nodes4.reserve(_nodes.size() / 2 + 1);
+	_nodes4_source.reserve(4 * (_nodes.size() / 2 + 1));
+
+	auto make = [this](auto& self, std::uint32_t index) -> std::uint32_t {
+		std::uint32_t out = static_cast<std::uint32_t>(_nodes4.size());
+		_nodes4.emplace_back();
+		_nodes4_source.resize(_nodes4_source.size() + 4, invalid_child);
+
+		std::uint32_t children[4];
+		int n = 0;
+		const BVHNode& node = _nodes[index];
+		if (node.is_leaf())
+			children[n++] = index;
+		else
+		{
+			children[n++] = node.left_first;
+			children[n++] = node.left_first + 1;
+		}
+
+		while (n < 4)
+		{
+			int best = -1;
+			float best_area = -1.0f;
+			for (int i = 0; i < n; ++i)
+			{
+				const BVHNode& c = _nodes[children[i]];
+				float area = aabb(c.min, c.max).surface_area();
+				if (!c.is_leaf() && area > best_area)
+				{
+					best = i;
+					best_area = area;
+				}
+			}
+			if (best < 0)
+				break;
+			std::uint32_t first = _nodes[children[best]].left_first;
+			children[best] = first;
+			children[n++] = first + 1;
+		}
+
+		BVH4Node packed;
+		for (int i = 0; i < 4; ++i)
+		{
+			aabb b = i < n ? aabb(_nodes[children[i]].min, _nodes[children[i]].max) : aabb();
+			packed.min[0][i] = b.min.x; packed.min[1][i] = b.min.y; packed.min[2][i] = b.min.z;
+			packed.max[0][i] = b.max.x; packed.max[1][i] = b.max.y; packed.max[2][i] = b.max.z;
+			packed.child[i] = invalid_child;
+			packed.count[i] = 0;
+
+			if (i >= n)
+				continue;
+			_nodes4_source[4 * out + i] = children[i];
+			const BVHNode& c = _nodes[children[i]];
+			if (c.is_leaf())
+			{
+				packed.child[i] = c.left_first;
+				packed.count[i] = c.count;
+			}
+			else
+				packed.child[i] = self(self, children[i]);
+		}
+		_nodes4[out] = packed;
+		return out;
+	};
+
+	make(make, 0);
+}
+
+template <bool AnyHit>
+bool BVH::intersect_triangles(const math::ray& r, Hit& hit) const
+{
+	if (_v0.empty())
+		return false;
+
+	math::watertight_ray wr(r);
+	bool found = false;
+
+	traverse_leaves(r, [&](std::uint32_t first, std::uint32_t count, math::ray& ray) {
+		wr.tmax = ray.tmax;
+
+		if (count == 1)
+		{
+			math::tri_hit h;
+			if (!math::ray_triangle(wr, _v0[first], _v1[first], _v2[first], h))
+				return false;
+			found = true;
+			hit = {h.t, h.u, h.v, _prims[first]};
+			ray.tmax = h.t;
+			return AnyHit;
+		}
+
+		for (std::uint32_t k = first; k < first + count; k += 4)
+		{
+			std::size_t lanes = std::min<std::size_t>(4, first + count - k);
+			math::triangle4 tri = math::triangle4::load(
+				std::span(_v0).subspan(k, lanes), std::span(_v1).subspan(k, lanes), std::span(_v2).subspan(k, lanes));
+
+			math::floatx4 t, u, v;
+			int mask = math::ray_triangle(wr, tri, t, u, v).bits() & ((1 << lanes) - 1);
+			if (!mask)
+				continue;
+
+			alignas(16) float ts[4], us[4], vs[4];
+			t.store(ts);
+			u.store(us);
+			v.store(vs);
+			for (int i = 0; i < 4; ++i)
+			{
+				if (!(mask & (1 << i)) || ts[i] > wr.tmax)
+					continue;
+				found = true;
+				hit = {ts[i], us[i], vs[i], _prims[k + i]};
+				wr.tmax = ts[i];
+				if constexpr (AnyHit)
+					return true;
+			}
+		}
+		ray.tmax = wr.tmax;
+		return false;
+	});
+
+	return found;
+}
+
+bool BVH::intersect(const math::ray& r, Hit& hit) const
+{
+	return intersect_triangles<false>(r, hit);
+}
+
+bool BVH::occluded(const math::ray& r) const
+{
+	Hit hit;
+	return intersect_triangles<true>(r, hit);
+}
+
+}
@@ -1,46 +1,112 @@
 #include "logger.hpp"
+#include "logger/internal.hpp"
 #include "colors.hpp"
 
-#include <iomanip>
-#include <iostream>
+#include <ctime>
 
 namespace cu::logger {
 
-	static std::string timestamp()
+	static std::string_view levelToString(Level lvl, bool color)
 	{
-		std::time_t now = std::time(NULL);
-		std::tm *tm = std::localtime(&now);
-
-		char buffer[100];
-
-	#if LOG_DATE && LOG_TIME
-		strftime(buffer, 99, "%Y/%m/%d %H:%M:%S", tm);
-	#elif LOG_DATE
-		strftime(buffer, 99, "%Y/%m/%d", tm);
-	#elif LOG_TIME
-		strftime(buffer, 99, "%H:%M:%S", tm);
-	#else
-		buffer[0] = '\0';
-	#endif
-
-		return buffer;
+		if (color)
+		{
+			switch (lvl)
+			{
+				case TRACE: return COLOR_BRIGHT_BLACK "[trace]" COLOR_RESET;
+				case DEBUG: return COLOR_CYAN   "[debug]" COLOR_RESET;
+				case INFO:  return COLOR_GREEN  "[info]"  COLOR_RESET;
+				case WARN:  return COLOR_YELLOW "[warn]"  COLOR_RESET;
+				case ERROR: return COLOR_RED    "[error]" COLOR_RESET;
+			}
+		}
+		else
+		{
+			switch (lvl)
+			{
+				case TRACE: return "[trace]";
+				case DEBUG: return "[debug]";
+				case INFO:  return "[info]";
+				case WARN:  return "[warn]";
+				case ERROR: return "[error]";
+			}
+		}
+		return "[unknown]";
+	}
+
+	std::int64_t detail::now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
 	}
 
-	static std::string levelToString(Level lvl)
+	void detail::LineFormatter::prefix(std::string &out, Level lvl, std::int64_t time, bool color)
 	{
-		switch (lvl)
+		std::int64_t second = time / 1000000000;
+		if (second != _second)
 		{
-			case INFO:  return COLOR_GREEN  "[info]"  COLOR_RESET;
-			case WARN:  return COLOR_YELLOW "[warn]"  COLOR_RESET;
-			case ERROR: return COLOR_RED    "[error]" COLOR_RESET;
+			_second = second;
+			std::time_t t = static_cast<std::time_t>(second);
+			std::tm tm;
+		#if defined(_WIN32)
+			localtime_s(&tm, &t);
+		#else
+			localtime_r(&t, &tm);
+		#endif
+
+		#if LOG_DATE && LOG_TIME
+			_stamp_size = strftime(_stamp, sizeof(_stamp), "%Y/%m/%d %H:%M:%S", &tm);
+		#elif LOG_DATE
+			_stamp_size = strftime(_stamp, sizeof(_stamp), "%Y/%m/%d", &tm);
+		#elif LOG_TIME
+			_stamp_size = strftime(_stamp, sizeof(_stamp), "%H:%M:%S", &tm);
+		#else
+			_stamp_size = 0;
+		#endif
 		}
-		return "[unknown]";
+
+		out.append(_stamp, _stamp_size);
+		out += ' ';
+		out += levelToString(lvl, color);
+		out += ' ';
+	}
+
+	/** Set once the thread's emitter is destroyed, later lines (static destructors) use a local one */
+	static thread_local bool emitter_destroyed = false;
+
+	struct ThreadEmitter
+	{
+		detail::Emitter	emitter;
+
+		~ThreadEmitter() { emitter_destroyed = true; }
+	};
+
+	static void emit(detail::Emitter &emitter, Level lvl, std::int64_t time, std::string_view msg)
+	{
+		emitter.begin();
+		emitter.line(lvl, time, [&](std::string &out) { out += msg; });
+		emitter.end();
+	}
+
+	void detail::write(Level lvl, std::int64_t time, std::string_view msg)
+	{
+		if (detail::enqueue(lvl, time, msg))
+			return;
+
+		// one formatted line and one flush per sink, under the lock the writer thread also takes
+		if (emitter_destroyed)
+		{
+			detail::Emitter emitter;
+			emit(emitter, lvl, time, msg);
+			return;
+		}
+		thread_local ThreadEmitter local;
+		emit(local.emitter, lvl, time, msg);
 	}
 
 	void log(Level lvl, const std::string &msg)
 	{
-		std::ostream &out = (lvl == ERROR) ? std::cerr : std::cout;
-		out << timestamp() << " " << levelToString(lvl) << " " << msg << std::endl;
+		if (!enabled(lvl))
+			return;
+		detail::write(lvl, detail::now(), msg);
 	}
 
-}
\ No newline at end of file
+}
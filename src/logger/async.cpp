@@ -0,0 +1,371 @@
+#include "logger.hpp"
+#include "logger/internal.hpp"
+#include "logger/ring.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cu::logger {
+
+	namespace {
+
+		using detail::Ring;
+
+		struct State
+		{
+			std::mutex				mutex;
+			std::condition_variable	wake;		// writer: flush request, stop, or a blocked producer
+			std::condition_variable	flushed;	// flush() callers
+
+			std::vector<std::shared_ptr<Ring>>	rings;
+			std::vector<void (*)()>				tasks;
+			AsyncOptions	options;
+			std::thread		writer;
+			std::uint64_t	flush_requested = 0;
+			std::uint64_t	flush_done = 0;
+			std::uint64_t	sessions = 0;
+			std::uint64_t	dropped = 0;		// from rings already removed
+			bool			stopping = false;
+			bool			exit_hook = false;
+
+			std::atomic<std::uint64_t>	session{0};		// 0 while logging is synchronous
+			std::atomic<bool>			room_wanted{false};
+		};
+
+		// never destroyed, threads may still log from static destructors
+		State &state()
+		{
+			static State *s = new State;
+			return *s;
+		}
+
+		/**
+		 * Set once the thread's Producer is destroyed: logging from a later thread_local or,
+		 * on the main thread, static destructor writes synchronously. Trivially destructible,
+		 * so it stays readable until the thread ends
+		 */
+		thread_local bool producer_destroyed = false;
+
+		/** The calling thread's ring, re-created when async mode restarts */
+		struct Producer
+		{
+			std::shared_ptr<Ring>	ring;
+			std::uint64_t			session = 0;
+			Overflow				overflow = BLOCK;
+
+			~Producer()
+			{
+				if (ring)
+					ring->retired.store(true, std::memory_order_release);
+				producer_destroyed = true;
+			}
+		};
+
+		thread_local Producer producer;
+
+		bool attach(State &s, Producer &p, std::uint64_t session)
+		{
+			std::lock_guard lock(s.mutex);
+			if (s.session.load(std::memory_order_relaxed) != session)
+				return false;
+			if (p.ring)
+				p.ring->retired.store(true, std::memory_order_release);
+			p.ring = std::make_shared<Ring>(s.options.buffer_size);
+			p.session = session;
+			p.overflow = s.options.overflow;
+			s.rings.push_back(p.ring);
+			return true;
+		}
+
+		struct Pending
+		{
+			std::int64_t		time;
+			Level				level;
+			Ring::Kind			kind;
+			std::uint32_t		size;
+			const std::byte		*payload;
+		};
+
+		/**
+		 * One pass over every ring: collect what is published, merge by timestamp,
+		 * format each line once per color mode, hand it to the sinks, then give the space back
+		 */
+		class Writer
+		{
+		public:
+			void drain(const std::vector<std::shared_ptr<Ring>> &rings, bool report_drops)
+			{
+				_batch.clear();
+				_ends.resize(rings.size());
+				for (std::size_t i = 0; i < rings.size(); ++i)
+					_ends[i] = rings[i]->peek([&](const Ring::Header &h, const std::byte *payload) {
+						_batch.push_back({h.time, static_cast<Level>(h.level), static_cast<Ring::Kind>(h.kind), h.size, payload});
+					});
+
+				// each ring is already in order, a stable merge keeps it that way
+				std::stable_sort(_batch.begin(), _batch.end(), [](const Pending &a, const Pending &b) { return a.time < b.time; });
+
+				_emitter.begin();
+				for (const Pending &p : _batch)
+					_emitter.line(p.level, p.time, [&](std::string &out) {
+						if (p.kind == Ring::deferred)
+							format_deferred(out, p.payload);
+						else
+							out.append(reinterpret_cast<const char *>(p.payload), p.size);
+					});
+
+				if (report_drops)
+				{
+					std::uint64_t lost = 0;
+					for (const auto &r : rings)
+					{
+						std::uint64_t d = r->dropped.load(std::memory_order_relaxed);
+						lost += d - r->reported;
+						r->reported = d;
+					}
+					if (lost)
+						_emitter.line(WARN, detail::now(), [&](std::string &out) { out += std::to_string(lost) + " log messages dropped, buffer full"; });
+				}
+				_emitter.end();
+
+				for (std::size_t i = 0; i < rings.size(); ++i)
+					rings[i]->release(_ends[i]);
+			}
+
+		private:
+			/** The format string was checked at compile time, only a throwing formatter gets here */
+			static void format_deferred(std::string &out, const std::byte *payload)
+			{
+				detail::format_fn fn;
+				std::memcpy(&fn, payload, sizeof(fn));
+				try
+				{
+					fn(out, payload + sizeof(fn));
+				}
+				catch (const std::exception &e)
+				{
+					out += "<format error: ";
+					out += e.what();
+					out += '>';
+				}
+			}
+
+			detail::Emitter				_emitter;
+			std::vector<Pending>		_batch;
+			std::vector<std::uint64_t>	_ends;
+		};
+
+		void writer_main(State &s)
+		{
+			Writer writer;
+			std::vector<std::shared_ptr<Ring>> rings;
+			std::vector<void (*)()> tasks;
+
+			std::unique_lock lock(s.mutex);
+			for (;;)
+			{
+				s.wake.wait_for(lock, s.options.flush_interval, [&] {
+					return s.stopping || s.flush_requested != s.flush_done || s.room_wanted.load(std::memory_order_relaxed);
+				});
+				s.room_wanted.store(false, std::memory_order_relaxed);
+
+				const std::uint64_t	flush_target = s.flush_requested;
+				const bool			stopping = s.stopping;
+				const bool			report = s.options.overflow == DROP_AND_COUNT;
+				rings = s.rings;
+				tasks = s.tasks;
+				lock.unlock();
+
+				writer.drain(rings, report);
+				for (auto task : tasks)
+					task();
+
+				lock.lock();
+				std::erase_if(s.rings, [&](const std::shared_ptr<Ring> &r) {
+					if (!r->retired.load(std::memory_order_acquire) || !r->empty())
+						return false;
+					s.dropped += r->dropped.load(std::memory_order_relaxed);
+					return true;
+				});
+				s.flush_done = flush_target;
+				s.flushed.notify_all();
+
+				// stop_async() waited out every producer before setting stopping, this pass saw everything
+				if (stopping)
+					break;
+			}
+		}
+
+		/**
+		 * Producer side of every record, fill(dst, size) writes the payload
+		 * Text longer than a ring takes is truncated, a deferred record that does not fit
+		 * returns false like async being off: the caller formats and writes it itself
+		 */
+		template <typename Fill>
+		bool push(Level lvl, Ring::Kind kind, std::int64_t time, std::size_t size, Fill &&fill)
+		{
+			State			&s = state();
+			std::uint64_t	session = s.session.load(std::memory_order_acquire);
+			if (session == 0 || producer_destroyed)
+				return false;
+
+			Producer &p = producer;
+			if (p.session != session && !attach(s, p, session))
+				return false;
+
+			Ring &r = *p.ring;
+			if (size > r.max_payload())
+			{
+				if (kind != Ring::text)
+					return false;
+				size = r.max_payload();
+			}
+
+			// pairs with stop_async(): either it sees busy, or this thread sees the session end
+			r.busy.store(true, std::memory_order_seq_cst);
+			if (s.session.load(std::memory_order_seq_cst) != session)
+			{
+				r.busy.store(false, std::memory_order_release);
+				return false;
+			}
+
+			bool queued = true;
+			for (int attempt = 0; !r.try_push(static_cast<std::uint8_t>(lvl), kind, time, size, [&](std::byte *dst) { fill(dst, size); }); ++attempt)
+			{
+				if (p.overflow != BLOCK)
+				{
+					r.dropped.store(r.dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+					break;
+				}
+				if (s.session.load(std::memory_order_relaxed) != session)
+				{
+					queued = false;
+					break;
+				}
+				s.room_wanted.store(true, std::memory_order_relaxed);
+				s.wake.notify_one();
+				if (attempt < 64)
+					std::this_thread::yield();
+				else
+					std::this_thread::sleep_for(std::chrono::microseconds(100));
+			}
+
+			r.busy.store(false, std::memory_order_release);
+			return queued;
+		}
+
+	}
+
+	bool detail::enqueue(Level lvl, std::int64_t time, std::string_view msg)
+	{
+		return push(lvl, Ring::text, time, msg.size(), [&](std::byte *dst, std::size_t size) { std::memcpy(dst, msg.data(), size); });
+	}
+
+	bool detail::enqueue_deferred(Level lvl, std::int64_t time, std::size_t size, void (*encode)(std::byte *, const void *), const void *ctx)
+	{
+		return push(lvl, Ring::deferred, time, size, [&](std::byte *dst, std::size_t) { encode(dst, ctx); });
+	}
+
+	void detail::add_writer_task(void (*task)())
+	{
+		State &s = state();
+		std::lock_guard lock(s.mutex);
+		s.tasks.push_back(task);
+	}
+
+	void start_async(const AsyncOptions &options)
+	{
+		State &s = state();
+		std::lock_guard lock(s.mutex);
+		if (s.session.load(std::memory_order_relaxed) != 0)
+			return;
+
+		std::cout.flush();
+		std::cerr.flush();
+
+		s.options = options;
+		s.stopping = false;
+		s.flush_requested = s.flush_done = 0;
+		s.dropped = 0;
+		s.writer = std::thread(writer_main, std::ref(s));
+		s.session.store(++s.sessions, std::memory_order_release);
+
+		if (!s.exit_hook)
+		{
+			s.exit_hook = true;
+			std::atexit(stop_async);
+		}
+	}
+
+	void stop_async()
+	{
+		State &s = state();
+		std::vector<std::shared_ptr<Ring>> rings;
+		{
+			std::lock_guard lock(s.mutex);
+			if (s.session.load(std::memory_order_relaxed) == 0)
+				return;
+			s.session.store(0, std::memory_order_seq_cst);
+			rings = s.rings;
+		}
+
+		// producers that passed their session check finish their push first
+		for (const auto &r : rings)
+			while (r->busy.load(std::memory_order_seq_cst))
+				std::this_thread::yield();
+
+		{
+			std::lock_guard lock(s.mutex);
+			s.stopping = true;
+		}
+		s.wake.notify_one();
+		s.writer.join();
+
+		std::lock_guard lock(s.mutex);
+		for (const auto &r : s.rings)
+			s.dropped += r->dropped.load(std::memory_order_relaxed);
+		s.rings.clear();
+	}
+
+	void flush()
+	{
+		State &s = state();
+		std::unique_lock lock(s.mutex);
+		if (s.session.load(std::memory_order_relaxed) == 0)
+		{
+			lock.unlock();
+			std::cout.flush();
+			std::cerr.flush();
+			return;
+		}
+
+		std::uint64_t target = ++s.flush_requested;
+		s.wake.notify_one();
+		s.flushed.wait(lock, [&] { return s.flush_done >= target || s.session.load(std::memory_order_relaxed) == 0; });
+	}
+
+	bool is_async()
+	{
+		return state().session.load(std::memory_order_acquire) != 0;
+	}
+
+	std::uint64_t dropped()
+	{
+		State &s = state();
+		std::lock_guard lock(s.mutex);
+		std::uint64_t total = s.dropped;
+		for (const auto &r : s.rings)
+			total += r->dropped.load(std::memory_order_relaxed);
+		return total;
+	}
+
+}
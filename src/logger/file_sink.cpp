@@ -0,0 +1,181 @@
+#include "logger.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+
+#if !defined(_WIN32)
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
+
+namespace cu::logger {
+
+	namespace fs = std::filesystem;
+
+	FileSink::~FileSink()
+	{
+		close();
+	}
+
+#if defined(_WIN32)
+
+	Result FileSink::open(const FileSinkOptions &)
+	{
+		return Result::error("FileSink: memory-mapped segments need a POSIX system");
+	}
+
+	void FileSink::close() {}
+	void FileSink::write(Level, std::string_view) {}
+	void FileSink::flush() {}
+	Result FileSink::open_segment() { return Result::error("FileSink: unsupported"); }
+	void FileSink::close_segment() {}
+	void FileSink::rotate() {}
+
+#else
+
+	Result FileSink::open(const FileSinkOptions &options)
+	{
+		close();
+		if (options.path.empty())
+			return Result::error("FileSink: empty path");
+		if (options.segment_size == 0)
+			return Result::error("FileSink: segment size of 0");
+
+		_options = options;
+		_segments.clear();
+		_sequence = 0;
+		return open_segment();
+	}
+
+	void FileSink::close()
+	{
+		close_segment();
+		_options.path.clear();
+	}
+
+	/** <dir>/<stem>.<YYYYmmdd-HHMMSS>.<n><ext>, n keeps names unique */
+	Result FileSink::open_segment()
+	{
+		fs::path	base(_options.path);
+		std::error_code ec;
+		if (base.has_parent_path())
+			fs::create_directories(base.parent_path(), ec);
+
+		std::time_t	t = std::time(nullptr);
+		std::tm		tm;
+		localtime_r(&t, &tm);
+		char		stamp[32];
+		std::size_t	n = std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &tm);
+
+		// another process may have started a segment in the same second
+		int fd;
+		do
+		{
+			fs::path path = base.parent_path() / (base.stem().string() + '.' + std::string(stamp, n) + '.' + std::to_string(_sequence++) + base.extension().string());
+			_segment_path = path.string();
+			fd = ::open(_segment_path.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0644);
+		}
+		while (fd < 0 && errno == EEXIST);
+		if (fd < 0)
+			return Result::error("FileSink: cannot create " + _segment_path + ": " + std::strerror(errno));
+
+		// reserve the blocks now so a full disk fails here and not as SIGBUS on a store
+		int err = ::posix_fallocate(fd, 0, static_cast<off_t>(_options.segment_size));
+		if (err == EOPNOTSUPP || err == EINVAL)
+			err = ::ftruncate(fd, static_cast<off_t>(_options.segment_size)) == 0 ? 0 : errno;
+		if (err != 0)
+		{
+			::close(fd);
+			::unlink(_segment_path.c_str());
+			return Result::error("FileSink: cannot allocate " + std::to_string(_options.segment_size) + " bytes for " + _segment_path + ": " + std::strerror(err));
+		}
+
+		void *map = ::mmap(nullptr, _options.segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (map == MAP_FAILED)
+		{
+			err = errno;
+			::close(fd);
+			::unlink(_segment_path.c_str());
+			return Result::error("FileSink: cannot map " + _segment_path + ": " + std::strerror(err));
+		}
+
+		_fd = fd;
+		_map = static_cast<char *>(map);
+		_size = _options.segment_size;
+		_offset.store(0, std::memory_order_release);
+		_opened = std::chrono::steady_clock::now();
+
+		_segments.push_back(_segment_path);
+		if (_options.max_segments)
+			while (_segments.size() > _options.max_segments)
+			{
+				fs::remove(_segments.front(), ec);
+				_segments.pop_front();
+			}
+		return Result::ok();
+	}
+
+	void FileSink::close_segment()
+	{
+		if (!_map)
+			return;
+		std::size_t used = _offset.load(std::memory_order_relaxed);
+		::munmap(_map, _size);
+		// the unused tail would read back as NUL bytes
+		if (::ftruncate(_fd, static_cast<off_t>(used)) != 0)
+			std::fprintf(stderr, "FileSink: cannot truncate %s: %s\n", _segment_path.c_str(), std::strerror(errno));
+		::close(_fd);
+		_map = nullptr;
+		_fd = -1;
+		_size = 0;
+	}
+
+	void FileSink::rotate()
+	{
+		close_segment();
+		Result r = open_segment();
+		// the logger cannot log its own failure, the sink stays closed
+		if (!r.isOk())
+			std::fprintf(stderr, "%s\n", r.message.c_str());
+	}
+
+	void FileSink::write(Level, std::string_view line)
+	{
+		if (!_map)
+			return;
+
+		std::size_t offset = _offset.load(std::memory_order_relaxed);
+		while (!line.empty())
+		{
+			// a line stays in one segment unless it is longer than a whole segment
+			if (line.size() > _size - offset && offset != 0)
+			{
+				rotate();
+				if (!_map)
+					return;
+				offset = 0;
+			}
+
+			std::size_t n = std::min(line.size(), _size - offset);
+			std::memcpy(_map + offset, line.data(), n);
+			offset += n;
+			line.remove_prefix(n);
+			_offset.store(offset, std::memory_order_release);
+		}
+	}
+
+	void FileSink::flush()
+	{
+		if (_map && _options.max_age.count() > 0 && _offset.load(std::memory_order_relaxed) != 0
+			&& std::chrono::steady_clock::now() - _opened >= _options.max_age)
+			rotate();
+	}
+
+#endif
+
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "logger.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace cu::logger::detail {
+
+	/** "<timestamp> <level> ", the strftime part is cached per second */
+	class LineFormatter
+	{
+	public:
+		void	prefix(std::string &out, Level lvl, std::int64_t time, bool color);
+
+	private:
+		std::int64_t	_second = -1;
+		char			_stamp[32] = {};
+		std::size_t		_stamp_size = 0;
+	};
+
+	/**
+	 * Formats lines for the installed sinks and hands them over. begin() takes the lock
+	 * that serializes every sink call, end() flushes the sinks and releases it
+	 * The writer thread owns one, the synchronous path one per thread
+	 */
+	class Emitter
+	{
+	public:
+		void	begin();
+		void	end();
+
+		/** body(std::string &) appends the message */
+		template <typename Body>
+		void	line(Level lvl, std::int64_t time, Body &&body)
+		{
+			_body.clear();
+			body(_body);
+			if (_want_color)
+				compose(_colored, lvl, time, true);
+			if (_want_plain)
+				compose(_plain, lvl, time, false);
+			dispatch(lvl);
+		}
+
+	private:
+		void	compose(std::string &out, Level lvl, std::int64_t time, bool color)
+		{
+			out.clear();
+			_formatter.prefix(out, lvl, time, color);
+			out += _body;
+			out += '\n';
+		}
+
+		void	dispatch(Level lvl);
+
+		std::unique_lock<std::mutex>	_lock;
+		LineFormatter	_formatter;
+		std::string		_body;
+		std::string		_colored;
+		std::string		_plain;
+		bool			_want_color = false;
+		bool			_want_plain = false;
+	};
+
+	/** Async mode only: queues the line on the calling thread's ring, false when async is off */
+	bool	enqueue(Level lvl, std::int64_t time, std::string_view msg);
+
+	/** Runs on the async writer thread after every pass over the rings, for other modules' buffers (trace) */
+	void	add_writer_task(void (*task)());
+
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+
+namespace cu::logger::detail {
+
+	/**
+	 * Single producer / single consumer byte ring of variable length records
+	 * The producer (the logging thread) and the consumer (the writer) each own one
+	 * index and only read the other's, no CAS; indices grow monotonically and wrap
+	 * through the power-of-two mask. A record never straddles the end: the producer
+	 * leaves a skip marker and starts over at offset 0
+	 * https://rigtorp.se/ringbuffer/
+	 */
+	class Ring
+	{
+	public:
+		struct Header
+		{
+			std::uint32_t	size;		// payload bytes, skip_marker for the wrap padding
+			std::uint8_t	level;
+			std::uint8_t	kind;		// text or deferred (format_record arguments)
+			std::uint8_t	reserved[2];
+			std::int64_t	time;		// system_clock nanoseconds
+		};
+
+		enum Kind : std::uint8_t { text, deferred };
+
+		static constexpr std::uint32_t	skip_marker = ~0u;
+		static constexpr std::size_t	alignment = alignof(Header);
+
+		explicit Ring(std::size_t capacity)
+			: _capacity(std::bit_ceil(capacity < 1024 ? std::size_t(1024) : capacity))
+			, _data(new std::byte[_capacity])
+		{}
+
+		/** Longer text is truncated, longer deferred records are formatted by the caller instead */
+		std::size_t	max_payload() const { return _capacity / 4 - sizeof(Header); }
+
+		/** Producer: a size byte record written by fill(std::byte *), false when the ring has no room */
+		template <typename Fill>
+		bool	try_push(std::uint8_t level, Kind kind, std::int64_t time, std::size_t size, Fill &&fill)
+		{
+			const std::size_t	need = record_size(size);
+			const std::uint64_t	head = _head.load(std::memory_order_relaxed);
+			const std::size_t	offset = head & (_capacity - 1);
+			const std::size_t	to_end = _capacity - offset;
+			const std::size_t	total = need + (to_end < need ? to_end : 0);
+
+			if (_capacity - (head - _tail_cache) < total)
+			{
+				_tail_cache = _tail.load(std::memory_order_acquire);
+				if (_capacity - (head - _tail_cache) < total)
+					return false;
+			}
+
+			std::uint64_t	at = head;
+			if (to_end < need)
+			{
+				std::uint32_t	marker = skip_marker;
+				std::memcpy(_data.get() + offset, &marker, sizeof(marker));
+				at += to_end;
+			}
+
+			Header	h{static_cast<std::uint32_t>(size), level, kind, {}, time};
+			std::byte	*p = _data.get() + (at & (_capacity - 1));
+			std::memcpy(p, &h, sizeof(h));
+			fill(p + sizeof(h));
+
+			_head.store(at + need, std::memory_order_release);
+			return true;
+		}
+
+		/**
+		 * Consumer: fn(const Header&, const std::byte *payload) for every record published so far
+		 * Records stay valid until release(), so a batch can be merged with other rings first
+		 */
+		template <typename Fn>
+		std::uint64_t	peek(Fn &&fn) const
+		{
+			std::uint64_t		tail = _tail.load(std::memory_order_relaxed);
+			const std::uint64_t	head = _head.load(std::memory_order_acquire);
+
+			while (tail != head)
+			{
+				const std::size_t	offset = tail & (_capacity - 1);
+				Header	h;
+				std::memcpy(&h.size, _data.get() + offset, sizeof(h.size));
+				if (h.size == skip_marker)
+				{
+					tail += _capacity - offset;
+					continue;
+				}
+				std::memcpy(&h, _data.get() + offset, sizeof(h));
+				fn(h, _data.get() + offset + sizeof(h));
+				tail += record_size(h.size);
+			}
+			return tail;
+		}
+
+		/** Consumer: hands the space up to end (a peek() result) back to the producer */
+		void	release(std::uint64_t end) { _tail.store(end, std::memory_order_release); }
+
+		bool	empty() const { return _tail.load(std::memory_order_relaxed) == _head.load(std::memory_order_acquire); }
+
+		std::atomic<bool>			busy{false};		// producer is between its session check and its push
+		std::atomic<bool>			retired{false};		// producer thread exited
+		std::atomic<std::uint64_t>	dropped{0};
+		std::uint64_t				reported = 0;		// consumer: dropped count already logged
+
+	private:
+		static std::size_t	record_size(std::size_t payload)
+		{
+			return (sizeof(Header) + payload + alignment - 1) & ~(alignment - 1);
+		}
+
+		const std::size_t				_capacity;
+		std::unique_ptr<std::byte[]>	_data;
+
+		alignas(64) std::atomic<std::uint64_t>	_head{0};
+		std::uint64_t	_tail_cache = 0;
+		alignas(64) std::atomic<std::uint64_t>	_tail{0};
+	};
+
+}
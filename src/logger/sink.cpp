@@ -0,0 +1,189 @@
+#include "logger.hpp"
+#include "logger/internal.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if defined(_WIN32)
+# include <io.h>
+#else
+# include <cerrno>
+# include <unistd.h>
+#endif
+
+namespace cu::logger {
+
+	namespace {
+
+		struct Entry
+		{
+			std::shared_ptr<Sink>	sink;
+			bool					color;
+		};
+
+		struct Registry
+		{
+			std::mutex			mutex;		// held by an Emitter between begin() and end()
+			std::vector<Entry>	sinks;
+			bool				any_color = true;
+			bool				any_plain = false;
+			bool				exit_hook = false;
+
+			Registry() { sinks.push_back({std::make_shared<ConsoleSink>(), true}); }
+
+			void update()
+			{
+				any_color = std::any_of(sinks.begin(), sinks.end(), [](const Entry &e) { return e.color; });
+				any_plain = std::any_of(sinks.begin(), sinks.end(), [](const Entry &e) { return !e.color; });
+			}
+		};
+
+		// never destroyed, threads may still log from static destructors
+		Registry &registry()
+		{
+			static Registry *r = new Registry;
+			return *r;
+		}
+
+		void write_all(int fd, std::string &buffer)
+		{
+			const char	*p = buffer.data();
+			std::size_t	left = buffer.size();
+			while (left)
+			{
+			#if defined(_WIN32)
+				int n = _write(fd, p, static_cast<unsigned>(std::min<std::size_t>(left, 1u << 30)));
+			#else
+				ssize_t n = ::write(fd, p, left);
+				if (n < 0 && errno == EINTR)
+					continue;
+			#endif
+				if (n <= 0)
+					break;
+				p += n;
+				left -= static_cast<std::size_t>(n);
+			}
+			buffer.clear();
+		}
+
+		constexpr std::size_t	console_threshold = 1 << 20;
+
+		/**
+		 * The registry outlives everything, so installed sinks would never be destroyed:
+		 * at exit, drain async mode and release them (a FileSink truncates its segment),
+		 * later lines go to the console
+		 */
+		void release_sinks()
+		{
+			stop_async();
+			Registry &r = registry();
+			std::vector<Entry> keep;
+			{
+				std::lock_guard lock(r.mutex);
+				for (const Entry &e : r.sinks)
+					e.sink->flush();
+				keep.swap(r.sinks);
+				r.sinks.push_back({std::make_shared<ConsoleSink>(), true});
+				r.update();
+			}
+		}
+
+	}
+
+	void ConsoleSink::write(Level lvl, std::string_view line)
+	{
+		std::string &out = lvl == ERROR ? _err : _out;
+		out += line;
+		if (out.size() >= console_threshold)
+			flush();
+	}
+
+	void ConsoleSink::flush()
+	{
+		if (_out.empty() && _err.empty())
+			return;
+
+		// whatever the program printed itself goes out first
+		std::cout.flush();
+		std::cerr.flush();
+		std::fflush(stdout);
+		std::fflush(stderr);
+
+		if (!_out.empty())
+			write_all(1, _out);
+		if (!_err.empty())
+			write_all(2, _err);
+	}
+
+	void add_sink(std::shared_ptr<Sink> sink)
+	{
+		if (!sink)
+			return;
+		Registry &r = registry();
+		std::lock_guard lock(r.mutex);
+		bool color = sink->color();
+		r.sinks.push_back({std::move(sink), color});
+		r.update();
+		if (!r.exit_hook)
+		{
+			r.exit_hook = true;
+			std::atexit(release_sinks);
+		}
+	}
+
+	void remove_sink(const std::shared_ptr<Sink> &sink)
+	{
+		Registry &r = registry();
+		std::shared_ptr<Sink> keep;	// released after the lock, a FileSink unmaps in its destructor
+		{
+			std::lock_guard lock(r.mutex);
+			auto it = std::find_if(r.sinks.begin(), r.sinks.end(), [&](const Entry &e) { return e.sink == sink; });
+			if (it == r.sinks.end())
+				return;
+			it->sink->flush();
+			keep = std::move(it->sink);
+			r.sinks.erase(it);
+			r.update();
+		}
+	}
+
+	void clear_sinks()
+	{
+		Registry &r = registry();
+		std::vector<Entry> keep;
+		{
+			std::lock_guard lock(r.mutex);
+			for (const Entry &e : r.sinks)
+				e.sink->flush();
+			keep.swap(r.sinks);
+			r.update();
+		}
+	}
+
+	void detail::Emitter::begin()
+	{
+		Registry &r = registry();
+		_lock = std::unique_lock(r.mutex);
+		_want_color = r.any_color;
+		_want_plain = r.any_plain;
+	}
+
+	void detail::Emitter::dispatch(Level lvl)
+	{
+		for (const Entry &e : registry().sinks)
+			e.sink->write(lvl, e.color ? _colored : _plain);
+	}
+
+	void detail::Emitter::end()
+	{
+		for (const Entry &e : registry().sinks)
+			e.sink->flush();
+		_lock.unlock();
+	}
+
+}
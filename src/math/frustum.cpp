@@ -0,0 +1,133 @@
+#include "math/frustum.hpp"
+#include "math/floatx8.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+namespace cu::math {
+
+namespace {
+
+/** Planes broadcast once per call */
+struct planesx8
+{
+	floatx8 x[6], y[6], z[6], w[6];
+
+	explicit planesx8(const frustum& f)
+	{
+		for (int i = 0; i < 6; ++i)
+		{
+			x[i] = floatx8(f.planes[i].x);
+			y[i] = floatx8(f.planes[i].y);
+			z[i] = floatx8(f.planes[i].z);
+			w[i] = floatx8(f.planes[i].w);
+		}
+	}
+};
+
+/**
+ * Runs test on 8 objects at a time and packs its masks into 64-bit words
+ * The last partial word is fed from zero-padded copies so the kernel never reads past the spans
+ */
+template <std::size_t S, typename Test>
+std::size_t cull(const std::span<const float> (&in)[S], std::span<std::uint64_t> visible, Test&& test)
+{
+	const std::size_t n = in[0].size();
+	for ([[maybe_unused]] const auto& s : in)
+		assert(s.size() == n);
+	assert(visible.size() >= (n + 63) / 64);
+
+	std::size_t count = 0;
+	std::size_t i = 0;
+	floatx8 v[S];
+
+	for (; i + 64 <= n; i += 64)
+	{
+		std::uint64_t word = 0;
+		for (std::size_t k = 0; k < 64; k += 8)
+		{
+			for (std::size_t s = 0; s < S; ++s)
+				v[s] = floatx8::load(in[s].data() + i + k);
+			word |= static_cast<std::uint64_t>(test(v).bits()) << k;
+		}
+		visible[i / 64] = word;
+		count += std::popcount(word);
+	}
+
+	if (i < n)
+	{
+		std::uint64_t word = 0;
+		for (std::size_t k = 0; i + k < n; k += 8)
+		{
+			std::size_t lanes = std::min<std::size_t>(8, n - i - k);
+			for (std::size_t s = 0; s < S; ++s)
+			{
+				alignas(32) float padded[8] = {};
+				std::copy_n(in[s].data() + i + k, lanes, padded);
+				v[s] = floatx8::load(padded);
+			}
+			word |= static_cast<std::uint64_t>(test(v).bits() & ((1u << lanes) - 1)) << k;
+		}
+		visible[i / 64] = word;
+		count += std::popcount(word);
+	}
+
+	return count;
+}
+
+}
+
+/** Signed distance of the center against -radius, one fmadd chain per plane */
+std::size_t cull_spheres(const frustum& f,
+	std::span<const float> x, std::span<const float> y, std::span<const float> z, std::span<const float> radius,
+	std::span<std::uint64_t> visible)
+{
+	const planesx8 p(f);
+	const std::span<const float> in[4] = {x, y, z, radius};
+
+	return cull(in, visible, [&p](const floatx8 (&v)[4]) {
+		maskx8 inside(true);
+		for (int i = 0; i < 6; ++i)
+		{
+			floatx8 d = floatx8::fmadd(p.x[i], v[0], floatx8::fmadd(p.y[i], v[1], floatx8::fmadd(p.z[i], v[2], p.w[i] + v[3])));
+			inside = inside & (d >= floatx8(0.0f));
+		}
+		return inside;
+	});
+}
+
+/**
+ * p-vertex test: the normals are the same for every lane, so the corner furthest
+ * along each one is a per-plane choice between the min and max registers, no abs or select
+ */
+std::size_t cull_aabbs(const frustum& f,
+	std::span<const float> min_x, std::span<const float> min_y, std::span<const float> min_z,
+	std::span<const float> max_x, std::span<const float> max_y, std::span<const float> max_z,
+	std::span<std::uint64_t> visible)
+{
+	const planesx8 p(f);
+	bool pos_x[6], pos_y[6], pos_z[6];
+	for (int i = 0; i < 6; ++i)
+	{
+		pos_x[i] = f.planes[i].x >= 0.0f;
+		pos_y[i] = f.planes[i].y >= 0.0f;
+		pos_z[i] = f.planes[i].z >= 0.0f;
+	}
+	const std::span<const float> in[6] = {min_x, min_y, min_z, max_x, max_y, max_z};
+
+	return cull(in, visible, [&](const floatx8 (&v)[6]) {
+		maskx8 inside(true);
+		for (int i = 0; i < 6; ++i)
+		{
+			const floatx8& vx = pos_x[i] ? v[3] : v[0];
+			const floatx8& vy = pos_y[i] ? v[4] : v[1];
+			const floatx8& vz = pos_z[i] ? v[5] : v[2];
+			floatx8 d = floatx8::fmadd(p.x[i], vx, floatx8::fmadd(p.y[i], vy, floatx8::fmadd(p.z[i], vz, p.w[i])));
+			inside = inside & (d >= floatx8(0.0f));
+		}
+		return inside;
+	});
+}
+
+}
@@ -0,0 +1,559 @@
+#include "math/packed.hpp"
+#include "math/vec3x.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#if defined(__SSE__)
+#include <immintrin.h>
+#endif
+
+namespace cu::math {
+
+namespace {
+
+constexpr float inv_sqrt2 = 0.70710678118654752f;
+
+// snorm16, 1 / 32767 is the step of the octahedral grid
+constexpr float oct_scale = 32767.0f;
+
+/* ---------------------------------------------------------------------------------- */
+/* half                                                                               */
+/* ---------------------------------------------------------------------------------- */
+
+#if defined(__SSE2__) && !defined(__F16C__)
+/**
+ * 4 floats -> 4 halves in the low 16 bits of each lane, same rounding as detail::float_to_half
+ * https://gist.github.com/rygorous/2156668
+ */
+inline __m128i float_to_half_sse2(__m128 f)
+{
+	const __m128i f16_max = _mm_set1_epi32((127 + 16) << 23);
+	const __m128i min_normal = _mm_set1_epi32((127 - 14) << 23);
+	const __m128i subnorm_magic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+	const __m128i normal_bias = _mm_set1_epi32(0xfff - ((127 - 15) << 23));
+	const __m128i one = _mm_set1_epi32(1);
+
+	__m128 sign = _mm_and_ps(f, _mm_set1_ps(-0.0f));
+	__m128 absf = _mm_xor_ps(f, sign);
+	__m128i absi = _mm_castps_si128(absf);
+
+	__m128i is_nan = _mm_castps_si128(_mm_cmpunord_ps(absf, absf));
+	__m128i inf_or_nan = _mm_or_si128(_mm_and_si128(is_nan, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7c00));
+	__m128i is_regular = _mm_cmpgt_epi32(f16_max, absi);
+	__m128i is_sub = _mm_cmpgt_epi32(min_normal, absi);
+
+	// subnormals: the float add aligns and rounds the mantissa
+	__m128i sub = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absf, _mm_castsi128_ps(subnorm_magic))), subnorm_magic);
+
+	// normals: rebias the exponent, round to nearest even
+	__m128i odd = _mm_and_si128(_mm_srli_epi32(absi, 13), one);
+	__m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(absi, normal_bias), odd), 13);
+
+	__m128i h = _mm_or_si128(_mm_and_si128(is_sub, sub), _mm_andnot_si128(is_sub, normal));
+	h = _mm_or_si128(_mm_and_si128(is_regular, h), _mm_andnot_si128(is_regular, inf_or_nan));
+	return _mm_or_si128(h, _mm_srli_epi32(_mm_castps_si128(sign), 16));
+}
+
+/** 4 halves zero-extended to 32-bit lanes -> 4 floats */
+inline __m128 half_to_float_sse2(__m128i h)
+{
+	const __m128i no_sign = _mm_set1_epi32(0x7fff);
+	const __m128 magic = _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23));
+
+	__m128i expmant = _mm_and_si128(h, no_sign);
+	__m128i sign = _mm_slli_epi32(_mm_xor_si128(h, expmant), 16);
+
+	// 2^112 rescales the exponent, subnormal halves become normal floats exactly
+	__m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(expmant, 13)), magic);
+	__m128i was_inf_nan = _mm_cmpgt_epi32(expmant, _mm_set1_epi32(0x7bff));
+	__m128i inf_nan_exp = _mm_and_si128(was_inf_nan, _mm_set1_epi32(255 << 23));
+
+	return _mm_or_ps(scaled, _mm_castsi128_ps(_mm_or_si128(sign, inf_nan_exp)));
+}
+#endif
+
+/** Converts 8 values per call, returns how many were done (0 when the ISA has nothing) */
+inline std::size_t encode_half8(const float* in, half* out, std::size_t n)
+{
+	std::size_t i = 0;
+#if defined(__AVX__) && defined(__F16C__)
+	for (; i + 8 <= n; i += 8)
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT));
+#elif defined(__F16C__)
+	for (; i + 4 <= n; i += 4)
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_cvtps_ph(_mm_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT));
+#elif defined(__SSE2__)
+	for (; i + 8 <= n; i += 8)
+	{
+		// sign-extend so the signed saturating pack keeps the 16 bit patterns
+		__m128i lo = float_to_half_sse2(_mm_loadu_ps(in + i));
+		__m128i hi = float_to_half_sse2(_mm_loadu_ps(in + i + 4));
+		lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+		hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(lo, hi));
+	}
+#endif
+	return i;
+}
+
+inline std::size_t decode_half8(const half* in, float* out, std::size_t n)
+{
+	std::size_t i = 0;
+#if defined(__AVX__) && defined(__F16C__)
+	for (; i + 8 <= n; i += 8)
+		_mm256_storeu_ps(out + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i))));
+#elif defined(__F16C__)
+	for (; i + 4 <= n; i += 4)
+		_mm_storeu_ps(out + i, _mm_cvtph_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i))));
+#elif defined(__SSE2__)
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 8 <= n; i += 8)
+	{
+		__m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+		_mm_storeu_ps(out + i, half_to_float_sse2(_mm_unpacklo_epi16(h, zero)));
+		_mm_storeu_ps(out + i + 4, half_to_float_sse2(_mm_unpackhi_epi16(h, zero)));
+	}
+#endif
+	return i;
+}
+
+void encode_half_flat(const float* in, half* out, std::size_t n)
+{
+	for (std::size_t i = encode_half8(in, out, n); i < n; ++i)
+		out[i] = half(in[i]);
+}
+
+void decode_half_flat(const half* in, float* out, std::size_t n)
+{
+	for (std::size_t i = decode_half8(in, out, n); i < n; ++i)
+		out[i] = float(in[i]);
+}
+
+/* ---------------------------------------------------------------------------------- */
+/* octahedral                                                                         */
+/* ---------------------------------------------------------------------------------- */
+
+// scalar overloads so the templates below read the same for both paths
+inline float abs(float v) { return std::fabs(v); }
+inline float min(float a, float b) { return a < b ? a : b; }
+inline float max(float a, float b) { return a > b ? a : b; }
+inline float sqrt(float v) { return std::sqrt(v); }
+inline float select(bool m, float a, float b) { return m ? a : b; }
+
+inline floatx4 abs(const floatx4& v) { return floatx4::abs(v); }
+inline floatx4 min(const floatx4& a, const floatx4& b) { return floatx4::min(a, b); }
+inline floatx4 max(const floatx4& a, const floatx4& b) { return floatx4::max(a, b); }
+inline floatx4 sqrt(const floatx4& v) { return floatx4::sqrt(v); }
+inline floatx4 select(const maskx4& m, const floatx4& a, const floatx4& b) { return floatx4::select(m, a, b); }
+
+/**
+ * Shared by the scalar and SoA paths, F is float or floatx4
+ * Zero vectors map to the octahedron center and decode to +z
+ */
+template <typename F>
+inline void oct_fold(const F& x, const F& y, const F& z, F& px, F& py)
+{
+	F l1 = abs(x) + abs(y) + abs(z);
+	F inv = select(l1 > F(0.0f), F(1.0f) / l1, F(0.0f));
+	px = x * inv;
+	py = y * inv;
+
+	// lower hemisphere: reflect over the diagonals, keeping the sign (0 counts as positive)
+	F fx = (F(1.0f) - abs(py)) * select(px >= F(0.0f), F(1.0f), F(-1.0f));
+	F fy = (F(1.0f) - abs(px)) * select(py >= F(0.0f), F(1.0f), F(-1.0f));
+	auto lower = z < F(0.0f);
+	px = select(lower, fx, px);
+	py = select(lower, fy, py);
+}
+
+/** https://twitter.com/Stubbesaurus/status/937994790553227264 (branchless unfold) */
+template <typename F>
+inline void oct_unfold(F px, F py, F& x, F& y, F& z)
+{
+	px = max(min(px * F(1.0f / oct_scale), F(1.0f)), F(-1.0f));
+	py = max(min(py * F(1.0f / oct_scale), F(1.0f)), F(-1.0f));
+
+	F nz = F(1.0f) - abs(px) - abs(py);
+	F t = max(-nz, F(0.0f));
+	px = px + select(px >= F(0.0f), -t, t);
+	py = py + select(py >= F(0.0f), -t, t);
+
+	F inv = F(1.0f) / sqrt(px * px + py * py + nz * nz);
+	x = px * inv;
+	y = py * inv;
+	z = nz * inv;
+}
+
+inline std::int32_t round_snorm(float v) { return static_cast<std::int32_t>(std::nearbyint(v * oct_scale)); }
+
+inline oct32 make_oct32(std::int32_t x, std::int32_t y)
+{
+	return {static_cast<std::uint32_t>(x & 0xffff) | (static_cast<std::uint32_t>(y) << 16)};
+}
+
+/* ---------------------------------------------------------------------------------- */
+/* smallest three                                                                     */
+/* ---------------------------------------------------------------------------------- */
+
+template <int Bits>
+struct smallest3
+{
+	static constexpr int width = Bits;
+	static constexpr std::uint32_t max_q = (1u << Bits) - 1u;
+
+	// [-1/sqrt(2), 1/sqrt(2)] -> [0, max_q]
+	static inline std::uint32_t quantize(float v)
+	{
+		float u = (v * inv_sqrt2 + 0.5f) * static_cast<float>(max_q);
+		u = u < 0.0f ? 0.0f : (u > static_cast<float>(max_q) ? static_cast<float>(max_q) : u);
+		return static_cast<std::uint32_t>(u + 0.5f);
+	}
+
+	static inline float dequantize(std::uint64_t u)
+	{
+		return (static_cast<float>(u & max_q) * (1.0f / static_cast<float>(max_q)) - 0.5f) * (2.0f * inv_sqrt2);
+	}
+
+	/** Packs (index << 3 * Bits) | (a << 2 * Bits) | (b << Bits) | c */
+	static inline std::uint64_t encode(const quat& q)
+	{
+		float c[4] = {q.w, q.x, q.y, q.z};
+
+		int index = 0;
+		for (int i = 1; i < 4; ++i)
+			if (std::fabs(c[i]) > std::fabs(c[index]))
+				index = i;
+
+		// same operation order as the SoA path so both produce the same bits
+		float l = std::sqrt(c[0] * c[0] + c[1] * c[1] + c[2] * c[2] + c[3] * c[3]);
+		float inv = l > 0.0f ? 1.0f / l : 1.0f;
+		if (c[index] < 0.0f)
+			inv = -inv;
+
+		std::uint64_t bits = static_cast<std::uint64_t>(index);
+		for (int i = 0; i < 4; ++i)
+			if (i != index)
+				bits = (bits << Bits) | quantize(c[i] * inv);
+		return bits;
+	}
+
+	static inline quat decode(std::uint64_t bits)
+	{
+		int index = static_cast<int>((bits >> (3 * Bits)) & 3u);
+		float v[3] = {dequantize(bits >> (2 * Bits)), dequantize(bits >> Bits), dequantize(bits)};
+		float d = std::sqrt(std::max(0.0f, 1.0f - (v[0] * v[0] + v[1] * v[1] + v[2] * v[2])));
+
+		float c[4];
+		for (int i = 0, j = 0; i < 4; ++i)
+			c[i] = i == index ? d : v[j++];
+		return {c[0], c[1], c[2], c[3]};
+	}
+};
+
+using smallest3_48 = smallest3<15>;
+using smallest3_64 = smallest3<20>;
+
+inline quat48 to_quat48(std::uint64_t bits)
+{
+	return {{static_cast<std::uint16_t>(bits), static_cast<std::uint16_t>(bits >> 16), static_cast<std::uint16_t>(bits >> 32)}};
+}
+
+inline std::uint64_t from_quat48(const quat48& p)
+{
+	return static_cast<std::uint64_t>(p.bits[0]) | (static_cast<std::uint64_t>(p.bits[1]) << 16) | (static_cast<std::uint64_t>(p.bits[2]) << 32);
+}
+
+/** 4 quaternions <-> w/x/y/z packets */
+inline void load_quat4(const quat* src, floatx4 (&r)[4])
+{
+#if defined(__SSE__)
+	__m128 a = src[0].v.v, b = src[1].v.v, c = src[2].v.v, d = src[3].v.v;
+	_MM_TRANSPOSE4_PS(a, b, c, d);
+	r[0] = floatx4(a); r[1] = floatx4(b); r[2] = floatx4(c); r[3] = floatx4(d);
+#else
+	alignas(16) float t[4][4];
+	for (int k = 0; k < 4; ++k)
+	{
+		t[0][k] = src[k].w; t[1][k] = src[k].x;
+		t[2][k] = src[k].y; t[3][k] = src[k].z;
+	}
+	for (int k = 0; k < 4; ++k)
+		r[k] = floatx4::load(t[k]);
+#endif
+}
+
+inline void store_quat4(quat* dst, const floatx4& w, const floatx4& x, const floatx4& y, const floatx4& z)
+{
+#if defined(__SSE__)
+	__m128 a = w.v, b = x.v, c = y.v, d = z.v;
+	_MM_TRANSPOSE4_PS(a, b, c, d);
+	dst[0].v.v = a; dst[1].v.v = b; dst[2].v.v = c; dst[3].v.v = d;
+#else
+	alignas(16) float t[4][4];
+	w.store(t[0]); x.store(t[1]); y.store(t[2]); z.store(t[3]);
+	for (int k = 0; k < 4; ++k)
+		dst[k] = quat(t[0][k], t[1][k], t[2][k], t[3][k]);
+#endif
+}
+
+/**
+ * 4 quaternions per iteration: the normalize, the largest component search and the
+ * quantization run in SoA, only the bit packing is per lane
+ */
+template <typename S, typename Store>
+void encode_quats(std::span<const quat> in, Store&& store)
+{
+	std::size_t n = in.size();
+	std::size_t i = 0;
+
+	for (; i + 4 <= n; i += 4)
+	{
+		floatx4 c[4];
+		load_quat4(&in[i], c);
+
+		floatx4 l = floatx4::sqrt(c[0] * c[0] + c[1] * c[1] + c[2] * c[2] + c[3] * c[3]);
+		floatx4 inv = select(l > floatx4(0.0f), floatx4(1.0f) / l, floatx4(1.0f));
+
+		floatx4 index(0.0f);
+		floatx4 best = abs(c[0]);
+		for (int k = 1; k < 4; ++k)
+		{
+			auto gt = abs(c[k]) > best;
+			index = select(gt, floatx4(static_cast<float>(k)), index);
+			best = select(gt, abs(c[k]), best);
+		}
+
+		// sign of the dropped component folded into the normalization
+		floatx4 dropped = c[0];
+		for (int k = 1; k < 4; ++k)
+			dropped = select(index == floatx4(static_cast<float>(k)), c[k], dropped);
+		inv = select(dropped < floatx4(0.0f), -inv, inv);
+
+		// the three kept components in order: w is only kept when dropping x/y/z, and so on
+		auto le1 = index <= floatx4(1.0f);
+		auto le2 = index <= floatx4(2.0f);
+		floatx4 kept[3] = {
+			select(index == floatx4(0.0f), c[1], c[0]),
+			select(le1, c[2], c[1]),
+			select(le2, c[3], c[2]),
+		};
+
+		const floatx4 max_q(static_cast<float>(S::max_q));
+		alignas(16) float u[3][4];
+		for (int k = 0; k < 3; ++k)
+		{
+			floatx4 q = (kept[k] * inv * floatx4(inv_sqrt2) + floatx4(0.5f)) * max_q;
+			q = min(max(q, floatx4(0.0f)), max_q) + floatx4(0.5f);
+			q.store(u[k]);
+		}
+
+		alignas(16) float idx[4];
+		index.store(idx);
+		for (int k = 0; k < 4; ++k)
+		{
+			std::uint64_t bits = static_cast<std::uint64_t>(idx[k]) << (3 * S::width);
+			bits |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(u[0][k])) << (2 * S::width);
+			bits |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(u[1][k])) << S::width;
+			bits |= static_cast<std::uint32_t>(u[2][k]);
+			store(i + k, bits);
+		}
+	}
+
+	for (; i < n; ++i)
+		store(i, S::encode(in[i]));
+}
+
+template <typename S, typename Load>
+void decode_quats(std::size_t n, std::span<quat> out, Load&& load)
+{
+	constexpr int bits_per = S::width;
+	std::size_t i = 0;
+
+	for (; i + 4 <= n; i += 4)
+	{
+		// unpack the three stored components in order, the dropped slot is filled below
+		alignas(16) float a[3][4];
+		alignas(16) float idx[4];
+		for (int k = 0; k < 4; ++k)
+		{
+			std::uint64_t bits = load(i + k);
+			idx[k] = static_cast<float>((bits >> (3 * bits_per)) & 3u);
+			a[0][k] = static_cast<float>((bits >> (2 * bits_per)) & S::max_q);
+			a[1][k] = static_cast<float>((bits >> bits_per) & S::max_q);
+			a[2][k] = static_cast<float>(bits & S::max_q);
+		}
+
+		const floatx4 rq(1.0f / static_cast<float>(S::max_q));
+		floatx4 v[3];
+		for (int j = 0; j < 3; ++j)
+			v[j] = (floatx4::load(a[j]) * rq - floatx4(0.5f)) * floatx4(2.0f * inv_sqrt2);
+		floatx4 sum = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+		floatx4 d = floatx4::sqrt(max(floatx4(0.0f), floatx4(1.0f) - sum));
+
+		floatx4 index = floatx4::load(idx);
+		auto drop0 = index == floatx4(0.0f);
+		auto drop1 = index == floatx4(1.0f);
+		auto drop2 = index == floatx4(2.0f);
+		auto drop3 = index == floatx4(3.0f);
+		auto le1 = index <= floatx4(1.0f);
+
+		floatx4 w = select(drop0, d, v[0]);
+		floatx4 x = select(drop0, v[0], select(drop1, d, v[1]));
+		floatx4 y = select(le1, v[1], select(drop2, d, v[2]));
+		floatx4 z = select(drop3, d, v[2]);
+
+		store_quat4(&out[i], w, x, y, z);
+	}
+
+	for (; i < n; ++i)
+		out[i] = S::decode(load(i));
+}
+
+}
+
+/* ---------------------------------------------------------------------------------- */
+
+oct32 encode_oct32(const vec3& n)
+{
+	float px, py;
+	oct_fold(n.x, n.y, n.z, px, py);
+	return make_oct32(round_snorm(px), round_snorm(py));
+}
+
+vec3 decode_oct32(oct32 p)
+{
+	float px = static_cast<float>(static_cast<std::int16_t>(p.bits & 0xffff));
+	float py = static_cast<float>(static_cast<std::int16_t>(p.bits >> 16));
+	vec3 r;
+	oct_unfold(px, py, r.x, r.y, r.z);
+	return r;
+}
+
+quat48 encode_quat48(const quat& q) { return to_quat48(smallest3_48::encode(q)); }
+quat decode_quat48(const quat48& p) { return smallest3_48::decode(from_quat48(p)); }
+quat64 encode_quat64(const quat& q) { return {smallest3_64::encode(q)}; }
+quat decode_quat64(const quat64& p) { return smallest3_64::decode(p.bits); }
+
+void encode_half(std::span<const float> in, std::span<half> out)
+{
+	assert(in.size() == out.size());
+	encode_half_flat(in.data(), out.data(), in.size());
+}
+
+void decode_half(std::span<const half> in, std::span<float> out)
+{
+	assert(in.size() == out.size());
+	decode_half_flat(in.data(), out.data(), in.size());
+}
+
+// vec3/vec4 and their half versions are tightly packed, so they convert as flat arrays
+void encode_half(std::span<const vec3> in, std::span<vec3h> out)
+{
+	assert(in.size() == out.size());
+	encode_half_flat(reinterpret_cast<const float*>(in.data()), reinterpret_cast<half*>(out.data()), in.size() * 3);
+}
+
+void decode_half(std::span<const vec3h> in, std::span<vec3> out)
+{
+	assert(in.size() == out.size());
+	decode_half_flat(reinterpret_cast<const half*>(in.data()), reinterpret_cast<float*>(out.data()), in.size() * 3);
+}
+
+void encode_half(std::span<const vec4> in, std::span<vec4h> out)
+{
+	assert(in.size() == out.size());
+	encode_half_flat(reinterpret_cast<const float*>(in.data()), reinterpret_cast<half*>(out.data()), in.size() * 4);
+}
+
+void decode_half(std::span<const vec4h> in, std::span<vec4> out)
+{
+	assert(in.size() == out.size());
+	decode_half_flat(reinterpret_cast<const half*>(in.data()), reinterpret_cast<float*>(out.data()), in.size() * 4);
+}
+
+void encode_oct32(std::span<const vec3> in, std::span<oct32> out)
+{
+	assert(in.size() == out.size());
+	std::size_t n = in.size();
+	std::size_t i = 0;
+
+	for (; i + 4 <= n; i += 4)
+	{
+		vec3x4 v = vec3x4::load(in, i);
+		floatx4 px, py;
+		oct_fold(v.x, v.y, v.z, px, py);
+	#if defined(__SSE2__)
+		// cvtps rounds to nearest even like nearbyint in the default rounding mode
+		__m128i ix = _mm_cvtps_epi32(_mm_mul_ps(px.v, _mm_set1_ps(oct_scale)));
+		__m128i iy = _mm_cvtps_epi32(_mm_mul_ps(py.v, _mm_set1_ps(oct_scale)));
+		__m128i bits = _mm_or_si128(_mm_and_si128(ix, _mm_set1_epi32(0xffff)), _mm_slli_epi32(iy, 16));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out.data() + i), bits);
+	#else
+		for (int k = 0; k < 4; ++k)
+			out[i + k] = make_oct32(round_snorm(px[k]), round_snorm(py[k]));
+	#endif
+	}
+
+	for (; i < n; ++i)
+		out[i] = encode_oct32(in[i]);
+}
+
+void decode_oct32(std::span<const oct32> in, std::span<vec3> out)
+{
+	assert(in.size() == out.size());
+	std::size_t n = in.size();
+	std::size_t i = 0;
+
+	for (; i + 4 <= n; i += 4)
+	{
+		floatx4 px, py;
+	#if defined(__SSE2__)
+		__m128i bits = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in.data() + i));
+		px = floatx4(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(bits, 16), 16)));
+		py = floatx4(_mm_cvtepi32_ps(_mm_srai_epi32(bits, 16)));
+	#else
+		alignas(16) float tx[4], ty[4];
+		for (int k = 0; k < 4; ++k)
+		{
+			tx[k] = static_cast<float>(static_cast<std::int16_t>(in[i + k].bits & 0xffff));
+			ty[k] = static_cast<float>(static_cast<std::int16_t>(in[i + k].bits >> 16));
+		}
+		px = floatx4::load(tx);
+		py = floatx4::load(ty);
+	#endif
+		vec3x4 v;
+		oct_unfold(px, py, v.x, v.y, v.z);
+		v.store(out, i);
+	}
+
+	for (; i < n; ++i)
+		out[i] = decode_oct32(in[i]);
+}
+
+void encode_quat48(std::span<const quat> in, std::span<quat48> out)
+{
+	assert(in.size() == out.size());
+	encode_quats<smallest3_48>(in, [&](std::size_t i, std::uint64_t bits) { out[i] = to_quat48(bits); });
+}
+
+void decode_quat48(std::span<const quat48> in, std::span<quat> out)
+{
+	assert(in.size() == out.size());
+	decode_quats<smallest3_48>(in.size(), out, [&](std::size_t i) { return from_quat48(in[i]); });
+}
+
+void encode_quat64(std::span<const quat> in, std::span<quat64> out)
+{
+	assert(in.size() == out.size());
+	encode_quats<smallest3_64>(in, [&](std::size_t i, std::uint64_t bits) { out[i] = {bits}; });
+}
+
+void decode_quat64(std::span<const quat64> in, std::span<quat> out)
+{
+	assert(in.size() == out.size());
+	decode_quats<smallest3_64>(in.size(), out, [&](std::size_t i) { return in[i].bits; });
+}
+
+}
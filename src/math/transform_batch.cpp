@@ -0,0 +1,278 @@
+#include "math/transform.hpp"
+#include "math/vec3x.hpp"
+#include "cpu.hpp"
+#include "parallel.hpp"
+
+#include <cassert>
+
+namespace cu::math {
+
+namespace {
+
+constexpr std::size_t parallel_min_chunk = 16384;
+
+/**
+ * 3x4 affine part of a mat4 in SoA form, columns broadcast once per batch
+ * out = x * c0 + y * c1 + z * c2 + w * c3
+ */
+template <typename F>
+struct columns
+{
+	vec3xN<F> c0, c1, c2, c3;
+
+	columns(const vec3& a, const vec3& b, const vec3& c, const vec3& t)
+		: c0(a), c1(b), c2(c), c3(t) {}
+
+	inline vec3xN<F> point(const vec3xN<F>& p) const
+	{
+		return {
+			F::fmadd(p.x, c0.x, F::fmadd(p.y, c1.x, F::fmadd(p.z, c2.x, c3.x))),
+			F::fmadd(p.x, c0.y, F::fmadd(p.y, c1.y, F::fmadd(p.z, c2.y, c3.y))),
+			F::fmadd(p.x, c0.z, F::fmadd(p.y, c1.z, F::fmadd(p.z, c2.z, c3.z)))
+		};
+	}
+
+	inline vec3xN<F> direction(const vec3xN<F>& p) const
+	{
+		return {
+			F::fmadd(p.x, c0.x, F::fmadd(p.y, c1.x, p.z * c2.x)),
+			F::fmadd(p.x, c0.y, F::fmadd(p.y, c1.y, p.z * c2.y)),
+			F::fmadd(p.x, c0.z, F::fmadd(p.y, c1.z, p.z * c2.z))
+		};
+	}
+};
+
+enum class kind { point, direction, normal };
+
+/**
+ * 8-wide main loop (one AVX register or two SSE registers per component),
+ * 4-wide masked tail
+ */
+template <kind K>
+void transform_range(const vec3 (&c)[4], std::span<const vec3> in, std::span<vec3> out)
+{
+	columns<floatx8> m8(c[0], c[1], c[2], c[3]);
+	columns<floatx4> m4(c[0], c[1], c[2], c[3]);
+
+	std::size_t i = 0;
+	std::size_t n = in.size();
+
+	for (; i + 8 <= n; i += 8)
+	{
+		vec3x8 p = vec3x8::load(in, i);
+		if constexpr (K == kind::point)
+			m8.point(p).store(out, i);
+		else if constexpr (K == kind::direction)
+			m8.direction(p).store(out, i);
+		else
+			vec3x8::normalize(m8.direction(p)).store(out, i);
+	}
+
+	for (; i < n; i += 4)
+	{
+		vec3x4 p = vec3x4::load(in, i);
+		if constexpr (K == kind::point)
+			m4.point(p).store(out, i);
+		else if constexpr (K == kind::direction)
+			m4.direction(p).store(out, i);
+		else
+			vec3x4::normalize(m4.direction(p)).store(out, i);
+	}
+}
+
+#if CU_MULTIVERSION
+/**
+ * AVX2 + FMA version of transform_range() for baseline builds, where floatx8 is two
+ * SSE halves. Written against the intrinsics directly: the header packet types are
+ * compiled for the baseline ISA and must not be instantiated with a different target
+ */
+template <kind K>
+CU_TARGET_AVX2 void transform_range_avx2(const vec3 (&c)[4], std::span<const vec3> in, std::span<vec3> out)
+{
+	__m256 cx[4], cy[4], cz[4];
+	for (int j = 0; j < 4; ++j)
+	{
+		cx[j] = _mm256_set1_ps(c[j].x);
+		cy[j] = _mm256_set1_ps(c[j].y);
+		cz[j] = _mm256_set1_ps(c[j].z);
+	}
+
+	std::size_t i = 0;
+	std::size_t n = in.size();
+	const float* src = reinterpret_cast<const float*>(in.data());
+	float* dst = reinterpret_cast<float*>(out.data());
+
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256 x, y, z;
+		detail::load_xyz8(src + 3 * i, x, y, z);
+
+		__m256 rx = _mm256_fmadd_ps(z, cx[2], K == kind::point ? cx[3] : _mm256_setzero_ps());
+		__m256 ry = _mm256_fmadd_ps(z, cy[2], K == kind::point ? cy[3] : _mm256_setzero_ps());
+		__m256 rz = _mm256_fmadd_ps(z, cz[2], K == kind::point ? cz[3] : _mm256_setzero_ps());
+		rx = _mm256_fmadd_ps(x, cx[0], _mm256_fmadd_ps(y, cx[1], rx));
+		ry = _mm256_fmadd_ps(x, cy[0], _mm256_fmadd_ps(y, cy[1], ry));
+		rz = _mm256_fmadd_ps(x, cz[0], _mm256_fmadd_ps(y, cz[1], rz));
+
+		if constexpr (K == kind::normal)
+		{
+			__m256 l2 = _mm256_fmadd_ps(rx, rx, _mm256_fmadd_ps(ry, ry, _mm256_mul_ps(rz, rz)));
+			__m256 one = _mm256_set1_ps(1.0f);
+			__m256 inv = _mm256_blendv_ps(one, _mm256_div_ps(one, _mm256_sqrt_ps(l2)), _mm256_cmp_ps(l2, _mm256_setzero_ps(), _CMP_GT_OQ));
+			rx = _mm256_mul_ps(rx, inv);
+			ry = _mm256_mul_ps(ry, inv);
+			rz = _mm256_mul_ps(rz, inv);
+		}
+
+		detail::store_xyz8(dst + 3 * i, rx, ry, rz);
+	}
+
+	if (i < n)
+		transform_range<K>(c, in.subspan(i), out.subspan(i));
+}
+#endif
+
+/** Bound at load time to the AVX2 version when the CPU has it, see cpu.hpp */
+CU_TARGET_DEFAULT void transform_kernel(kind k, const vec3 (&c)[4], std::span<const vec3> in, std::span<vec3> out)
+{
+	switch (k)
+	{
+		case kind::point:		transform_range<kind::point>(c, in, out); break;
+		case kind::direction:	transform_range<kind::direction>(c, in, out); break;
+		case kind::normal:		transform_range<kind::normal>(c, in, out); break;
+	}
+}
+
+#if CU_MULTIVERSION
+CU_TARGET_AVX2 void transform_kernel(kind k, const vec3 (&c)[4], std::span<const vec3> in, std::span<vec3> out)
+{
+	switch (k)
+	{
+		case kind::point:		transform_range_avx2<kind::point>(c, in, out); break;
+		case kind::direction:	transform_range_avx2<kind::direction>(c, in, out); break;
+		case kind::normal:		transform_range_avx2<kind::normal>(c, in, out); break;
+	}
+}
+#endif
+
+void transform_batch(kind k, const vec3 (&c)[4], std::span<const vec3> in, std::span<vec3> out, bool parallel)
+{
+	assert(in.size() == out.size());
+
+	if (!parallel || in.size() < 2 * parallel_min_chunk)
+	{
+		transform_kernel(k, c, in, out);
+		return;
+	}
+
+	cu::parallel::for_chunks(in.size(), parallel_min_chunk, [&](std::size_t begin, std::size_t end) {
+		transform_kernel(k, c, in.subspan(begin, end - begin), out.subspan(begin, end - begin));
+	});
+}
+
+CU_TARGET_DEFAULT void multiply_range(const mat4* a, const mat4* b, std::size_t b_step, mat4* out, std::size_t n)
+{
+	for (std::size_t i = 0; i < n; ++i)
+		out[i] = a[i] * b[i * b_step];
+}
+
+#if CU_MULTIVERSION
+/** Two rows of a per register against the rows of b repeated in both halves, like mat4::operator* with AVX */
+CU_TARGET_AVX2 inline void multiply_rows(const float* a, const __m256 (&b)[4], float* out)
+{
+	for (int i = 0; i < 4; i += 2)
+	{
+		__m256 r = _mm256_loadu_ps(a + 4 * i);
+		__m256 s = _mm256_mul_ps(_mm256_shuffle_ps(r, r, _MM_SHUFFLE(3,3,3,3)), b[3]);
+		s = _mm256_fmadd_ps(_mm256_shuffle_ps(r, r, _MM_SHUFFLE(2,2,2,2)), b[2], s);
+		s = _mm256_fmadd_ps(_mm256_shuffle_ps(r, r, _MM_SHUFFLE(1,1,1,1)), b[1], s);
+		s = _mm256_fmadd_ps(_mm256_shuffle_ps(r, r, _MM_SHUFFLE(0,0,0,0)), b[0], s);
+		_mm256_storeu_ps(out + 4 * i, s);
+	}
+}
+
+CU_TARGET_AVX2 void multiply_range(const mat4* a, const mat4* b, std::size_t b_step, mat4* out, std::size_t n)
+{
+	__m256 rows[4];
+	if (b_step == 0)
+	{
+		for (int k = 0; k < 4; ++k)
+			rows[k] = _mm256_broadcast_ps(&b->row[k]);
+		for (std::size_t i = 0; i < n; ++i)
+			multiply_rows(a[i].m[0], rows, out[i].m[0]);
+		return;
+	}
+
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		for (int k = 0; k < 4; ++k)
+			rows[k] = _mm256_broadcast_ps(&b[i].row[k]);
+		multiply_rows(a[i].m[0], rows, out[i].m[0]);
+	}
+}
+#endif
+
+void multiply_batch(std::span<const mat4> a, const mat4* b, std::size_t b_step, std::span<mat4> out, bool parallel)
+{
+	assert(a.size() == out.size());
+
+	if (!parallel || a.size() < 2 * parallel_min_chunk / 16)
+	{
+		multiply_range(a.data(), b, b_step, out.data(), a.size());
+		return;
+	}
+
+	cu::parallel::for_chunks(a.size(), parallel_min_chunk / 16, [&](std::size_t begin, std::size_t end) {
+		multiply_range(a.data() + begin, b + begin * b_step, b_step, out.data() + begin, end - begin);
+	});
+}
+
+inline vec3 column(const mat4& m, int i) { return {m.m[i][0], m.m[i][1], m.m[i][2]}; }
+
+}
+
+void transform_points(const mat4& m, std::span<const vec3> in, std::span<vec3> out, bool parallel)
+{
+	const vec3 c[4] = {column(m, 0), column(m, 1), column(m, 2), column(m, 3)};
+	transform_batch(kind::point, c, in, out, parallel);
+}
+
+void transform_directions(const mat4& m, std::span<const vec3> in, std::span<vec3> out, bool parallel)
+{
+	const vec3 c[4] = {column(m, 0), column(m, 1), column(m, 2), vec3(0.0f)};
+	transform_batch(kind::direction, c, in, out, parallel);
+}
+
+/**
+ * inverse(A)^T = cofactor(A) / det(A), the cofactor columns are the cross products
+ * of the columns of A. The output is renormalized so only the sign of det matters,
+ * which keeps normals pointing outwards under mirroring transforms
+ * https://en.wikipedia.org/wiki/Adjugate_matrix
+ */
+void transform_normals(const mat4& m, std::span<const vec3> in, std::span<vec3> out, bool parallel)
+{
+	vec3 a = column(m, 0);
+	vec3 b = column(m, 1);
+	vec3 d = column(m, 2);
+
+	vec3 ca = vec3::cross(b, d);
+	float sign = vec3::dot(a, ca) < 0.0f ? -1.0f : 1.0f;
+
+	const vec3 c[4] = {ca * sign, vec3::cross(d, a) * sign, vec3::cross(a, b) * sign, vec3(0.0f)};
+	transform_batch(kind::normal, c, in, out, parallel);
+}
+
+void multiply(std::span<const mat4> a, std::span<const mat4> b, std::span<mat4> out, bool parallel)
+{
+	assert(a.size() == b.size());
+	multiply_batch(a, b.data(), 1, out, parallel);
+}
+
+void multiply(std::span<const mat4> a, const mat4& b, std::span<mat4> out, bool parallel)
+{
+	// copied in case b is one of the outputs
+	const mat4 m = b;
+	multiply_batch(a, &m, 0, out, parallel);
+}
+
+}
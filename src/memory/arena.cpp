@@ -0,0 +1,129 @@
+#include "memory/arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+
+namespace cu::memory {
+
+namespace {
+
+inline char* align_up(char* p, std::size_t alignment)
+{
+	auto v = reinterpret_cast<std::uintptr_t>(p);
+	return p + ((alignment - (v & (alignment - 1))) & (alignment - 1));
+}
+
+}
+
+Arena::Arena(std::size_t block_size, std::pmr::memory_resource* upstream)
+	: _upstream(upstream), _block_size(std::max(block_size, sizeof(Block) * 2))
+{
+}
+
+Arena::Arena(void* buffer, std::size_t size, std::size_t block_size, std::pmr::memory_resource* upstream)
+	: Arena(block_size, upstream)
+{
+	// the block header takes the front of the buffer, a buffer too small for it is unused
+	void*		p = buffer;
+	std::size_t	space = size;
+	if (std::align(alignof(Block), sizeof(Block), p, space) && space > sizeof(Block))
+	{
+		_first = new (p) Block{nullptr, space - sizeof(Block), false};
+		_current = _first;
+		_cursor = _first->begin();
+	}
+}
+
+Arena::~Arena()
+{
+	release();
+}
+
+void Arena::rewind(Marker marker)
+{
+	// a mark of the empty arena is before its first block
+	if (!marker.block)
+	{
+		reset();
+		return;
+	}
+	_current = marker.block;
+	_cursor = marker.cursor;
+}
+
+void Arena::reset()
+{
+	_current = _first;
+	_cursor = _first ? _first->begin() : nullptr;
+}
+
+void Arena::release()
+{
+	// the caller's buffer, always first, stays
+	Block* keep = _first && !_first->owned ? _first : nullptr;
+	for (Block* b = keep ? keep->next : _first; b;)
+	{
+		Block* next = b->next;
+		_upstream->deallocate(b, sizeof(Block) + b->size, alignof(Block));
+		b = next;
+	}
+	if (keep)
+		keep->next = nullptr;
+	_first = keep;
+	reset();
+}
+
+std::size_t Arena::used() const
+{
+	std::size_t n = 0;
+	for (Block* b = _first; b && b != _current; b = b->next)
+		n += b->size;
+	return _current ? n + static_cast<std::size_t>(_cursor - _current->begin()) : 0;
+}
+
+std::size_t Arena::capacity() const
+{
+	std::size_t n = 0;
+	for (Block* b = _first; b; b = b->next)
+		n += b->size;
+	return n;
+}
+
+void* Arena::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+	if (_current)
+	{
+		char* p = align_up(_cursor, alignment);
+		if (p <= _current->end() && bytes <= static_cast<std::size_t>(_current->end() - p))
+		{
+			_cursor = p + bytes;
+			return p;
+		}
+	}
+	return next_block(bytes, alignment);
+}
+
+void* Arena::next_block(std::size_t bytes, std::size_t alignment)
+{
+	std::size_t need = bytes + (alignment > alignof(Block) ? alignment - 1 : 0);
+
+	// the block after this one was kept by rewind() or reset(), reuse it if the allocation fits
+	Block** link = _current ? &_current->next : &_first;
+	if (*link && (*link)->size >= need)
+	{
+		_current = *link;
+		_cursor = _current->begin();
+		return do_allocate(bytes, alignment);
+	}
+
+	std::size_t	size = std::max(_block_size - sizeof(Block), need);
+	void*		memory = _upstream->allocate(sizeof(Block) + size, alignof(Block));
+	Block*		b = new (memory) Block{*link, size, true};
+	*link = b;
+	_current = b;
+	_cursor = b->begin();
+	return do_allocate(bytes, alignment);
+}
+
+}
@@ -0,0 +1,23 @@
+#include "memory/frame.hpp"
+
+namespace cu::memory {
+
+FrameAllocator::FrameAllocator(std::size_t block_size, std::pmr::memory_resource* upstream)
+	: _arenas{Arena(block_size, upstream), Arena(block_size, upstream)}
+{
+}
+
+void FrameAllocator::release()
+{
+	_arenas[0].release();
+	_arenas[1].release();
+}
+
+FrameAllocator& frame()
+{
+	// the heap as upstream, the default resource may be replaced by one that does not outlive the thread
+	static thread_local FrameAllocator allocator(Arena::default_block_size, std::pmr::new_delete_resource());
+	return allocator;
+}
+
+}
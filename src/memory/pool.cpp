@@ -0,0 +1,115 @@
+#include "memory/pool.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <new>
+
+namespace cu::memory {
+
+namespace {
+
+/** The free stack's link lives in the first 4 bytes of a free slot */
+inline std::atomic_ref<std::uint32_t> link(void* slot)
+{
+	return std::atomic_ref<std::uint32_t>(*static_cast<std::uint32_t*>(slot));
+}
+
+inline std::uint64_t top(std::uint64_t previous, std::uint32_t index)
+{
+	return ((previous >> 32) + 1) << 32 | index;
+}
+
+}
+
+Pool::Pool(std::size_t size, std::size_t alignment, std::pmr::memory_resource* upstream)
+	: _alignment(std::max(alignment, alignof(std::uint32_t))), _upstream(upstream)
+{
+	_slot_size = (std::max(size, sizeof(std::uint32_t)) + _alignment - 1) / _alignment * _alignment;
+}
+
+Pool::~Pool()
+{
+	for (int k = 0; k < max_slabs; ++k)
+		if (char* slab = _slabs[k].load(std::memory_order_relaxed))
+			_upstream->deallocate(slab, (first_slab << k) * _slot_size, _alignment);
+}
+
+std::size_t Pool::capacity() const
+{
+	std::size_t n = 0;
+	for (int k = 0; k < max_slabs; ++k)
+		if (_slabs[k].load(std::memory_order_relaxed))
+			n += first_slab << k;
+	return n;
+}
+
+void* Pool::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+	if (bytes > _slot_size || alignment > _alignment)
+		return _upstream->allocate(bytes, alignment);
+
+	// the slot read may have been popped and reused meanwhile, then the version has changed and the CAS fails
+	std::uint64_t head = _free.load(std::memory_order_acquire);
+	while (static_cast<std::uint32_t>(head) != empty)
+	{
+		char* p = slot(static_cast<std::uint32_t>(head));
+		std::uint32_t next = link(p).load(std::memory_order_relaxed);
+		if (_free.compare_exchange_weak(head, top(head, next), std::memory_order_acquire, std::memory_order_acquire))
+			return p;
+	}
+	return fresh_slot();
+}
+
+void Pool::do_deallocate(void* p, std::size_t bytes, std::size_t alignment)
+{
+	if (bytes > _slot_size || alignment > _alignment)
+	{
+		_upstream->deallocate(p, bytes, alignment);
+		return;
+	}
+
+	std::uint32_t index = index_of(p);
+	// a pointer from another resource, pushing it would cut the free stack
+	assert(index != empty);
+	if (index == empty)
+		return;
+
+	std::uint64_t head = _free.load(std::memory_order_relaxed);
+	do
+		link(p).store(static_cast<std::uint32_t>(head), std::memory_order_relaxed);
+	while (!_free.compare_exchange_weak(head, top(head, index), std::memory_order_release, std::memory_order_relaxed));
+}
+
+std::uint32_t Pool::index_of(const void* p) const
+{
+	// slabs may be installed out of order, when threads race past the end of one
+	const char* c = static_cast<const char*>(p);
+	for (int k = 0; k < max_slabs; ++k)
+	{
+		const char* base = _slabs[k].load(std::memory_order_acquire);
+		if (base && c >= base && c < base + (first_slab << k) * _slot_size)
+			return static_cast<std::uint32_t>((first_slab << k) - first_slab + static_cast<std::size_t>(c - base) / _slot_size);
+	}
+	return empty;	// not from this pool
+}
+
+char* Pool::fresh_slot()
+{
+	std::uint32_t index = _fresh.fetch_add(1, std::memory_order_relaxed);
+	if (index >= (first_slab << max_slabs) - first_slab)
+	{
+		_fresh.store((first_slab << max_slabs) - first_slab, std::memory_order_relaxed);
+		throw std::bad_alloc();
+	}
+
+	int slab = slab_of(index);
+	if (!_slabs[slab].load(std::memory_order_acquire))
+	{
+		std::lock_guard lock(_grow);
+		if (!_slabs[slab].load(std::memory_order_relaxed))
+			_slabs[slab].store(static_cast<char*>(_upstream->allocate((first_slab << slab) * _slot_size, _alignment)), std::memory_order_release);
+	}
+	return slot(index);
+}
+
+}
@@ -0,0 +1,339 @@
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace cu::metrics {
+
+	namespace {
+
+		/** Shards without an owner, lowest first */
+		struct Slots
+		{
+			std::mutex			mutex;
+			std::vector<std::size_t>	free;
+
+			Slots()
+			{
+				for (std::size_t i = detail::max_shards; i-- > 0;)
+					free.push_back(i);
+			}
+		};
+
+		// never destroyed, threads exit after static destruction
+		Slots &slots()
+		{
+			static Slots *s = new Slots;
+			return *s;
+		}
+
+		struct Registry
+		{
+			std::mutex	mutex;
+			std::map<std::string, std::unique_ptr<Counter>, std::less<>>	counters;
+			std::map<std::string, std::unique_ptr<Gauge>, std::less<>>		gauges;
+			std::map<std::string, std::unique_ptr<Histogram>, std::less<>>	histograms;
+		};
+
+		// never destroyed, metrics may still be updated from static destructors
+		Registry &registry()
+		{
+			static Registry *r = new Registry;
+			return *r;
+		}
+
+		template <typename T>
+		T &find_or_create(std::map<std::string, std::unique_ptr<T>, std::less<>> &map, std::string_view name)
+		{
+			std::lock_guard lock(registry().mutex);
+			auto it = map.find(name);
+			if (it == map.end())
+				it = map.emplace(std::string(name), std::make_unique<T>()).first;
+			return *it->second;
+		}
+
+		template <typename T>
+		void append_number(std::string &out, T value)
+		{
+			char buffer[32];
+			auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+			out.append(buffer, end);
+		}
+
+		void append_fixed(std::string &out, double value, int decimals)
+		{
+			char buffer[64];
+			auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed, decimals);
+			out.append(buffer, end);
+		}
+
+		void append_name(std::string &out, const char *kind, const std::string &name)
+		{
+			out += kind;
+			out += name;
+			if (name.size() < 32)
+				out.append(32 - name.size(), ' ');
+			out += ' ';
+		}
+
+	}
+
+	// the mutex orders the last update of an exiting owner before the first of the next one
+	detail::Slot::Slot()
+	{
+		Slots &s = slots();
+		std::lock_guard lock(s.mutex);
+		if (s.free.empty())
+			index = max_shards;
+		else
+		{
+			index = s.free.back();
+			s.free.pop_back();
+		}
+	}
+
+	detail::Slot::~Slot()
+	{
+		slot_destroyed = true;
+		if (!owned())
+			return;
+		Slots &s = slots();
+		std::lock_guard lock(s.mutex);
+		s.free.push_back(index);
+	}
+
+	std::uint64_t Counter::value() const
+	{
+		std::uint64_t total = 0;
+		for (const auto &c : _cells)
+			total += c.value.load(std::memory_order_relaxed);
+		return total;
+	}
+
+	/** Not synchronized with add(): updates racing the reset may survive it */
+	void Counter::reset()
+	{
+		for (auto &c : _cells)
+			c.value.store(0, std::memory_order_relaxed);
+	}
+
+	Histogram::~Histogram()
+	{
+		for (auto &s : _shards)
+			delete s.load(std::memory_order_relaxed);
+	}
+
+	Histogram::Shard *Histogram::create(std::size_t slot)
+	{
+		Shard *s = new Shard;
+		Shard *expected = nullptr;
+		// threads past max_shards share the last one
+		if (!_shards[slot].compare_exchange_strong(expected, s, std::memory_order_acq_rel))
+		{
+			delete s;
+			return expected;
+		}
+		return s;
+	}
+
+	void Histogram::lower(std::atomic<std::uint64_t> &v, std::uint64_t x, bool owned)
+	{
+		if (owned)
+		{
+			v.store(x, std::memory_order_relaxed);
+			return;
+		}
+		std::uint64_t cur = v.load(std::memory_order_relaxed);
+		while (x < cur && !v.compare_exchange_weak(cur, x, std::memory_order_relaxed))
+			;
+	}
+
+	void Histogram::raise(std::atomic<std::uint64_t> &v, std::uint64_t x, bool owned)
+	{
+		if (owned)
+		{
+			v.store(x, std::memory_order_relaxed);
+			return;
+		}
+		std::uint64_t cur = v.load(std::memory_order_relaxed);
+		while (x > cur && !v.compare_exchange_weak(cur, x, std::memory_order_relaxed))
+			;
+	}
+
+	std::uint64_t Histogram::bucket_lower(std::size_t index)
+	{
+		if (index < sub_buckets)
+			return index;
+		std::size_t group = index >> precision_bits;
+		std::uint64_t sub = index & (sub_buckets - 1);
+		return (sub_buckets + sub) << (group - 1);
+	}
+
+	std::uint64_t Histogram::bucket_upper(std::size_t index)
+	{
+		if (index < sub_buckets)
+			return index;
+		std::size_t group = index >> precision_bits;
+		return bucket_lower(index) + ((std::uint64_t(1) << (group - 1)) - 1);
+	}
+
+	HistogramSnapshot Histogram::snapshot() const
+	{
+		HistogramSnapshot r;
+		r.buckets.assign(bucket_count, 0);
+		r.min = UINT64_MAX;
+		for (const auto &p : _shards)
+		{
+			const Shard *s = p.load(std::memory_order_acquire);
+			if (!s)
+				continue;
+			for (std::size_t i = 0; i < bucket_count; ++i)
+			{
+				std::uint64_t n = s->buckets[i].load(std::memory_order_relaxed);
+				r.buckets[i] += n;
+				r.count += n;
+			}
+			r.sum += s->sum.load(std::memory_order_relaxed);
+			r.min = std::min(r.min, s->min.load(std::memory_order_relaxed));
+			r.max = std::max(r.max, s->max.load(std::memory_order_relaxed));
+		}
+		if (r.count == 0)
+			r.min = 0;
+		return r;
+	}
+
+	void Histogram::reset()
+	{
+		for (auto &p : _shards)
+		{
+			Shard *s = p.load(std::memory_order_acquire);
+			if (!s)
+				continue;
+			for (auto &b : s->buckets)
+				b.store(0, std::memory_order_relaxed);
+			s->sum.store(0, std::memory_order_relaxed);
+			s->min.store(UINT64_MAX, std::memory_order_relaxed);
+			s->max.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	std::uint64_t HistogramSnapshot::percentile(double p) const
+	{
+		if (count == 0)
+			return 0;
+		std::uint64_t rank = static_cast<std::uint64_t>(std::ceil(std::clamp(p, 0.0, 100.0) / 100.0 * static_cast<double>(count)));
+		rank = std::max<std::uint64_t>(rank, 1);
+
+		std::uint64_t seen = 0;
+		for (std::size_t i = 0; i < buckets.size(); ++i)
+		{
+			seen += buckets[i];
+			if (seen >= rank)
+				return std::clamp(Histogram::bucket_upper(i), min, max);
+		}
+		return max;
+	}
+
+	Counter &counter(std::string_view name)
+	{
+		return find_or_create(registry().counters, name);
+	}
+
+	Gauge &gauge(std::string_view name)
+	{
+		return find_or_create(registry().gauges, name);
+	}
+
+	Histogram &histogram(std::string_view name)
+	{
+		return find_or_create(registry().histograms, name);
+	}
+
+	Snapshot snapshot()
+	{
+		Registry &r = registry();
+		Snapshot s;
+		std::lock_guard lock(r.mutex);
+		s.time = logger::detail::now();
+		for (const auto &[name, c] : r.counters)
+			s.counters.push_back({name, c->value()});
+		for (const auto &[name, g] : r.gauges)
+			s.gauges.push_back({name, g->value()});
+		for (const auto &[name, h] : r.histograms)
+			s.histograms.push_back({name, h->snapshot()});
+		return s;
+	}
+
+	std::string format(const Snapshot &now, const Snapshot *previous)
+	{
+		std::string out;
+		double seconds = previous ? static_cast<double>(now.time - previous->time) * 1e-9 : 0.0;
+
+		for (const auto &c : now.counters)
+		{
+			append_name(out, "counter   ", c.name);
+			append_number(out, c.value);
+			if (previous && seconds > 0.0)
+			{
+				// both lists are sorted by name
+				auto it = std::lower_bound(previous->counters.begin(), previous->counters.end(), c.name,
+					[](const Snapshot::CounterValue &v, const std::string &n) { return v.name < n; });
+				std::uint64_t before = it != previous->counters.end() && it->name == c.name ? it->value : 0;
+				out += "  ";
+				append_fixed(out, static_cast<double>(c.value - before) / seconds, 1);
+				out += "/s";
+			}
+			out += '\n';
+		}
+
+		for (const auto &g : now.gauges)
+		{
+			append_name(out, "gauge     ", g.name);
+			append_number(out, g.value);
+			out += '\n';
+		}
+
+		static constexpr std::pair<const char *, double> percentiles[] = {{"p50", 50.0}, {"p90", 90.0}, {"p99", 99.0}, {"p99.9", 99.9}};
+		for (const auto &h : now.histograms)
+		{
+			append_name(out, "histogram ", h.name);
+			out += "count=";
+			append_number(out, h.value.count);
+			out += " min=";
+			append_number(out, h.value.min);
+			for (const auto &[label, p] : percentiles)
+			{
+				out += ' ';
+				out += label;
+				out += '=';
+				append_number(out, h.value.percentile(p));
+			}
+			out += " max=";
+			append_number(out, h.value.max);
+			out += " mean=";
+			append_fixed(out, h.value.mean(), 1);
+			out += '\n';
+		}
+		return out;
+	}
+
+	void log(const Snapshot &now, const Snapshot *previous, logger::Level lvl)
+	{
+		if (!logger::enabled(lvl))
+			return;
+		std::string text = format(now, previous);
+		std::string_view rest = text;
+		while (!rest.empty())
+		{
+			std::size_t end = rest.find('\n');
+			logger::log(lvl, std::string(rest.substr(0, end)));
+			rest.remove_prefix(end == std::string_view::npos ? rest.size() : end + 1);
+		}
+	}
+
+}
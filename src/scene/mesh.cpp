@@ -0,0 +1,447 @@
+#include "scene/mesh.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <string>
+
+#if defined(_WIN32)
+#include <fstream>
+#include <sstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace cu::scene {
+
+using math::vec2;
+using math::vec3;
+
+namespace {
+
+enum Attribute { position, texcoord, normal };
+
+constexpr std::size_t none = ~std::size_t(0);
+
+/** Everything one chunk of text produced, indices local where relative (see resolve) */
+struct Chunk
+{
+	const char*	begin;
+	const char*	end;
+
+	std::vector<vec3>			positions;
+	std::vector<vec3>			normals;
+	std::vector<vec2>			texcoords;
+	std::vector<std::uint32_t>	index[3];		// per Attribute, one per triangle corner
+	std::vector<std::size_t>	relative[3];	// entries of index[a] counted from this chunk's first element
+	std::vector<std::uint8_t>	given;			// per corner, bit a set when the face wrote attribute a
+	bool						used[3] = {true, false, false};
+
+	std::string		error;
+	std::size_t		error_line = 0;	// 1-based, within the chunk
+};
+
+struct Corner
+{
+	std::uint32_t	index[3];
+	bool			relative[3];
+	bool			given[3];	// written by the face, a resolved index may equal no_index
+};
+
+inline const char* skip_spaces(const char* p, const char* end)
+{
+	while (p < end && (*p == ' ' || *p == '\t'))
+		++p;
+	return p;
+}
+
+inline bool is_space(const char* p, const char* end)
+{
+	return p < end && (*p == ' ' || *p == '\t');
+}
+
+inline bool parse_float(const char*& p, const char* end, float& v)
+{
+	p = skip_spaces(p, end);
+	if (p < end && *p == '+')
+		++p;
+	auto [ptr, ec] = std::from_chars(p, end, v);
+	if (ec != std::errc())
+		return false;
+	p = ptr;
+	return true;
+}
+
+/**
+ * OBJ index of attribute a: 1-based, or negative counting back from the last element
+ * defined so far. Relative ones are stored against the chunk and rebased when stitched
+ */
+inline bool parse_index(const char*& p, const char* end, std::size_t count, Corner& c, Attribute a)
+{
+	long long i;
+	auto [ptr, ec] = std::from_chars(p, end, i);
+	// past 2^32 - 1 positive or 2^32 negative would wrap, a valid index must fit below no_index
+	if (ec != std::errc() || i == 0 || i > static_cast<long long>(Mesh::no_index) || i < -(1ll << 32))
+		return false;
+	p = ptr;
+	c.relative[a] = i < 0;
+	c.given[a] = true;
+	c.index[a] = static_cast<std::uint32_t>(i < 0 ? static_cast<long long>(count) + i : i - 1);
+	return true;
+}
+
+void emit(Chunk& c, const Corner& corner)
+{
+	std::uint8_t given = 0;
+	for (int a = 0; a < 3; ++a)
+	{
+		if (corner.relative[a])
+			c.relative[a].push_back(c.index[a].size());
+		c.index[a].push_back(corner.index[a]);
+		given |= static_cast<std::uint8_t>(corner.given[a] << a);
+	}
+	c.given.push_back(given);
+}
+
+bool fail(Chunk& c, std::size_t line, const char* what)
+{
+	c.error = what;
+	c.error_line = line;
+	return false;
+}
+
+bool parse_chunk(Chunk& c)
+{
+	std::vector<Corner> polygon;
+	std::size_t line = 0;
+
+	for (const char* p = c.begin; p < c.end;)
+	{
+		++line;
+		const char* eol = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(c.end - p)));
+		if (!eol)
+			eol = c.end;
+		const char* end = eol;
+		if (end > p && end[-1] == '\r')
+			--end;
+		const char* q = skip_spaces(p, end);
+		p = eol + 1;
+
+		if (end - q < 2)
+			continue;
+
+		if (q[0] == 'v' && is_space(q + 1, end))
+		{
+			vec3 v;
+			q += 1;
+			// a fourth (w) or color components may follow, ignored
+			if (!parse_float(q, end, v.x) || !parse_float(q, end, v.y) || !parse_float(q, end, v.z))
+				return fail(c, line, "bad vertex position");
+			c.positions.push_back(v);
+		}
+		else if (q[0] == 'v' && q[1] == 't' && is_space(q + 2, end))
+		{
+			vec2 t;
+			q += 2;
+			if (!parse_float(q, end, t.x))
+				return fail(c, line, "bad texture coordinate");
+			if (skip_spaces(q, end) < end && !parse_float(q, end, t.y))
+				return fail(c, line, "bad texture coordinate");
+			c.texcoords.push_back(t);
+		}
+		else if (q[0] == 'v' && q[1] == 'n' && is_space(q + 2, end))
+		{
+			vec3 n;
+			q += 2;
+			if (!parse_float(q, end, n.x) || !parse_float(q, end, n.y) || !parse_float(q, end, n.z))
+				return fail(c, line, "bad vertex normal");
+			c.normals.push_back(n);
+		}
+		else if (q[0] == 'f' && is_space(q + 1, end))
+		{
+			polygon.clear();
+			q = skip_spaces(q + 1, end);
+			while (q < end)
+			{
+				Corner corner = {{Mesh::no_index, Mesh::no_index, Mesh::no_index}, {false, false, false}, {false, false, false}};
+				if (!parse_index(q, end, c.positions.size(), corner, position))
+					return fail(c, line, "bad face index");
+				if (q < end && *q == '/')
+				{
+					++q;
+					if (q < end && *q != '/')
+					{
+						if (!parse_index(q, end, c.texcoords.size(), corner, texcoord))
+							return fail(c, line, "bad face texture index");
+						c.used[texcoord] = true;
+					}
+					if (q < end && *q == '/')
+					{
+						++q;
+						if (!parse_index(q, end, c.normals.size(), corner, normal))
+							return fail(c, line, "bad face normal index");
+						c.used[normal] = true;
+					}
+				}
+				if (q < end && !is_space(q, end))
+					return fail(c, line, "bad face index");
+				polygon.push_back(corner);
+				q = skip_spaces(q, end);
+			}
+
+			if (polygon.size() < 3)
+				return fail(c, line, "face with fewer than 3 vertices");
+			for (std::size_t k = 2; k < polygon.size(); ++k)
+			{
+				emit(c, polygon[0]);
+				emit(c, polygon[k - 1]);
+				emit(c, polygon[k]);
+			}
+		}
+	}
+	return true;
+}
+
+/** Line of the chunk, 1-based, of the face that emitted triangle corner k */
+std::size_t line_of_corner(const Chunk& c, std::size_t k)
+{
+	std::size_t line = 0;
+	std::size_t corners = 0;
+	for (const char* p = c.begin; p < c.end;)
+	{
+		++line;
+		const char* eol = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(c.end - p)));
+		if (!eol)
+			eol = c.end;
+		const char* q = skip_spaces(p, eol);
+		p = eol + 1;
+		if (eol - q < 2 || q[0] != 'f' || !is_space(q + 1, eol))
+			continue;
+
+		// the chunk parsed, so the face is well formed: one vertex per run of non-spaces
+		std::size_t vertices = 0;
+		for (q = skip_spaces(q + 1, eol); q < eol && *q != '\r'; q = skip_spaces(q, eol))
+		{
+			++vertices;
+			while (q < eol && *q != ' ' && *q != '\t' && *q != '\r')
+				++q;
+		}
+		corners += 3 * (vertices - 2);
+		if (k < corners)
+			return line;
+	}
+	return line;
+}
+
+/** Splits text at the first newline after every chunk_size bytes */
+std::vector<Chunk> cut(std::string_view text, std::size_t chunk_size)
+{
+	std::vector<Chunk> chunks;
+	const char* p = text.data();
+	const char* end = p + text.size();
+	while (p < end)
+	{
+		const char* next = end;
+		if (static_cast<std::size_t>(end - p) > chunk_size)
+		{
+			const void* nl = std::memchr(p + chunk_size, '\n', static_cast<std::size_t>(end - p) - chunk_size);
+			if (nl)
+				next = static_cast<const char*>(nl) + 1;
+		}
+		Chunk& c = chunks.emplace_back();
+		c.begin = p;
+		c.end = next;
+		p = next;
+	}
+	return chunks;
+}
+
+template <typename T>
+void append_at(std::vector<T>& dst, std::size_t at, const std::vector<T>& src)
+{
+	std::copy(src.begin(), src.end(), dst.begin() + static_cast<std::ptrdiff_t>(at));
+}
+
+#if !defined(_WIN32)
+/** Read-only private mapping of a whole file */
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile()
+	{
+		if (_data)
+			::munmap(_data, _size);
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	Result	open(const std::string& path)
+	{
+		int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+			return Result::error("OBJ: cannot open " + path + ": " + std::strerror(errno));
+
+		struct stat st;
+		if (::fstat(fd, &st) != 0)
+		{
+			int err = errno;
+			::close(fd);
+			return Result::error("OBJ: cannot stat " + path + ": " + std::strerror(err));
+		}
+
+		_size = static_cast<std::size_t>(st.st_size);
+		if (_size > 0)
+		{
+			void* data = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (data == MAP_FAILED)
+			{
+				int err = errno;
+				::close(fd);
+				return Result::error("OBJ: cannot map " + path + ": " + std::strerror(err));
+			}
+			_data = data;
+			// the chunks are read in parallel, start reading the whole file ahead
+			::madvise(_data, _size, MADV_WILLNEED);
+		}
+		::close(fd);
+		return Result::ok();
+	}
+
+	std::string_view	text() const { return {static_cast<const char*>(_data), _data ? _size : 0}; }
+
+private:
+	void*		_data = nullptr;
+	std::size_t	_size = 0;
+};
+#endif
+
+}
+
+void Mesh::clear()
+{
+	positions.clear();
+	normals.clear();
+	texcoords.clear();
+	indices.clear();
+	texcoord_indices.clear();
+	normal_indices.clear();
+}
+
+Result parse_obj(std::string_view text, Mesh& out, const ObjOptions& options)
+{
+	out.clear();
+
+	std::vector<Chunk> chunks = cut(text, std::max<std::size_t>(options.chunk_size, 1));
+	auto parse_range = [&](std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i)
+			parse_chunk(chunks[i]);
+	};
+	if (options.parallel)
+		cu::parallel::for_chunks(chunks.size(), 1, parse_range);
+	else
+		parse_range(0, chunks.size());
+
+	// first error in file order, line numbers are only counted on this path
+	for (const Chunk& c : chunks)
+		if (!c.error.empty())
+		{
+			std::size_t line = c.error_line + static_cast<std::size_t>(std::count(text.data(), c.begin, '\n'));
+			return Result::error("OBJ: line " + std::to_string(line) + ": " + c.error);
+		}
+
+	// where each chunk's data starts in the mesh
+	struct Offsets { std::size_t position, texcoord, normal, corner; };
+	std::vector<Offsets> at(chunks.size() + 1, Offsets{0, 0, 0, 0});
+	bool used[3] = {true, false, false};
+	for (std::size_t i = 0; i < chunks.size(); ++i)
+	{
+		const Chunk& c = chunks[i];
+		at[i + 1] = {at[i].position + c.positions.size(), at[i].texcoord + c.texcoords.size(), at[i].normal + c.normals.size(), at[i].corner + c.index[position].size()};
+		used[texcoord] |= c.used[texcoord];
+		used[normal] |= c.used[normal];
+	}
+
+	const Offsets& total = at.back();
+	if (total.corner > Mesh::no_index || total.position > Mesh::no_index || total.texcoord > Mesh::no_index || total.normal > Mesh::no_index)
+		return Result::error("OBJ: more than 2^32 vertices or face corners");
+
+	out.positions.resize(total.position);
+	out.texcoords.resize(total.texcoord);
+	out.normals.resize(total.normal);
+	out.indices.resize(total.corner);
+	if (used[texcoord])
+		out.texcoord_indices.resize(total.corner);
+	if (used[normal])
+		out.normal_indices.resize(total.corner);
+
+	std::vector<std::uint32_t*>	streams = {out.indices.data(), out.texcoord_indices.data(), out.normal_indices.data()};
+	const std::size_t			counts[3] = {total.position, total.texcoord, total.normal};
+	std::vector<std::size_t>	bad(chunks.size(), none);	// first corner with an index out of range
+
+	auto stitch_range = [&](std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			const Chunk&	c = chunks[i];
+			const Offsets&	o = at[i];
+			append_at(out.positions, o.position, c.positions);
+			append_at(out.texcoords, o.texcoord, c.texcoords);
+			append_at(out.normals, o.normal, c.normals);
+
+			const std::size_t base[3] = {o.position, o.texcoord, o.normal};
+			for (int a = 0; a < 3; ++a)
+			{
+				if (!used[a])
+					continue;
+				std::uint32_t* dst = streams[a] + o.corner;
+				std::copy(c.index[a].begin(), c.index[a].end(), dst);
+				for (std::size_t r : c.relative[a])
+					dst[r] += static_cast<std::uint32_t>(base[a]);
+				// every index the face gave, a relative one past the start wraps to anything, no_index included
+				for (std::size_t k = 0; k < c.index[a].size() && k < bad[i]; ++k)
+					if ((c.given[k] >> a & 1) && dst[k] >= counts[a])
+						bad[i] = k;
+			}
+		}
+	};
+	if (options.parallel)
+		cu::parallel::for_chunks(chunks.size(), 1, stitch_range);
+	else
+		stitch_range(0, chunks.size());
+
+	for (std::size_t i = 0; i < chunks.size(); ++i)
+		if (bad[i] != none)
+		{
+			std::size_t line = line_of_corner(chunks[i], bad[i]) + static_cast<std::size_t>(std::count(text.data(), chunks[i].begin, '\n'));
+			out.clear();
+			return Result::error("OBJ: line " + std::to_string(line) + ": face index out of range");
+		}
+	return Result::ok();
+}
+
+Result load_obj(const std::string& path, Mesh& out, const ObjOptions& options)
+{
+#if defined(_WIN32)
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return Result::error("OBJ: cannot open " + path);
+	std::ostringstream buffer;
+	buffer << file.rdbuf();
+	std::string text = std::move(buffer).str();
+	return parse_obj(text, out, options);
+#else
+	MappedFile file;
+	Result r = file.open(path);
+	if (!r.isOk())
+		return r;
+	return parse_obj(file.text(), out, options);
+#endif
+}
+
+}
@@ -0,0 +1,354 @@
+#include "scene/transform_graph.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+namespace cu::scene {
+
+using math::mat4;
+using math::quat;
+using math::vec3;
+
+namespace {
+
+constexpr std::size_t parallel_min_nodes = 4096;
+constexpr std::size_t parallel_min_chunk = 1024;
+
+/**
+ * S * R * T in the mul_vec layout, the transpose of translate(scale(toMatrix())): row j
+ * is column j of the rotation scaled by s[j], which is row j of the conjugate's matrix
+ */
+inline mat4 local_matrix(const vec3& t, const quat& r, const vec3& s)
+{
+	mat4 m = r.conjugate().toMatrix();
+#if defined(__SSE__)
+	m.row[0] = _mm_mul_ps(m.row[0], _mm_set1_ps(s.x));
+	m.row[1] = _mm_mul_ps(m.row[1], _mm_set1_ps(s.y));
+	m.row[2] = _mm_mul_ps(m.row[2], _mm_set1_ps(s.z));
+	m.row[3] = _mm_setr_ps(t.x, t.y, t.z, 1.0f);
+#else
+	for (int j = 0; j < 3; ++j)
+	{
+		for (int i = 0; i < 3; ++i)
+			m.m[j][i] *= s[j];
+		m.m[3][j] = t[j];
+	}
+#endif
+	return m;
+}
+
+template <typename T>
+void permute(std::vector<T>& v, const std::vector<std::uint32_t>& order)
+{
+	std::vector<T> r;
+	r.reserve(order.size());
+	for (std::uint32_t s : order)
+		r.push_back(v[s]);
+	v = std::move(r);
+}
+
+}
+
+TransformGraph::node TransformGraph::add(node parent, const vec3& translation, const quat& rotation, const vec3& scale)
+{
+	if (parent != invalid && !contains(parent))
+		return invalid;
+
+	node id;
+	if (!_free.empty())
+	{
+		id = _free.back();
+		_free.pop_back();
+	}
+	else
+	{
+		id = static_cast<node>(_slot_of.size());
+		_slot_of.push_back(invalid);
+	}
+
+	// appended out of level order, rebuild_layout() puts it in place
+	std::uint32_t slot = static_cast<std::uint32_t>(_id.size());
+	_translation.push_back(translation);
+	_rotation.push_back(rotation);
+	_scale.push_back(scale);
+	_world.push_back(mat4(1.0f));
+	_parent.push_back(parent == invalid ? invalid : _slot_of[parent]);
+	_id.push_back(id);
+	_dirty.push_back(0);
+
+	_slot_of[id] = slot;
+	_layout_dirty = true;
+	mark_dirty(slot);
+	return id;
+}
+
+Result TransformGraph::remove(node n)
+{
+	if (!contains(n))
+		return Result::error("TransformGraph: remove of unknown node " + std::to_string(n));
+
+	if (_layout_dirty)
+		rebuild_layout();
+
+	// the subtree is one contiguous range per level
+	std::uint32_t first = _slot_of[n];
+	std::uint32_t last = first + 1;
+	while (first < last)
+	{
+		for (std::uint32_t s = first; s < last; ++s)
+		{
+			_slot_of[_id[s]] = invalid;
+			_free.push_back(_id[s]);
+			_id[s] = invalid;
+		}
+		first = _child_begin[first];
+		last = _child_begin[last];
+	}
+
+	_layout_dirty = true;
+	return Result::ok();
+}
+
+Result TransformGraph::set_parent(node n, node parent)
+{
+	if (!contains(n))
+		return Result::error("TransformGraph: set_parent of unknown node " + std::to_string(n));
+	if (parent != invalid && !contains(parent))
+		return Result::error("TransformGraph: set_parent to unknown node " + std::to_string(parent));
+
+	std::uint32_t slot = _slot_of[n];
+	std::uint32_t parent_slot = parent == invalid ? invalid : _slot_of[parent];
+	for (std::uint32_t s = parent_slot; s != invalid; s = _parent[s])
+		if (s == slot)
+			return Result::error("TransformGraph: node " + std::to_string(parent) + " is in the subtree of " + std::to_string(n));
+
+	if (_parent[slot] != parent_slot)
+	{
+		_parent[slot] = parent_slot;
+		_layout_dirty = true;
+		mark_dirty(slot);
+	}
+	return Result::ok();
+}
+
+void TransformGraph::set_translation(node n, const vec3& translation)
+{
+	std::uint32_t slot = _slot_of[n];
+	_translation[slot] = translation;
+	mark_dirty(slot);
+}
+
+void TransformGraph::set_rotation(node n, const quat& rotation)
+{
+	std::uint32_t slot = _slot_of[n];
+	_rotation[slot] = rotation;
+	mark_dirty(slot);
+}
+
+void TransformGraph::set_scale(node n, const vec3& scale)
+{
+	std::uint32_t slot = _slot_of[n];
+	_scale[slot] = scale;
+	mark_dirty(slot);
+}
+
+void TransformGraph::set_local(node n, const vec3& translation, const quat& rotation, const vec3& scale)
+{
+	std::uint32_t slot = _slot_of[n];
+	_translation[slot] = translation;
+	_rotation[slot] = rotation;
+	_scale[slot] = scale;
+	mark_dirty(slot);
+}
+
+void TransformGraph::mark_dirty(std::uint32_t slot)
+{
+	if (_dirty[slot])
+		return;
+	_dirty[slot] = 1;
+	_dirty_nodes.push_back(_id[slot]);
+}
+
+/**
+ * Breadth-first order from the roots, children grouped under their parent in parent
+ * order: that keeps every subtree contiguous on each level. Removed slots are dropped
+ */
+void TransformGraph::rebuild_layout()
+{
+	const std::uint32_t count = static_cast<std::uint32_t>(_id.size());
+
+	// children of every slot, counting sort on the parent
+	std::vector<std::uint32_t> offsets(count + 1, 0);
+	std::vector<std::uint32_t> order;
+	order.reserve(size());
+	for (std::uint32_t s = 0; s < count; ++s)
+	{
+		if (_id[s] == invalid)
+			continue;
+		if (_parent[s] == invalid)
+			order.push_back(s);
+		else
+			++offsets[_parent[s] + 1];
+	}
+	for (std::uint32_t s = 0; s < count; ++s)
+		offsets[s + 1] += offsets[s];
+
+	std::vector<std::uint32_t> children(offsets[count]);
+	std::vector<std::uint32_t> fill(offsets.begin(), offsets.end() - 1);
+	for (std::uint32_t s = 0; s < count; ++s)
+		if (_id[s] != invalid && _parent[s] != invalid)
+			children[fill[_parent[s]]++] = s;
+
+	_level_begin.assign(1, 0);
+	std::size_t begin = 0;
+	while (begin < order.size())
+	{
+		std::size_t end = order.size();
+		_level_begin.push_back(static_cast<std::uint32_t>(end));
+		for (std::size_t i = begin; i < end; ++i)
+			order.insert(order.end(), children.begin() + offsets[order[i]], children.begin() + offsets[order[i] + 1]);
+		begin = end;
+	}
+
+	std::vector<std::uint32_t> remap(count, invalid);
+	for (std::uint32_t i = 0; i < order.size(); ++i)
+		remap[order[i]] = i;
+
+	const std::uint32_t live = static_cast<std::uint32_t>(order.size());
+	_child_begin.resize(live + 1);
+	_child_begin[0] = _level_begin.size() > 1 ? _level_begin[1] : 0;
+	for (std::uint32_t i = 0; i < live; ++i)
+		_child_begin[i + 1] = _child_begin[i] + (offsets[order[i] + 1] - offsets[order[i]]);
+
+	std::vector<std::uint32_t> parent(live);
+	for (std::uint32_t i = 0; i < live; ++i)
+		parent[i] = _parent[order[i]] == invalid ? invalid : remap[_parent[order[i]]];
+	_parent = std::move(parent);
+
+	permute(_translation, order);
+	permute(_rotation, order);
+	permute(_scale, order);
+	permute(_world, order);
+	permute(_id, order);
+	permute(_dirty, order);
+
+	for (std::uint32_t i = 0; i < live; ++i)
+		_slot_of[_id[i]] = i;
+	_layout_dirty = false;
+}
+
+void TransformGraph::update_range(std::uint32_t first, std::uint32_t last)
+{
+	for (std::uint32_t s = first; s < last; ++s)
+	{
+		mat4 local = local_matrix(_translation[s], _rotation[s], _scale[s]);
+		_world[s] = _parent[s] == invalid ? local : local * _world[_parent[s]];
+	}
+}
+
+/**
+ * Level by level: the ranges to recompute are the children of the previous level's
+ * ranges plus the nodes changed on this level, merged. Parents are always on an earlier
+ * level so their matrix is final when the children read it
+ */
+std::size_t TransformGraph::update(bool parallel)
+{
+	if (_layout_dirty)
+		rebuild_layout();
+	if (_dirty_nodes.empty())
+		return 0;
+
+	// dirty slots in slot order: sort the few, scan the flags when there are many
+	std::vector<std::uint32_t> seeds;
+	seeds.reserve(_dirty_nodes.size());
+	if (_dirty_nodes.size() * 16 >= _id.size())
+	{
+		for (std::uint32_t s = 0; s < _id.size(); ++s)
+			if (_dirty[s])
+			{
+				seeds.push_back(s);
+				_dirty[s] = 0;
+			}
+	}
+	else
+	{
+		for (node n : _dirty_nodes)
+		{
+			if (!contains(n))
+				continue;
+			seeds.push_back(_slot_of[n]);
+			_dirty[_slot_of[n]] = 0;
+		}
+		std::sort(seeds.begin(), seeds.end());
+	}
+	_dirty_nodes.clear();
+
+	using range = std::pair<std::uint32_t, std::uint32_t>;
+	std::vector<range> inherited, ranges;
+	std::vector<std::size_t> prefix;
+	std::size_t updated = 0;
+	auto seed = seeds.begin();
+
+	for (std::size_t level = 0; level + 1 < _level_begin.size(); ++level)
+	{
+		const std::uint32_t level_end = _level_begin[level + 1];
+		if (inherited.empty() && (seed == seeds.end() || *seed >= level_end))
+		{
+			if (seed == seeds.end())
+				break;
+			continue;
+		}
+
+		// merge both sorted lists, joining ranges that overlap or touch
+		ranges.clear();
+		auto add = [&](range r) {
+			if (!ranges.empty() && r.first <= ranges.back().second)
+				ranges.back().second = std::max(ranges.back().second, r.second);
+			else
+				ranges.push_back(r);
+		};
+		auto in = inherited.begin();
+		while (in != inherited.end() || (seed != seeds.end() && *seed < level_end))
+		{
+			if (seed == seeds.end() || *seed >= level_end || (in != inherited.end() && in->first <= *seed))
+				add(*in++);
+			else
+				add({*seed, *seed + 1}), ++seed;
+		}
+
+		prefix.assign(1, 0);
+		for (const range& r : ranges)
+			prefix.push_back(prefix.back() + (r.second - r.first));
+		const std::size_t total = prefix.back();
+
+		if (parallel && total >= parallel_min_nodes)
+		{
+			parallel::for_chunks(total, parallel_min_chunk, [&](std::size_t begin, std::size_t end) {
+				std::size_t i = std::upper_bound(prefix.begin(), prefix.end(), begin) - prefix.begin() - 1;
+				for (; i < ranges.size() && prefix[i] < end; ++i)
+				{
+					std::size_t lo = std::max(begin, prefix[i]) - prefix[i];
+					std::size_t hi = std::min(end, prefix[i + 1]) - prefix[i];
+					update_range(ranges[i].first + static_cast<std::uint32_t>(lo), ranges[i].first + static_cast<std::uint32_t>(hi));
+				}
+			});
+		}
+		else
+		{
+			for (const range& r : ranges)
+				update_range(r.first, r.second);
+		}
+		updated += total;
+
+		inherited.clear();
+		for (const range& r : ranges)
+			if (_child_begin[r.first] < _child_begin[r.second])
+				inherited.push_back({_child_begin[r.first], _child_begin[r.second]});
+	}
+
+	return updated;
+}
+
+}
@@ -0,0 +1,64 @@
+#include "spatial/hash_grid.hpp"
+#include "spatial/radix_sort.hpp"
+#include "parallel.hpp"
+
+#include <bit>
+#include <numeric>
+
+namespace cu::spatial {
+
+using math::vec3;
+
+namespace {
+
+constexpr std::size_t parallel_min_chunk = 16384;
+
+}
+
+/** Buckets of every point, radix sort by bucket, then one pass for the bucket ranges */
+void HashGrid::build(std::span<const vec3> points, float cell_size, bool parallel)
+{
+	_cell_size = cell_size;
+	_inv_cell_size = 1.0f / cell_size;
+
+	const std::size_t n = points.size();
+	const std::uint32_t table = std::bit_ceil(static_cast<std::uint32_t>(std::max<std::size_t>(2 * n, 2)));
+	_mask = table - 1;
+
+	std::vector<std::uint32_t> keys(n);
+	_indices.resize(n);
+	std::iota(_indices.begin(), _indices.end(), 0u);
+
+	auto hash_range = [&](std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			cell c = cell_of(points[i]);
+			keys[i] = bucket(c.x, c.y, c.z);
+		}
+	};
+	if (parallel && n >= 2 * parallel_min_chunk)
+		cu::parallel::for_chunks(n, parallel_min_chunk, hash_range);
+	else
+		hash_range(0, n);
+
+	radix_sort<std::uint32_t>(keys, _indices, parallel);
+
+	_points.resize(n);
+	_bucket_begin.assign(std::size_t(table) + 1, 0);
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		_points[i] = points[_indices[i]];
+		++_bucket_begin[keys[i] + 1];
+	}
+	for (std::uint32_t b = 0; b < table; ++b)
+		_bucket_begin[b + 1] += _bucket_begin[b];
+}
+
+std::size_t HashGrid::query(const vec3& center, float radius, std::vector<std::uint32_t>& out) const
+{
+	std::size_t before = out.size();
+	query(center, radius, [&out](std::uint32_t index, float) { out.push_back(index); });
+	return out.size() - before;
+}
+
+}
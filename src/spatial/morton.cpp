@@ -0,0 +1,151 @@
+#include "spatial/morton.hpp"
+#include "spatial/radix_sort.hpp"
+#include "cpu.hpp"
+#include "parallel.hpp"
+
+#include <cassert>
+#include <numeric>
+
+#if CU_HAS_TARGET_BMI2 && !defined(__BMI2__) && defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace cu::spatial {
+
+using math::aabb;
+using math::vec3;
+
+namespace {
+
+constexpr std::size_t parallel_min_chunk = 16384;
+
+template <typename Key>
+constexpr int bits_per_axis = std::is_same_v<Key, std::uint32_t> ? 10 : 21;
+
+/** Grid coordinates, NaN and everything below bounds.min go to 0 */
+struct quantizer
+{
+	vec3	origin;
+	vec3	scale;
+	float	top;
+
+	quantizer(const aabb& bounds, int bits)
+	{
+		const float cells = static_cast<float>(1u << bits);
+		vec3 extent = bounds.max - bounds.min;
+		origin = bounds.min;
+		scale = vec3(extent.x > 0.0f ? cells / extent.x : 0.0f, extent.y > 0.0f ? cells / extent.y : 0.0f, extent.z > 0.0f ? cells / extent.z : 0.0f);
+		top = cells - 1.0f;
+	}
+
+	inline std::uint32_t axis(float v, float o, float s) const
+	{
+		float f = (v - o) * s;
+		f = f > 0.0f ? f : 0.0f;
+		f = f < top ? f : top;
+		return static_cast<std::uint32_t>(f);
+	}
+
+	inline void operator()(const vec3& p, std::uint32_t& x, std::uint32_t& y, std::uint32_t& z) const
+	{
+		x = axis(p.x, origin.x, scale.x);
+		y = axis(p.y, origin.y, scale.y);
+		z = axis(p.z, origin.z, scale.z);
+	}
+};
+
+template <typename Key>
+void encode_range(const quantizer& q, const vec3* points, Key* keys, std::size_t n)
+{
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		std::uint32_t x, y, z;
+		q(points[i], x, y, z);
+		if constexpr (std::is_same_v<Key, std::uint32_t>)
+			keys[i] = morton30(x, y, z);
+		else
+			keys[i] = morton63(x, y, z);
+	}
+}
+
+#if CU_HAS_TARGET_BMI2 && !defined(__BMI2__) && defined(__x86_64__)
+template <typename Key>
+CU_TARGET_BMI2 void encode_range_bmi2(const quantizer& q, const vec3* points, Key* keys, std::size_t n)
+{
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		std::uint32_t x, y, z;
+		q(points[i], x, y, z);
+		if constexpr (std::is_same_v<Key, std::uint32_t>)
+			keys[i] = _pdep_u32(x, detail::morton30_mask) | _pdep_u32(y, detail::morton30_mask << 1) | _pdep_u32(z, detail::morton30_mask << 2);
+		else
+			keys[i] = _pdep_u64(x, detail::morton63_mask) | _pdep_u64(y, detail::morton63_mask << 1) | _pdep_u64(z, detail::morton63_mask << 2);
+	}
+}
+#endif
+
+template <typename Key>
+void encode(const quantizer& q, const vec3* points, Key* keys, std::size_t n)
+{
+#if CU_HAS_TARGET_BMI2 && !defined(__BMI2__) && defined(__x86_64__)
+	if (cpu::current().fast_pdep)
+	{
+		encode_range_bmi2(q, points, keys, n);
+		return;
+	}
+#endif
+	encode_range(q, points, keys, n);
+}
+
+aabb bounds_of(std::span<const vec3> points)
+{
+	aabb b;
+	for (const vec3& p : points)
+		b.expand(p);
+	return b;
+}
+
+}
+
+template <typename Key>
+void morton_keys(std::span<const vec3> points, const aabb& bounds, std::span<Key> keys, bool parallel)
+{
+	assert(points.size() == keys.size());
+
+	const quantizer q(bounds, bits_per_axis<Key>);
+	if (!parallel || points.size() < 2 * parallel_min_chunk)
+	{
+		encode(q, points.data(), keys.data(), points.size());
+		return;
+	}
+
+	cu::parallel::for_chunks(points.size(), parallel_min_chunk, [&](std::size_t begin, std::size_t end) {
+		encode(q, points.data() + begin, keys.data() + begin, end - begin);
+	});
+}
+
+template <typename Key>
+std::vector<std::uint32_t> morton_order(std::span<const vec3> points, bool parallel)
+{
+	return morton_order<Key>(points, bounds_of(points), parallel);
+}
+
+template <typename Key>
+std::vector<std::uint32_t> morton_order(std::span<const vec3> points, const aabb& bounds, bool parallel)
+{
+	std::vector<Key> keys(points.size());
+	std::vector<std::uint32_t> order(points.size());
+	morton_keys<Key>(points, bounds, keys, parallel);
+	std::iota(order.begin(), order.end(), 0u);
+	radix_sort<Key>(keys, order, parallel);
+	return order;
+}
+
+template void morton_keys<std::uint32_t>(std::span<const vec3>, const aabb&, std::span<std::uint32_t>, bool);
+template void morton_keys<std::uint64_t>(std::span<const vec3>, const aabb&, std::span<std::uint64_t>, bool);
+template std::vector<std::uint32_t> morton_order<std::uint32_t>(std::span<const vec3>, bool);
+template std::vector<std::uint32_t> morton_order<std::uint64_t>(std::span<const vec3>, bool);
+template std::vector<std::uint32_t> morton_order<std::uint32_t>(std::span<const vec3>, const aabb&, bool);
+template std::vector<std::uint32_t> morton_order<std::uint64_t>(std::span<const vec3>, const aabb&, bool);
+
+}
@@ -0,0 +1,122 @@
+#include "spatial/radix_sort.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <vector>
+
+namespace cu::spatial {
+
+namespace {
+
+constexpr std::size_t parallel_min_chunk = 65536;
+
+using histogram = std::array<std::uint32_t, 256>;
+
+template <typename Key>
+inline std::uint32_t digit(Key k, int pass) { return static_cast<std::uint32_t>(k >> (8 * pass)) & 0xff; }
+
+}
+
+template <typename Key>
+void radix_sort(std::span<Key> keys, std::span<std::uint32_t> values, bool parallel)
+{
+	assert(keys.size() == values.size());
+
+	constexpr int passes = static_cast<int>(sizeof(Key));
+	const std::size_t n = keys.size();
+	if (n < 2)
+		return;
+
+	const std::size_t chunks = parallel && n >= 2 * parallel_min_chunk
+		? std::min<std::size_t>(cu::parallel::thread_count(), n / parallel_min_chunk) : 1;
+	const std::size_t step = (n + chunks - 1) / chunks;
+
+	auto for_each_chunk = [&](auto&& fn) {
+		if (chunks == 1)
+			fn(std::size_t(0), std::size_t(0), n);
+		else
+			cu::parallel::for_chunks(chunks, 1, [&](std::size_t begin, std::size_t end) {
+				for (std::size_t c = begin; c < end; ++c)
+					fn(c, c * step, std::min(n, (c + 1) * step));
+			});
+	};
+
+	// every digit of every pass in one read, to find the passes that would not move anything
+	std::vector<std::array<histogram, passes>> counts(chunks);
+	for_each_chunk([&](std::size_t c, std::size_t first, std::size_t last) {
+		auto& h = counts[c];
+		for (auto& p : h)
+			p.fill(0);
+		for (std::size_t i = first; i < last; ++i)
+			for (int p = 0; p < passes; ++p)
+				++h[p][digit(keys[i], p)];
+	});
+
+	std::vector<Key> key_buffer(n);
+	std::vector<std::uint32_t> value_buffer(n);
+	Key* src_keys = keys.data();
+	Key* dst_keys = key_buffer.data();
+	std::uint32_t* src_values = values.data();
+	std::uint32_t* dst_values = value_buffer.data();
+
+	std::vector<histogram> offsets(chunks);
+	bool moved = false;
+
+	for (int p = 0; p < passes; ++p)
+	{
+		bool trivial = false;
+		for (int d = 0; d < 256 && !trivial; ++d)
+		{
+			std::size_t total = 0;
+			for (std::size_t c = 0; c < chunks; ++c)
+				total += counts[c][p][d];
+			trivial = total == n;
+		}
+		if (trivial)
+			continue;
+
+		// counts are per position range, they only hold until the first scatter
+		if (moved)
+			for_each_chunk([&](std::size_t c, std::size_t first, std::size_t last) {
+				histogram& h = counts[c][p];
+				h.fill(0);
+				for (std::size_t i = first; i < last; ++i)
+					++h[digit(src_keys[i], p)];
+			});
+
+		std::uint32_t running = 0;
+		for (int d = 0; d < 256; ++d)
+			for (std::size_t c = 0; c < chunks; ++c)
+			{
+				offsets[c][d] = running;
+				running += counts[c][p][d];
+			}
+
+		for_each_chunk([&](std::size_t c, std::size_t first, std::size_t last) {
+			histogram& o = offsets[c];
+			for (std::size_t i = first; i < last; ++i)
+			{
+				std::uint32_t at = o[digit(src_keys[i], p)]++;
+				dst_keys[at] = src_keys[i];
+				dst_values[at] = src_values[i];
+			}
+		});
+
+		std::swap(src_keys, dst_keys);
+		std::swap(src_values, dst_values);
+		moved = true;
+	}
+
+	if (src_keys != keys.data())
+	{
+		std::copy_n(src_keys, n, keys.data());
+		std::copy_n(src_values, n, values.data());
+	}
+}
+
+template void radix_sort<std::uint32_t>(std::span<std::uint32_t>, std::span<std::uint32_t>, bool);
+template void radix_sort<std::uint64_t>(std::span<std::uint64_t>, std::span<std::uint32_t>, bool);
+
+}
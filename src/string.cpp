@@ -1,32 +1,41 @@
+#include <memory_resource>
 #include <vector>
 #include <string>
 
+#include "string/split.hpp"
+
 namespace cu::string
 {
 
+std::size_t split(std::string_view str, char sep, std::vector<std::string_view>& out)
+{
+	out.clear();
+	for (std::string_view token : split_view(str, sep))
+		out.push_back(token);
+	return out.size();
+}
+
+std::size_t split(std::string_view str, char sep, std::pmr::vector<std::string_view>& out)
+{
+	out.clear();
+	for (std::string_view token : split_view(str, sep))
+		out.push_back(token);
+	return out.size();
+}
+
 std::vector<std::string> split(const std::string& str, char sep)
 {
 	std::vector<std::string> result;
-	size_t start = 0;
-	size_t i;
-
-	for (i = 0; i < str.size(); ++i)
-	{
-		if (str[i] == sep)
-		{
-			if (i - start > 0)
-			{
-				std::string	res = str.substr(start, i - start);
-				if (res.length())
-					result.push_back(res);
-			}
-			start = i + 1;
-		}
-	}
+	for (std::string_view token : split_view(str, sep))
+		result.emplace_back(token);
+	return result;
+}
 
-	std::string	res = str.substr(start);
-	if (res.length())
-		result.push_back(res);
+std::pmr::vector<std::pmr::string> split(std::string_view str, char sep, std::pmr::memory_resource* resource)
+{
+	std::pmr::vector<std::pmr::string> result(resource);
+	for (std::string_view token : split_view(str, sep))
+		result.emplace_back(token);
 	return result;
 }
 
@@ -0,0 +1,228 @@
+#include "string/interner.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace cu::string
+{
+
+namespace {
+
+constexpr std::size_t	shard_bits = 4;
+constexpr std::size_t	shard_count = std::size_t(1) << shard_bits;
+constexpr std::size_t	first_capacity = 64;			// slots per shard table, a power of two
+constexpr std::size_t	block_size = 64 << 10;			// arena block, longer strings get their own
+
+/**
+ * 64 bit string hash, 8 bytes per multiply then the murmur3 finalizer
+ * https://github.com/aappleby/smhasher/blob/master/src/MurmurHash3.cpp
+ * The tail is read with fixed-size loads that may overlap bytes already hashed, a
+ * memcpy of a variable size would be a library call
+ */
+inline std::uint64_t hash(std::string_view str)
+{
+	constexpr std::uint64_t k = 0xff51afd7ed558ccdull;
+
+	const char*		p = str.data();
+	std::size_t		n = str.size();
+	std::uint64_t	h = 0x9e3779b97f4a7c15ull ^ n;
+	std::uint64_t	w = 0;
+	if (n >= 8)
+	{
+		for (; n > 8; p += 8, n -= 8)
+		{
+			std::memcpy(&w, p, 8);
+			h = (h ^ w) * k;
+			h ^= h >> 32;
+		}
+		std::memcpy(&w, p + n - 8, 8);
+	}
+	else if (n >= 4)
+	{
+		std::uint32_t a, b;
+		std::memcpy(&a, p, 4);
+		std::memcpy(&b, p + n - 4, 4);
+		w = a | std::uint64_t(b) << 32;
+	}
+	else if (n > 0)
+		w = std::uint64_t(std::uint8_t(p[0])) | std::uint64_t(std::uint8_t(p[n / 2])) << 8 | std::uint64_t(std::uint8_t(p[n - 1])) << 16;
+	h = (h ^ w) * k;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ull;
+	h ^= h >> 33;
+	return h;
+}
+
+/**
+ * Open addressing, linear probing. A slot is 0 (empty) or tag << 32 | (id + 1) with
+ * tag the high half of the hash, which also picks the first slot: growing rehashes
+ * from the slots alone. Slots only go from empty to full, so readers need no lock
+ */
+struct Table
+{
+	explicit Table(std::size_t capacity) : mask(capacity - 1), slots(new std::atomic<std::uint64_t>[capacity])
+	{
+		for (std::size_t i = 0; i < capacity; ++i)
+			slots[i].store(0, std::memory_order_relaxed);
+	}
+
+	std::size_t										mask;
+	std::unique_ptr<std::atomic<std::uint64_t>[]>	slots;
+};
+
+inline std::uint32_t tag(std::uint64_t hash) { return static_cast<std::uint32_t>(hash >> 32); }
+
+}
+
+struct Interner::Shard
+{
+	alignas(64) std::atomic<const Table*>	table{nullptr};
+
+	std::mutex							mutex;
+	std::size_t							used = 0;
+	std::vector<std::unique_ptr<Table>>	tables;		// the current one last, older ones may still be read
+	std::vector<std::unique_ptr<char[]>>	blocks;
+	char*								cursor = nullptr;
+	std::size_t							left = 0;
+
+	/** id + 1 of str, 0 when absent */
+	std::uint32_t	find(const Interner& interner, std::uint64_t hash, std::string_view str) const
+	{
+		const Table*	t = table.load(std::memory_order_acquire);
+		std::uint32_t	h = tag(hash);
+		for (std::size_t i = h & t->mask;; i = (i + 1) & t->mask)
+		{
+			std::uint64_t v = t->slots[i].load(std::memory_order_acquire);
+			if (v == 0)
+				return 0;
+			if (static_cast<std::uint32_t>(v >> 32) == h && interner.name({static_cast<std::uint32_t>(v) - 1}) == str)
+				return static_cast<std::uint32_t>(v);
+		}
+	}
+
+	/** Copy of str with a NUL after it, in the current block */
+	std::string_view	store(std::string_view str)
+	{
+		std::size_t size = str.size() + 1;
+		if (size > left)
+		{
+			std::size_t n = std::max(size, block_size);
+			blocks.push_back(std::make_unique<char[]>(n));
+			cursor = blocks.back().get();
+			left = n;
+		}
+		char* p = cursor;
+		std::memcpy(p, str.data(), str.size());
+		p[str.size()] = '\0';
+		cursor += size;
+		left -= size;
+		return {p, str.size()};
+	}
+
+	void	grow()
+	{
+		const Table*	old = table.load(std::memory_order_relaxed);
+		auto			next = std::make_unique<Table>((old->mask + 1) * 2);
+		for (std::size_t i = 0; i <= old->mask; ++i)
+		{
+			std::uint64_t v = old->slots[i].load(std::memory_order_relaxed);
+			if (v == 0)
+				continue;
+			std::size_t j = static_cast<std::uint32_t>(v >> 32) & next->mask;
+			while (next->slots[j].load(std::memory_order_relaxed) != 0)
+				j = (j + 1) & next->mask;
+			next->slots[j].store(v, std::memory_order_relaxed);
+		}
+		table.store(next.get(), std::memory_order_release);
+		tables.push_back(std::move(next));
+	}
+};
+
+Interner::Interner() : _shards(new Shard[shard_count])
+{
+	for (std::size_t i = 0; i < shard_count; ++i)
+	{
+		_shards[i].tables.push_back(std::make_unique<Table>(first_capacity));
+		_shards[i].table.store(_shards[i].tables.back().get(), std::memory_order_release);
+	}
+}
+
+Interner::~Interner()
+{
+	delete[] _shards;
+	for (auto& page : _pages)
+		delete[] page.load(std::memory_order_relaxed);
+}
+
+Symbol Interner::intern(std::string_view str)
+{
+	std::uint64_t	h = hash(str);
+	Shard&			shard = _shards[h & (shard_count - 1)];
+	if (std::uint32_t v = shard.find(*this, h, str))
+		return {v - 1};
+	return insert(shard, h, str);
+}
+
+Symbol Interner::find(std::string_view str) const
+{
+	std::uint64_t h = hash(str);
+	return {_shards[h & (shard_count - 1)].find(*this, h, str) - 1};
+}
+
+Symbol Interner::insert(Shard& shard, std::uint64_t h, std::string_view str)
+{
+	std::lock_guard lock(shard.mutex);
+
+	// another thread may have added it since the lock-free miss
+	if (std::uint32_t v = shard.find(*this, h, str))
+		return {v - 1};
+
+	if ((shard.used + 1) * 4 > (shard.table.load(std::memory_order_relaxed)->mask + 1) * 3)
+		shard.grow();
+
+	std::uint32_t id = _count.fetch_add(1, std::memory_order_relaxed);
+	set_name(id, shard.store(str));
+
+	// the name is written before the slot is published, a reader that sees the slot sees the name
+	const Table*	t = shard.table.load(std::memory_order_relaxed);
+	std::size_t		i = tag(h) & t->mask;
+	while (t->slots[i].load(std::memory_order_relaxed) != 0)
+		i = (i + 1) & t->mask;
+	t->slots[i].store(std::uint64_t(tag(h)) << 32 | (std::uint64_t(id) + 1), std::memory_order_release);
+	++shard.used;
+	return {id};
+}
+
+void Interner::set_name(std::uint32_t id, std::string_view str)
+{
+	std::uint64_t	n = std::uint64_t(id) + first_page_size;
+	int				page = std::bit_width(n) - 1 - first_page_bits;
+
+	std::string_view* entries = _pages[page].load(std::memory_order_acquire);
+	if (!entries)
+	{
+		// shards insert concurrently, the first to finish a new page installs it
+		std::string_view*	fresh = new std::string_view[first_page_size << page];
+		std::string_view*	expected = nullptr;
+		if (_pages[page].compare_exchange_strong(expected, fresh, std::memory_order_acq_rel))
+			entries = fresh;
+		else
+		{
+			delete[] fresh;
+			entries = expected;
+		}
+	}
+	entries[n - (first_page_size << page)] = str;
+}
+
+Interner& Interner::global()
+{
+	// never destroyed, symbols may still be looked up from static destructors
+	static Interner* i = new Interner;
+	return *i;
+}
+
+}
@@ -0,0 +1,323 @@
+#include "string/tokenizer.hpp"
+#include "cpu.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__SSE2__) || CU_MULTIVERSION
+#include <immintrin.h>
+#endif
+
+namespace cu::string
+{
+
+namespace {
+
+constexpr std::size_t block = 64;
+constexpr std::size_t chunk = 1 << 16;	// bytes classified per pass, the bitmap stays in L1
+
+/**
+ * Calls fn(std::integral_constant<std::size_t, K>) with K = d.size(), 1 .. max_simd,
+ * so the kernels below are unrolled over the delimiters
+ */
+template <typename Fn>
+decltype(auto) with_count(const Delimiters& d, Fn&& fn)
+{
+	switch (d.size())
+	{
+		case 1: return fn(std::integral_constant<std::size_t, 1>{});
+		case 2: return fn(std::integral_constant<std::size_t, 2>{});
+		case 3: return fn(std::integral_constant<std::size_t, 3>{});
+		case 4: return fn(std::integral_constant<std::size_t, 4>{});
+		case 5: return fn(std::integral_constant<std::size_t, 5>{});
+		case 6: return fn(std::integral_constant<std::size_t, 6>{});
+		case 7: return fn(std::integral_constant<std::size_t, 7>{});
+		default: return fn(std::integral_constant<std::size_t, 8>{});
+	}
+}
+
+/**
+ * classify: bitmap of the delimiters of p[0, n), bits[i / 64] bit i % 64; past n the
+ * bits are set, the input behaves as if followed by delimiters
+ * find: index of the first delimiter of p[0, n), n if none
+ */
+void classify_scalar(const char* p, std::size_t n, const Delimiters& d, std::uint64_t* bits)
+{
+	for (std::size_t i = 0; i < n; i += block)
+	{
+		std::size_t		count = std::min(block, n - i);
+		std::uint64_t	m = count < block ? ~std::uint64_t(0) << count : 0;
+		for (std::size_t j = 0; j < count; ++j)
+			m |= std::uint64_t(d.contains(p[i + j])) << j;
+		bits[i / block] = m;
+	}
+}
+
+std::size_t find_scalar(const char* p, std::size_t n, const Delimiters& d)
+{
+	for (std::size_t i = 0; i < n; ++i)
+		if (d.contains(p[i]))
+			return i;
+	return n;
+}
+
+#if defined(__SSE2__) && !defined(__AVX2__)
+/** One bit per byte of p[0, 64), set where it equals one of the K bytes of c */
+template <std::size_t K>
+inline std::uint64_t mask_sse2(const char* p, const __m128i (&c)[K])
+{
+	std::uint64_t m = 0;
+	for (std::size_t j = 0; j < block; j += 16)
+	{
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + j));
+		__m128i eq = _mm_cmpeq_epi8(v, c[0]);
+		for (std::size_t k = 1; k < K; ++k)
+			eq = _mm_or_si128(eq, _mm_cmpeq_epi8(v, c[k]));
+		m |= std::uint64_t(static_cast<std::uint32_t>(_mm_movemask_epi8(eq))) << j;
+	}
+	return m;
+}
+
+template <std::size_t K>
+void classify_sse2(const char* p, std::size_t n, const Delimiters& d, std::uint64_t* bits)
+{
+	__m128i c[K];
+	for (std::size_t k = 0; k < K; ++k)
+		c[k] = _mm_set1_epi8(d.chars()[k]);
+
+	std::size_t i = 0;
+	for (; i + block <= n; i += block)
+		bits[i / block] = mask_sse2(p + i, c);
+	if (i < n)
+	{
+		char tail[block];
+		std::memset(tail, d.chars()[0], block);
+		std::memcpy(tail, p + i, n - i);
+		bits[i / block] = mask_sse2(tail, c);
+	}
+}
+
+template <std::size_t K>
+std::size_t find_sse2(const char* p, std::size_t n, const Delimiters& d)
+{
+	__m128i c[K];
+	for (std::size_t k = 0; k < K; ++k)
+		c[k] = _mm_set1_epi8(d.chars()[k]);
+
+	std::size_t i = 0;
+	for (; i + block <= n; i += block)
+		if (std::uint64_t m = mask_sse2(p + i, c))
+			return i + static_cast<std::size_t>(std::countr_zero(m));
+	return i + find_scalar(p + i, n - i, d);
+}
+#endif
+
+#if defined(__AVX2__) || CU_MULTIVERSION
+template <std::size_t K>
+CU_TARGET_AVX2 inline std::uint64_t mask_avx2(const char* p, const __m256i (&c)[K])
+{
+	std::uint64_t m = 0;
+	for (std::size_t j = 0; j < block; j += 32)
+	{
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + j));
+		__m256i eq = _mm256_cmpeq_epi8(v, c[0]);
+		for (std::size_t k = 1; k < K; ++k)
+			eq = _mm256_or_si256(eq, _mm256_cmpeq_epi8(v, c[k]));
+		m |= std::uint64_t(static_cast<std::uint32_t>(_mm256_movemask_epi8(eq))) << j;
+	}
+	return m;
+}
+
+template <std::size_t K>
+CU_TARGET_AVX2 void classify_avx2(const char* p, std::size_t n, const Delimiters& d, std::uint64_t* bits)
+{
+	__m256i c[K];
+	for (std::size_t k = 0; k < K; ++k)
+		c[k] = _mm256_set1_epi8(d.chars()[k]);
+
+	std::size_t i = 0;
+	for (; i + block <= n; i += block)
+		bits[i / block] = mask_avx2(p + i, c);
+	if (i < n)
+	{
+		char tail[block];
+		std::memset(tail, d.chars()[0], block);
+		std::memcpy(tail, p + i, n - i);
+		bits[i / block] = mask_avx2(tail, c);
+	}
+}
+
+template <std::size_t K>
+CU_TARGET_AVX2 std::size_t find_avx2(const char* p, std::size_t n, const Delimiters& d)
+{
+	__m256i c[K];
+	for (std::size_t k = 0; k < K; ++k)
+		c[k] = _mm256_set1_epi8(d.chars()[k]);
+
+	std::size_t i = 0;
+	for (; i + block <= n; i += block)
+		if (std::uint64_t m = mask_avx2(p + i, c))
+			return i + static_cast<std::size_t>(std::countr_zero(m));
+	return i + find_scalar(p + i, n - i, d);
+}
+#endif
+
+/**
+ * K-unrolled kernels for a runtime delimiter count. Kept out of the multiversioned
+ * functions below: GCC mangles lambdas of both versions of one function to the same
+ * symbol
+ */
+#if defined(__SSE2__) && !defined(__AVX2__)
+void classify_sse2(const char* p, std::size_t n, const Delimiters& d, std::uint64_t* bits)
+{
+	with_count(d, [&](auto k) { classify_sse2<k>(p, n, d, bits); });
+}
+
+std::size_t find_sse2(const char* p, std::size_t n, const Delimiters& d)
+{
+	return with_count(d, [&](auto k) { return find_sse2<k>(p, n, d); });
+}
+#endif
+
+#if defined(__AVX2__) || CU_MULTIVERSION
+CU_TARGET_AVX2 void classify_avx2(const char* p, std::size_t n, const Delimiters& d, std::uint64_t* bits)
+{
+	with_count(d, [&](auto k) { classify_avx2<k>(p, n, d, bits); });
+}
+
+CU_TARGET_AVX2 std::size_t find_avx2(const char* p, std::size_t n, const Delimiters& d)
+{
+	return with_count(d, [&](auto k) { return find_avx2<k>(p, n, d); });
+}
+#endif
+
+/** Bound at load time to the AVX2 version when the CPU has it, see cpu.hpp */
+CU_TARGET_DEFAULT void classify(const char* p, std::size_t n, const Delimiters& d, std::uint64_t* bits)
+{
+	if (d.size() == 0 || d.size() > Delimiters::max_simd)
+		return classify_scalar(p, n, d, bits);
+#if defined(__AVX2__)
+	classify_avx2(p, n, d, bits);
+#elif defined(__SSE2__)
+	classify_sse2(p, n, d, bits);
+#else
+	classify_scalar(p, n, d, bits);
+#endif
+}
+
+CU_TARGET_DEFAULT std::size_t find(const char* p, std::size_t n, const Delimiters& d)
+{
+	if (d.size() == 0 || d.size() > Delimiters::max_simd)
+		return find_scalar(p, n, d);
+#if defined(__AVX2__)
+	return find_avx2(p, n, d);
+#elif defined(__SSE2__)
+	return find_sse2(p, n, d);
+#else
+	return find_scalar(p, n, d);
+#endif
+}
+
+#if CU_MULTIVERSION
+CU_TARGET_AVX2 void classify(const char* p, std::size_t n, const Delimiters& d, std::uint64_t* bits)
+{
+	if (d.size() == 0 || d.size() > Delimiters::max_simd)
+		return classify_scalar(p, n, d, bits);
+	classify_avx2(p, n, d, bits);
+}
+
+CU_TARGET_AVX2 std::size_t find(const char* p, std::size_t n, const Delimiters& d)
+{
+	if (d.size() == 0 || d.size() > Delimiters::max_simd)
+		return find_scalar(p, n, d);
+	return find_avx2(p, n, d);
+}
+#endif
+
+}
+
+std::size_t find_first_of(std::string_view str, const Delimiters& delimiters, std::size_t pos)
+{
+	if (pos >= str.size())
+		return std::string_view::npos;
+	std::size_t i = pos + find(str.data() + pos, str.size() - pos, delimiters);
+	return i < str.size() ? i : std::string_view::npos;
+}
+
+std::size_t tokenize(std::string_view str, const Delimiters& delimiters, std::vector<Token>& out)
+{
+	out.clear();
+
+	std::uint64_t	bits[chunk / block];
+	std::uint64_t	carry = 0;		// the byte before the current word is part of a token
+	std::size_t		open = 0;		// first token without its end
+
+	for (std::size_t base = 0; base < str.size(); base += chunk)
+	{
+		std::size_t n = std::min(chunk, str.size() - base);
+		classify(str.data() + base, n, delimiters, bits);
+
+		// tokens begin where the bitmap goes from delimiter to not, and end where it goes back
+		for (std::size_t w = 0; w * block < n; ++w)
+		{
+			std::uint64_t	inside = ~bits[w];
+			std::uint64_t	before = (inside << 1) | carry;
+			std::uint64_t	begins = inside & ~before;
+			std::uint64_t	ends = ~inside & before;
+			std::size_t		at = base + w * block;
+			carry = inside >> 63;
+
+			for (; begins; begins &= begins - 1)
+				out.push_back({at + static_cast<std::size_t>(std::countr_zero(begins)), 0});
+			for (; ends; ends &= ends - 1)
+				out[open++].end = at + static_cast<std::size_t>(std::countr_zero(ends));
+		}
+	}
+
+	// the bytes past the last word read as delimiters, only an input ending on a word boundary leaves one open
+	if (open < out.size())
+		out[open].end = str.size();
+	return out.size();
+}
+
+std::string_view trim(std::string_view str, const Delimiters& delimiters)
+{
+	std::size_t begin = 0;
+	std::size_t end = str.size();
+	while (begin < end && delimiters.contains(str[begin]))
+		++begin;
+	while (end > begin && delimiters.contains(str[end - 1]))
+		--end;
+	return str.substr(begin, end - begin);
+}
+
+std::size_t split_lines(std::string_view str, std::vector<Token>& out, bool trim_whitespace)
+{
+	out.clear();
+
+	std::size_t begin = 0;
+	while (begin < str.size())
+	{
+		// memchr is already vectorized, and a single byte is its best case
+		const void* found = std::memchr(str.data() + begin, '\n', str.size() - begin);
+		std::size_t next = found ? static_cast<std::size_t>(static_cast<const char*>(found) - str.data()) : str.size();
+		std::size_t end = next;
+		if (found && end > begin && str[end - 1] == '\r')
+			--end;
+
+		if (trim_whitespace)
+		{
+			std::string_view line = trim(str.substr(begin, end - begin));
+			std::size_t b = line.empty() ? begin : static_cast<std::size_t>(line.data() - str.data());
+			out.push_back({b, b + line.size()});
+		}
+		else
+			out.push_back({begin, end});
+		begin = next + 1;
+	}
+	return out.size();
+}
+
+}
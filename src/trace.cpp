@@ -0,0 +1,459 @@
+#include "trace.hpp"
+#include "cpu.hpp"
+#include "logger.hpp"
+#include "logger/internal.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace cu::trace {
+
+	namespace {
+
+		enum Phase : std::uint8_t {
+			complete_event,
+			counter_event,
+			instant_event
+		};
+
+		struct Event
+		{
+			const char		*name;
+			std::uint64_t	time;
+			union {
+				std::uint64_t	end;
+				double			value;
+			};
+			Phase			phase;
+		};
+
+		struct Block
+		{
+			explicit Block(std::size_t capacity) : events(new Event[capacity]) {}
+
+			std::unique_ptr<Event[]>	events;
+			std::atomic<std::size_t>	count{0};
+			std::atomic<Block *>		next{nullptr};
+		};
+
+		/**
+		 * Single producer (the recording thread) / single consumer (whoever holds the
+		 * state mutex) chain of blocks: the producer appends and links a new block when
+		 * one is full, the consumer frees blocks it has read completely
+		 */
+		class Buffer
+		{
+		public:
+			Buffer(std::uint32_t tid, std::size_t capacity)
+				: tid(tid), _capacity(capacity), _tail(new Block(capacity)), _head(_tail) {}
+
+			~Buffer()
+			{
+				for (Block *b = _head; b;)
+				{
+					Block *next = b->next.load(std::memory_order_relaxed);
+					delete b;
+					b = next;
+				}
+			}
+
+			Buffer(const Buffer &) = delete;
+			Buffer &operator=(const Buffer &) = delete;
+
+			void push(const Event &e)
+			{
+				std::size_t n = _tail->count.load(std::memory_order_relaxed);
+				if (n == _capacity)
+				{
+					Block *b = new Block(_capacity);
+					_tail->next.store(b, std::memory_order_release);
+					_tail = b;
+					n = 0;
+				}
+				_tail->events[n] = e;
+				_tail->count.store(n + 1, std::memory_order_release);
+			}
+
+			template <typename Fn>
+			void drain(Fn &&fn)
+			{
+				for (;;)
+				{
+					std::size_t n = _head->count.load(std::memory_order_acquire);
+					for (; _read < n; ++_read)
+						fn(_head->events[_read]);
+					if (_read < _capacity)
+						return;
+					Block *next = _head->next.load(std::memory_order_acquire);
+					if (!next)
+						return;
+					delete _head;
+					_head = next;
+					_read = 0;
+				}
+			}
+
+			const std::uint32_t	tid;
+			std::string			name;			// under the state mutex
+			bool				named = false;	// metadata event written
+			bool				done = false;	// drained after retirement, can go
+			std::atomic<bool>	retired{false};	// the thread exited, nothing more comes
+
+		private:
+			const std::size_t	_capacity;
+			Block				*_tail;			// producer
+			Block				*_head;			// consumer
+			std::size_t			_read = 0;
+		};
+
+		struct State
+		{
+			std::mutex							mutex;
+			std::vector<std::shared_ptr<Buffer>>	buffers;
+			std::FILE		*file = nullptr;
+			std::string		path;
+			std::string		out;
+			std::size_t		block_events = 4096;
+			std::uint32_t	next_tid = 0;
+			std::uint64_t	sessions = 0;
+			bool			first = true;		// no event written yet, no comma
+			bool			hooks = false;
+
+			// ticks to time: wall clock of the logger at start, plus ticks scaled by the rate measured since
+			std::int64_t							wall0 = 0;
+			std::uint64_t							ticks0 = 0;
+			std::chrono::steady_clock::time_point	steady0;
+
+			std::atomic<std::uint64_t>	session{0};
+		};
+
+		// never destroyed, threads may still record from static destructors
+		State &state()
+		{
+			static State *s = new State;
+			return *s;
+		}
+
+		/** Set once the thread's Producer is destroyed, events recorded after it are dropped */
+		thread_local bool producer_destroyed = false;
+
+		struct Producer
+		{
+			std::shared_ptr<Buffer>	buffer;
+			std::uint64_t			session = 0;
+			std::string				name;
+
+			~Producer()
+			{
+				if (buffer)
+					buffer->retired.store(true, std::memory_order_release);
+				producer_destroyed = true;
+			}
+		};
+
+		thread_local Producer producer;
+
+		bool attach(State &s, Producer &p, std::uint64_t session)
+		{
+			std::lock_guard lock(s.mutex);
+			if (s.session.load(std::memory_order_relaxed) != session)
+				return false;
+			if (p.buffer)
+				p.buffer->retired.store(true, std::memory_order_release);
+			p.buffer = std::make_shared<Buffer>(++s.next_tid, s.block_events);
+			p.buffer->name = p.name;
+			p.session = session;
+			s.buffers.push_back(p.buffer);
+			return true;
+		}
+
+		void record(const Event &e)
+		{
+			State			&s = state();
+			std::uint64_t	session = s.session.load(std::memory_order_acquire);
+			if (session == 0 || producer_destroyed)
+				return;
+			Producer &p = producer;
+			if (p.session != session && !attach(s, p, session))
+				return;
+			p.buffer->push(e);
+		}
+
+		template <typename T>
+		void append_number(std::string &out, T value)
+		{
+			char buffer[32];
+			auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+			out.append(buffer, end);
+		}
+
+		/** Nanoseconds as microseconds with three decimals, the unit of "ts" and "dur" */
+		void append_us(std::string &out, std::int64_t ns)
+		{
+			if (ns < 0)
+			{
+				out += '-';
+				ns = -ns;
+			}
+			append_number(out, ns / 1000);
+			char frac[4] = {'.', char('0' + ns / 100 % 10), char('0' + ns / 10 % 10), char('0' + ns % 10)};
+			out.append(frac, 4);
+		}
+
+		void append_string(std::string &out, const char *str)
+		{
+			out += '"';
+			for (; *str; ++str)
+			{
+				unsigned char c = static_cast<unsigned char>(*str);
+				if (c == '"' || c == '\\')
+				{
+					out += '\\';
+					out += *str;
+				}
+				else if (c < 0x20)
+				{
+					char esc[8];
+					std::snprintf(esc, sizeof(esc), "\\u%04x", c);
+					out += esc;
+				}
+				else
+					out += *str;
+			}
+			out += '"';
+		}
+
+		void begin_event(State &s, const char *name, const char *phase, std::uint32_t tid)
+		{
+			s.out += s.first ? "\n{\"name\":" : ",\n{\"name\":";
+			s.first = false;
+			append_string(s.out, name);
+			s.out += ",\"ph\":\"";
+			s.out += phase;
+			s.out += "\",\"pid\":1,\"tid\":";
+			append_number(s.out, tid);
+		}
+
+		/**
+		 * Formats every published event into the file. Ticks are scaled by the rate
+		 * measured from start() to now: every event is older than now, so the error of an
+		 * event's time stays within the jitter of one clock read
+		 */
+		void write_events(State &s)
+		{
+			std::uint64_t	ticks = detail::ticks();
+			auto			steady = std::chrono::steady_clock::now();
+			double			elapsed_ns = std::chrono::duration<double, std::nano>(steady - s.steady0).count();
+			double			scale = ticks > s.ticks0 ? elapsed_ns / static_cast<double>(ticks - s.ticks0) : 1.0;
+			// the timeline starts at start(), the absolute time is in otherData
+			auto time = [&](std::uint64_t t) { return static_cast<std::int64_t>(static_cast<double>(static_cast<std::int64_t>(t - s.ticks0)) * scale); };
+
+			for (const auto &b : s.buffers)
+			{
+				bool retired = b->retired.load(std::memory_order_acquire);
+				if (!b->named && !b->name.empty())
+				{
+					begin_event(s, "thread_name", "M", b->tid);
+					s.out += ",\"args\":{\"name\":";
+					append_string(s.out, b->name.c_str());
+					s.out += "}}";
+					b->named = true;
+				}
+
+				b->drain([&](const Event &e) {
+					switch (e.phase)
+					{
+						case complete_event:
+							begin_event(s, e.name, "X", b->tid);
+							s.out += ",\"ts\":";
+							append_us(s.out, time(e.time));
+							s.out += ",\"dur\":";
+							append_us(s.out, static_cast<std::int64_t>(static_cast<double>(e.end - e.time) * scale));
+							s.out += '}';
+							break;
+						case counter_event:
+							begin_event(s, e.name, "C", b->tid);
+							s.out += ",\"ts\":";
+							append_us(s.out, time(e.time));
+							s.out += ",\"args\":{\"value\":";
+							append_number(s.out, e.value);
+							s.out += "}}";
+							break;
+						case instant_event:
+							begin_event(s, e.name, "i", b->tid);
+							s.out += ",\"s\":\"t\",\"ts\":";
+							append_us(s.out, time(e.time));
+							s.out += '}';
+							break;
+					}
+					if (s.out.size() >= (1 << 20))
+					{
+						std::fwrite(s.out.data(), 1, s.out.size(), s.file);
+						s.out.clear();
+					}
+				});
+
+				// retired is set after the thread's last push, seen before this drain nothing is left
+				b->done = retired;
+			}
+			std::erase_if(s.buffers, [](const std::shared_ptr<Buffer> &b) { return b->done; });
+
+			std::fwrite(s.out.data(), 1, s.out.size(), s.file);
+			s.out.clear();
+		}
+
+		/** Logger writer task: streams the buffers while async logging runs */
+		void background()
+		{
+			State &s = state();
+			std::lock_guard lock(s.mutex);
+			if (s.file)
+				write_events(s);
+		}
+
+		void stop_at_exit()
+		{
+			stop();
+		}
+
+	}
+
+	void detail::complete(const char *name, std::uint64_t begin, std::uint64_t end)
+	{
+		Event e;
+		e.name = name;
+		e.time = begin;
+		e.end = end;
+		e.phase = complete_event;
+		record(e);
+	}
+
+	void detail::counter(const char *name, double value, std::uint64_t time)
+	{
+		Event e;
+		e.name = name;
+		e.time = time;
+		e.value = value;
+		e.phase = counter_event;
+		record(e);
+	}
+
+	void detail::instant(const char *name, std::uint64_t time)
+	{
+		Event e;
+		e.name = name;
+		e.time = time;
+		e.end = 0;
+		e.phase = instant_event;
+		record(e);
+	}
+
+	Result start(const Options &options)
+	{
+		State &s = state();
+		std::unique_lock lock(s.mutex);
+		if (s.file)
+			return Result::error("trace: a capture to " + s.path + " is already running");
+		if (options.block_events == 0)
+			return Result::error("trace: block_events of 0");
+
+		std::FILE *file = std::fopen(options.path.c_str(), "wb");
+		if (!file)
+			return Result::error("trace: cannot open " + options.path + ": " + std::strerror(errno));
+
+		// warned once the lock is released: an async logger blocked on a full ring waits for the
+		// writer, which may be in background() waiting for this lock
+		bool variable_tsc = false;
+	#if CU_TRACE_TSC
+		variable_tsc = !cpu::current().invariant_tsc;
+	#endif
+
+		s.file = file;
+		s.path = options.path;
+		s.block_events = options.block_events;
+		s.first = true;
+		s.out = "{\"traceEvents\":[";
+		s.wall0 = logger::detail::now();
+		s.steady0 = std::chrono::steady_clock::now();
+		s.ticks0 = detail::ticks();
+
+		if (!s.hooks)
+		{
+			s.hooks = true;
+			logger::detail::add_writer_task(background);
+			std::atexit(stop_at_exit);
+		}
+
+		s.session.store(++s.sessions, std::memory_order_release);
+		detail::active.store(true, std::memory_order_relaxed);
+		lock.unlock();
+
+		if (variable_tsc)
+			logger::warn("trace: the TSC of this CPU is not invariant, span durations follow its frequency");
+		return Result::ok();
+	}
+
+	Result stop()
+	{
+		State &s = state();
+		std::lock_guard lock(s.mutex);
+		if (!s.file)
+			return Result::ok();
+
+		detail::active.store(false, std::memory_order_relaxed);
+		s.session.store(0, std::memory_order_release);
+
+		// a span still being pushed by another thread may miss this last pass
+		write_events(s);
+		s.buffers.clear();
+
+		// the wall clock of the timeline's origin, in the logger's format
+		std::time_t	t = static_cast<std::time_t>(s.wall0 / 1000000000);
+		std::tm		tm;
+	#if defined(_WIN32)
+		localtime_s(&tm, &t);
+	#else
+		localtime_r(&t, &tm);
+	#endif
+		char		stamp[64];
+		std::size_t	n = std::strftime(stamp, sizeof(stamp), "%Y/%m/%d %H:%M:%S", &tm);
+		std::snprintf(stamp + n, sizeof(stamp) - n, ".%09lld", static_cast<long long>(s.wall0 % 1000000000));
+
+		s.out = "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"start_time\":\"";
+		s.out += stamp;
+		s.out += "\"}}\n";
+		std::fwrite(s.out.data(), 1, s.out.size(), s.file);
+		s.out.clear();
+		s.out.shrink_to_fit();
+
+		bool ok = !std::ferror(s.file);
+		ok = std::fclose(s.file) == 0 && ok;
+		s.file = nullptr;
+		if (!ok)
+			return Result::error("trace: cannot write " + s.path);
+		return Result::ok();
+	}
+
+	void thread_name(std::string name)
+	{
+		if (producer_destroyed)
+			return;
+		Producer &p = producer;
+		p.name = std::move(name);
+		if (p.buffer)
+		{
+			std::lock_guard lock(state().mutex);
+			p.buffer->name = p.name;
+			p.buffer->named = false;
+		}
+	}
+
+}
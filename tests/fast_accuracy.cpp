@@ -0,0 +1,136 @@
+/**
+ * Max relative and ulp error of every cu::math::fast function and tier against the
+ * double precision libm, over the domains documented in math/fast.hpp. Prints the
+ * table and fails when a figure exceeds the documented one
+ */
+#include "math/fast.hpp"
+
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <type_traits>
+
+namespace fast = cu::math::fast;
+using cu::math::floatx8;
+using fast::precision;
+
+namespace {
+
+struct error
+{
+	double	rel = 0.0;
+	double	ulp = 0.0;
+
+	void add(float value, double reference)
+	{
+		double diff = std::fabs(static_cast<double>(value) - reference);
+		if (reference != 0.0)
+			rel = std::fmax(rel, diff / std::fabs(reference));
+		int e = reference == 0.0 ? -126 : std::max(std::ilogb(reference), -126);
+		ulp = std::fmax(ulp, diff / std::ldexp(1.0, e - 23));
+	}
+};
+
+constexpr std::size_t samples = std::size_t(1) << 20;
+
+template <precision P>
+using tier = std::integral_constant<precision, P>;
+
+/** fn(tier, x, y) in float and floatx8 at count samples (x, y) from gen() */
+template <precision P, typename Gen, typename Fn, typename Ref>
+error measure(Gen gen, Fn fn, Ref ref, std::size_t count)
+{
+	error err;
+	alignas(32) float x[8], y[8], r[8];
+	for (std::size_t i = 0; i < count; i += 8)
+	{
+		for (int k = 0; k < 8; ++k)
+			gen(x[k], y[k]);
+		fn(tier<P>(), floatx8::load(x), floatx8::load(y)).store(r);
+		for (int k = 0; k < 8; ++k)
+		{
+			double expected = ref(static_cast<double>(x[k]), static_cast<double>(y[k]));
+			err.add(fn(tier<P>(), x[k], y[k]), expected);
+			err.add(r[k], expected);
+		}
+	}
+	return err;
+}
+
+/** One row of the table, bounds are the documented figures per tier: < 1 relative, >= 1 ulp */
+template <typename Gen, typename Fn, typename Ref>
+bool check(const char *name, Gen gen, Fn fn, Ref ref, const double (&bound)[3], std::size_t count = samples)
+{
+	const error errs[3] = {
+		measure<precision::low>(gen, fn, ref, count),
+		measure<precision::medium>(gen, fn, ref, count),
+		measure<precision::high>(gen, fn, ref, count),
+	};
+
+	bool ok = true;
+	std::printf("%-11s", name);
+	for (int t = 0; t < 3; ++t)
+	{
+		bool in_ulp = bound[t] >= 1.0;
+		double measured = in_ulp ? errs[t].ulp : errs[t].rel;
+		bool pass = measured <= bound[t];
+		ok &= pass;
+		if (in_ulp)
+			std::printf("  %8.2f ulp%s", measured, pass ? " " : "!");
+		else
+			std::printf("  %12.2e%s", measured, pass ? " " : "!");
+	}
+	std::printf("\n");
+	return ok;
+}
+
+}
+
+int main()
+{
+	std::mt19937 rng(2024);
+	auto uniform = [&](float lo, float hi) {
+		return [&rng, d = std::uniform_real_distribution<float>(lo, hi)](float &x, float &y) mutable {
+			x = d(rng);
+			y = d(rng);
+		};
+	};
+	// every float of [1, 4): the rsqrt estimate only depends on the mantissa and the
+	// exponent's parity, so two binades give the max error over all normal floats
+	auto two_binades = [bits = std::bit_cast<std::uint32_t>(1.0f)](float &x, float &) mutable {
+		x = std::bit_cast<float>(bits++);
+	};
+	const std::size_t two_binades_count = std::bit_cast<std::uint32_t>(4.0f) - std::bit_cast<std::uint32_t>(1.0f);
+	const float four_pi = 4.0f * 3.14159265f;
+
+	bool ok = true;
+	std::printf("%-11s  %13s  %13s  %13s\n", "", "low", "medium", "high");
+	ok &= check("sin", uniform(-four_pi, four_pi),
+		[](auto p, auto x, auto) { return fast::sin<p()>(x); },
+		[](double x, double) { return std::sin(x); }, {5.7e-4, 2.0e-6, 1.5});
+	ok &= check("cos", uniform(-four_pi, four_pi),
+		[](auto p, auto x, auto) { return fast::cos<p()>(x); },
+		[](double x, double) { return std::cos(x); }, {5.7e-4, 2.0e-6, 1.5});
+	ok &= check("tan", uniform(-four_pi, four_pi),
+		[](auto p, auto x, auto) { return fast::tan<p()>(x); },
+		[](double x, double) { return std::tan(x); }, {5.9e-4, 2.1e-6, 3.5});
+	ok &= check("asin", uniform(-1.0f, 1.0f),
+		[](auto p, auto x, auto) { return fast::asin<p()>(x); },
+		[](double x, double) { return std::asin(x); }, {7.6e-5, 3.7e-6, 2.4});
+	ok &= check("acos", uniform(-1.0f, 1.0f),
+		[](auto p, auto x, auto) { return fast::acos<p()>(x); },
+		[](double x, double) { return std::acos(x); }, {7.6e-5, 3.7e-6, 2.4});
+	ok &= check("atan", uniform(-1e4f, 1e4f),
+		[](auto p, auto x, auto) { return fast::atan<p()>(x); },
+		[](double x, double) { return std::atan(x); }, {1.6e-3, 4.6e-6, 3.8});
+	ok &= check("atan2", uniform(-1e4f, 1e4f),
+		[](auto p, auto y, auto x) { return fast::atan2<p()>(y, x); },
+		[](double y, double x) { return std::atan2(y, x); }, {1.6e-3, 4.6e-6, 3.8});
+	ok &= check("rsqrt", two_binades,
+		[](auto p, auto x, auto) { return fast::rsqrt<p()>(x); },
+		[](double x, double) { return 1.0 / std::sqrt(x); }, {3.3e-4, 4.0, 4.0}, two_binades_count);
+
+	return ok ? 0 : 1;
+}
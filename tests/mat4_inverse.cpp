@@ -0,0 +1,116 @@
+/**
+ * mat4 inverse(), affine_inverse() and trs_inverse() against the double precision
+ * inverse of the same matrix, over random TRS, affine and general matrices in both
+ * translation layouts. Prints the max error in units of cond(M) * FLT_EPSILON and
+ * fails above the figure documented in math/mat.hpp
+ */
+#include "math/mat.hpp"
+#include "math/quat.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+
+using cu::math::mat4;
+using cu::math::quat;
+using dmat4 = cu::math::mat<double, 4, 4>;
+
+namespace {
+
+constexpr double bound = 2.0;
+constexpr int samples = 1 << 16;
+
+double norm_inf(const dmat4& a)
+{
+	double n = 0.0;
+	for (int i = 0; i < 4; ++i)
+		n = std::max(n, std::fabs(a.m[i][0]) + std::fabs(a.m[i][1]) + std::fabs(a.m[i][2]) + std::fabs(a.m[i][3]));
+	return n;
+}
+
+/** Max element error of r relative to the largest element of the reference, over cond(a) * FLT_EPSILON */
+double error(const mat4& a, const mat4& r)
+{
+	dmat4 d(a);
+	dmat4 ref = d.inverse();
+	double diff = 0.0, largest = 0.0;
+	for (int i = 0; i < 4; ++i)
+		for (int j = 0; j < 4; ++j)
+		{
+			diff = std::max(diff, std::fabs(r.m[i][j] - ref.m[i][j]));
+			largest = std::max(largest, std::fabs(ref.m[i][j]));
+		}
+	double cond = norm_inf(d) * norm_inf(ref);
+	return diff / largest / (cond * std::numeric_limits<float>::epsilon());
+}
+
+/** Max error of inv(m) over samples matrices from gen(), both as generated and transposed */
+template <typename Gen, typename Inv>
+bool check(const char* name, Gen gen, Inv inv)
+{
+	double worst = 0.0;
+	for (int n = 0; n < samples; ++n)
+	{
+		mat4 a = gen();
+		mat4 at = a.transpose();
+		worst = std::max({worst, error(a, inv(a)), error(at, inv(at))});
+	}
+	bool pass = worst <= bound;
+	std::printf("%-24s %6.3f%s\n", name, worst, pass ? "" : " !");
+	return pass;
+}
+
+}
+
+int main()
+{
+	std::mt19937 rng(2024);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> log_scale(-2.0f, 2.0f);
+
+	// rotation from a random quaternion, axes scaled by 1/4 to 4, translation in m[3]
+	auto trs = [&] {
+		mat4 a = quat(unit(rng), unit(rng), unit(rng), unit(rng)).toMatrix();
+		for (int i = 0; i < 3; ++i)
+		{
+			float s = std::exp2(log_scale(rng));
+			for (int j = 0; j < 3; ++j)
+				a.m[i][j] *= s;
+		}
+		float reach = rng() & 1 ? 100.0f : 1.0f;
+		for (int j = 0; j < 3; ++j)
+			a.m[3][j] = unit(rng) * reach;
+		return a;
+	};
+	auto affine = [&] {
+		mat4 a(1.0f);
+		for (int i = 0; i < 4; ++i)
+			for (int j = 0; j < 3; ++j)
+				a.m[i][j] = unit(rng) * (i == 3 ? 10.0f : 1.0f);
+		return a;
+	};
+	auto general = [&] {
+		mat4 a;
+		for (int i = 0; i < 4; ++i)
+			for (int j = 0; j < 4; ++j)
+				a.m[i][j] = unit(rng);
+		return a;
+	};
+
+	auto inverse = [](const mat4& a) { return a.inverse(); };
+	auto affine_inverse = [](const mat4& a) { return a.affine_inverse(); };
+	auto trs_inverse = [](const mat4& a) { return a.trs_inverse(); };
+
+	bool ok = true;
+	std::printf("%-24s %6s (cond * eps, bound %.1f)\n", "", "error", bound);
+	ok &= check("trs trs_inverse", trs, trs_inverse);
+	ok &= check("trs affine_inverse", trs, affine_inverse);
+	ok &= check("trs inverse", trs, inverse);
+	ok &= check("affine affine_inverse", affine, affine_inverse);
+	ok &= check("affine inverse", affine, inverse);
+	ok &= check("general inverse", general, inverse);
+
+	return ok ? 0 : 1;
+}
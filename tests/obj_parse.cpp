@@ -0,0 +1,71 @@
+/**
+ * parse_obj() on small hand-written files: index resolution, missing attributes and
+ * the errors for indices out of range, each with one and with several chunks
+ */
+#include "scene/mesh.hpp"
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using cu::scene::Mesh;
+
+namespace {
+
+int failures = 0;
+
+void expect(bool ok, const char *what, std::size_t chunk_size)
+{
+	if (!ok)
+	{
+		++failures;
+		std::printf("FAIL %s (chunk_size %zu)\n", what, chunk_size);
+	}
+}
+
+/** Parses text with every chunk size, all of them must fail with message */
+void expect_error(std::string_view text, std::string_view message, const char *what)
+{
+	for (std::size_t chunk_size : {std::size_t(1), std::size_t(1) << 20})
+	{
+		Mesh mesh;
+		Result r = cu::scene::parse_obj(text, mesh, {false, chunk_size});
+		expect(!r.isOk() && r.message == message, what, chunk_size);
+		if (r.isOk() || r.message != message)
+			std::printf("     got \"%s\"\n", r.message.c_str());
+	}
+}
+
+}
+
+int main()
+{
+	const std::string triangle = "v 0 0 0\nv 1 0 0\nv 0 1 0\n";
+
+	for (std::size_t chunk_size : {std::size_t(1), std::size_t(1) << 20})
+	{
+		const cu::scene::ObjOptions options{false, chunk_size};
+
+		Mesh mesh;
+		Result r = cu::scene::parse_obj(triangle + "vt 0 0\nvt 1 0\nf -3/1 -2/-1 -1\n", mesh, options);
+		expect(r.isOk() && mesh.indices == std::vector<std::uint32_t>{0, 1, 2}, "relative positions", chunk_size);
+		expect(mesh.texcoord_indices == std::vector<std::uint32_t>{0, 1, Mesh::no_index}, "texcoords, missing one is no_index", chunk_size);
+		expect(mesh.normal_indices.empty(), "no normals", chunk_size);
+
+		r = cu::scene::parse_obj(triangle + "v 1 1 0\nf 1 2 3 4\n", mesh, options);
+		expect(r.isOk() && mesh.indices == std::vector<std::uint32_t>{0, 1, 2, 0, 2, 3}, "quad fan", chunk_size);
+	}
+
+	// relative texcoord / normal indices before the first one wrap to no_index itself
+	expect_error(triangle + "f 1/-1 2/-1 3/-1\n", "OBJ: line 4: face index out of range", "relative texcoord below zero");
+	expect_error(triangle + "f 1//-1 2//-1 3//-1\n", "OBJ: line 4: face index out of range", "relative normal below zero");
+	expect_error(triangle + "vt 0 0\nf 1/1 2/2 3/1\n", "OBJ: line 5: face index out of range", "texcoord past the end");
+	expect_error(triangle + "f 1 2 4\n", "OBJ: line 4: face index out of range", "position past the end");
+	expect_error(triangle + "f 1 2 -4\n", "OBJ: line 4: face index out of range", "relative position below zero");
+	expect_error(triangle + "f 1 2 4294967296\n", "OBJ: line 4: bad face index", "index past 2^32");
+
+	if (failures == 0)
+		std::printf("obj_parse: all passed\n");
+	return failures == 0 ? 0 : 1;
+}